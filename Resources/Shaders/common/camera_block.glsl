@@ -0,0 +1,6 @@
+// Bindings match the ones in common.h
+layout (std140, binding = 0) uniform CameraBlock
+{
+    mat4 gVP;
+    vec3 gViewPos;
+};
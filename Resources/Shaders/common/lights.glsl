@@ -0,0 +1,19 @@
+struct Light
+{
+    vec3 _color;
+    float _intensity;
+};
+
+struct Attenuation
+{
+    float _constant;
+    float _linear;
+    float _quadratic;
+};
+
+struct PointLight
+{
+    struct Light _light;
+    vec3 _position;
+    Attenuation _attenuation;
+};
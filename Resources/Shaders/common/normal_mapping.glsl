@@ -0,0 +1,6 @@
+vec3 sampleTangentSpaceNormal(sampler2D normalMap, vec2 texCoords)
+{
+    // Z is rebuilt, BC5 normal maps only store X and Y
+    vec2 xy = texture(normalMap, texCoords).xy * 2.0f - 1.0f;
+    return vec3(xy, sqrt(max(1.0f - dot(xy, xy), 0.0f)));
+}
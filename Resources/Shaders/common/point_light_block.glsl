@@ -0,0 +1,6 @@
+#include "lights.glsl"
+
+layout (std140, binding = 1) uniform PointLightBlock
+{
+    PointLight gPointLight;
+};
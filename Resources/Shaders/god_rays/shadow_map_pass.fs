@@ -1,9 +1,8 @@
 #version 460 core
-layout (location = 0) out vec3 ShadowMap;
 
 in vec2 TexCoords;
 
+// Only the depth buffer is written
 void main()
 {
-    ShadowMap.x = gl_FragCoord.z;
 }
@@ -1,6 +1,11 @@
 #version 460 core
 out vec4 FragColor;
 
+// Specialized by the application, the render mode picks a lighting term to show on its own or the Blinn-Phong look
+#ifndef RENDER_MODE
+#define RENDER_MODE 0
+#endif
+
 const float PRIMARY_SHIFT = -1.0f;
 const float SECONDARY_SHIFT = 1.5f;
 const float PRIMARY_SPECULAR_EXP = 1.0f;
@@ -27,7 +32,6 @@ uniform vec3 gViewPos;
 uniform vec3 gLightColor;
 uniform float gAmbientFactor;
 uniform float gSpecularFactor;
-uniform int gRenderMode;
 
 const vec3 T = normalize(dFdx(fs_in.WorldPos) * dFdy(fs_in.TexCoords).t - dFdy(fs_in.WorldPos) * dFdx(fs_in.TexCoords).t);
 vec3 calcWorldSpaceNormal(vec3 tangentSpaceNormal)
@@ -37,7 +41,10 @@ vec3 calcWorldSpaceNormal(vec3 tangentSpaceNormal)
     mat3 TBN = mat3(T, B, N);
     return normalize(TBN * tangentSpaceNormal);
 }
-const vec3 TANGENT_SPACE_N = texture(gNormalMap, fs_in.TexCoords).xyz * 2.0f - 1.0f;
+
+#include "../common/normal_mapping.glsl"
+
+const vec3 TANGENT_SPACE_N = sampleTangentSpaceNormal(gNormalMap, fs_in.TexCoords);
 const vec3 N = calcWorldSpaceNormal(TANGENT_SPACE_N);
 const vec3 L = normalize(gLightPos - fs_in.WorldPos);
 
@@ -67,40 +74,27 @@ vec4 calcHairColor()
 
     vec3 diffuse = clamp(mix(0.25f, 1.0f, dot(N, L)), 0.0f, 1.0f) * DIFFUSE_COLOR * gLightColor;
 
-    vec3 specular1 = texture(gSpecularMap, fs_in.TexCoords).rgb * calcStrandSpecularLighting(t1, PRIMARY_SPECULAR_EXP) * gLightColor;
+    vec3 specular1 = texture(gSpecularMap, fs_in.TexCoords).r * calcStrandSpecularLighting(t1, PRIMARY_SPECULAR_EXP) * gLightColor;
 
     float mask = texture(gNoiseTexture, fs_in.TexCoords).r;
     vec3 specular2 = SECONDARY_SPECULAR_COLOR * calcStrandSpecularLighting(t2, SECONDARY_SPECULAR_EXP) * gLightColor;
 
     vec4 hairColor;
     hairColor.a = texture(gAlphaTexture, fs_in.TexCoords).r;
-    if (gRenderMode == 2)
-    {
-        hairColor.rgb = diffuse * color;
-        return hairColor;
-    }
-    else if (gRenderMode == 3)
-    {
-        hairColor.rgb = specular1 * color;
-        return hairColor;
-    }
-    else if (gRenderMode == 4)
-    {
-        hairColor.rgb = specular2 * color;
-        return hairColor;
-    }
-    else if (gRenderMode == 5)
-    {
-        hairColor.rgb = (specular1 + mask * specular2) * color;
-        return hairColor;
-    }
-    else if (gRenderMode == 6)
-    {
-        hairColor.rgb = vec3(texture(gAOMap, fs_in.TexCoords).r);
-        return hairColor;
-    }
+#if RENDER_MODE == 2
+    hairColor.rgb = diffuse * color;
+#elif RENDER_MODE == 3
+    hairColor.rgb = specular1 * color;
+#elif RENDER_MODE == 4
+    hairColor.rgb = specular2 * color;
+#elif RENDER_MODE == 5
+    hairColor.rgb = (specular1 + mask * specular2) * color;
+#elif RENDER_MODE == 6
+    hairColor.rgb = vec3(texture(gAOMap, fs_in.TexCoords).r);
+#else
     hairColor.rgb = (ambient + diffuse + specular1 + mask * specular2) * color;
     hairColor.rgb *= texture(gAOMap, fs_in.TexCoords).r;
+#endif
     return hairColor;
 }
 
@@ -114,17 +108,16 @@ vec4 calcBlinnPhongColor()
 
     vec3 V = normalize(gViewPos - fs_in.WorldPos);
     vec3 H = normalize(L + V);
-    vec3 specular = texture(gSpecularMap, fs_in.TexCoords).rgb * pow(clamp(dot(N, H), 0.0f, 1.0f), gSpecularFactor) * gLightColor;
+    vec3 specular = texture(gSpecularMap, fs_in.TexCoords).r * pow(clamp(dot(N, H), 0.0f, 1.0f), gSpecularFactor) * gLightColor;
 
     return vec4((ambient + diffuse + specular) * color, 1.0f);
 }
 
 void main()
 {
-    if (gRenderMode == 7)
-    {
-        FragColor = calcBlinnPhongColor();
-        return;
-    }
+#if RENDER_MODE == 7
+    FragColor = calcBlinnPhongColor();
+#else
     FragColor = calcHairColor();
+#endif
 }
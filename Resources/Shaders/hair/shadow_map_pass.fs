@@ -1,7 +1,6 @@
 #version 460 core
-layout (location = 0) out vec3 Depth;
 
+// Only the depth buffer is written
 void main()
 {
-    Depth.r = gl_FragCoord.z;
 }
@@ -6,39 +6,7 @@ const uint NUM_SAMPLES = 1024;
 
 in vec2 TexCoords;
 
-float radicalInverse_VdC(uint bits) {
-    bits = (bits << 16u) | (bits >> 16u);
-    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
-    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
-    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
-    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
-    return float(bits) * 2.3283064365386963e-10;
-}
-
-vec2 hammersley(uint i, uint N) {
-    return vec2(float(i) / float(N), radicalInverse_VdC(i));
-}
-
-vec3 importanceSampleGGX(vec2 Xi, float roughness, vec3 N)
-{
-    float a = roughness * roughness;
-
-    float phi = 2.0f * PI * Xi.x;
-    float cosTheta = sqrt((1.0f - Xi.y) / (1.0f + (a * a - 1.0f) * Xi.y));
-    float sinTheta = sqrt(1.0f - cosTheta * cosTheta);
-
-    // Spherical polar angles to a point on the unit sphere, which will represent our half vector
-    vec3 H;
-    H.x = sinTheta * cos(phi);
-    H.y = sinTheta * sin(phi);
-    H.z = cosTheta;
-
-    vec3 upVector = abs(N.z) < 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
-    vec3 tangentX = normalize(cross(upVector, N));
-    vec3 tangentY = cross(N, tangentX);
-    // Tangent to world space
-    return tangentX * H.x + tangentY * H.y + N * H.z;
-}
+#include "../common/importance_sampling.glsl"
 
 float G_Schlick(float roughness, float NoV)
 {
@@ -150,6 +150,8 @@ vec3 IBL(vec3 N, vec3 V, vec3 R, vec3 F0, vec3 albedo, float metallic, float rou
     return (k_diff * diffuseColor + specularColor) * ao;
 }
 
+#include "../common/normal_mapping.glsl"
+
 void main()
 {
     vec3 albedo = pow(texture(gAlbedoMap, fs_in.TexCoords).rgb, vec3(2.2f));
@@ -157,7 +159,7 @@ void main()
     float roughness = texture(gRoughnessMap, fs_in.TexCoords).r;
     float ao = texture(gAOMap, fs_in.TexCoords).r;
 
-    vec3 tangentSpaceNormal = texture(gNormalMap, fs_in.TexCoords).xyz * 2.0f - 1.0f;
+    vec3 tangentSpaceNormal = sampleTangentSpaceNormal(gNormalMap, fs_in.TexCoords);
     vec3 N = calcWorldSpaceNormal(tangentSpaceNormal);
     vec3 V = normalize(gViewPos - fs_in.WorldPos);
     vec3 R = reflect(-V, N);
@@ -1,6 +1,11 @@
 #version 460 core
 out vec4 FragColor;
 
+// Specialized by the application, render mode 3 shows the spherical harmonics irradiance instead of the cubemap
+#ifndef RENDER_MODE
+#define RENDER_MODE 0
+#endif
+
 const float PI = 3.14159265359f;
 // Cosine lobe convolution factors
 const float A0 = PI;
@@ -10,7 +15,6 @@ const float A2 = 0.785398f;
 in vec3 WorldPos;
 
 uniform samplerCube gEnvMap;
-uniform int gRenderMode;
 uniform vec3 gSH9Color[9];
 
 vec3 calcSHIrradiance(vec3 N)
@@ -29,16 +33,11 @@ vec3 calcSHIrradiance(vec3 N)
 
 void main()
 {		
-    vec3 fragColor;
-
-    if (gRenderMode == 3)
-    {
-        fragColor = calcSHIrradiance(WorldPos) / PI;
-    }
-    else
-    {
-        fragColor = textureLod(gEnvMap, WorldPos, 0.0f).rgb;
-    }
+#if RENDER_MODE == 3
+    vec3 fragColor = calcSHIrradiance(WorldPos) / PI;
+#else
+    vec3 fragColor = textureLod(gEnvMap, WorldPos, 0.0f).rgb;
+#endif
 
     // Tone mapping and gamma correction
     fragColor = fragColor / (fragColor + vec3(1.0f));
@@ -4,25 +4,7 @@ layout (location = 3) out vec4 FragColor;
 const float SPECULAR_FACTOR = 16.0f;
 const int NUM_LIGHTS = 32;
 
-struct Light
-{
-    vec3 _color;
-    float _intensity;
-};
-
-struct Attenuation
-{
-    float _constant;
-    float _linear;
-    float _quadratic;
-};
-
-struct PointLight
-{
-    struct Light _light;
-    vec3 _position;
-    Attenuation _attenuation;
-};
+#include "../common/lights.glsl"
 
 in vec2 TexCoords;
 
@@ -30,7 +12,11 @@ uniform sampler2D gPositionMap;
 uniform sampler2D gNormalMap;
 uniform sampler2D gAlbedoSpecularMap;
 
-uniform PointLight gPointLights[NUM_LIGHTS];
+// Binding matches LIGHT_BLOCK_BINDING in common.h
+layout (std140, binding = 1) uniform PointLightsBlock
+{
+    PointLight gPointLights[NUM_LIGHTS];
+};
 uniform vec3 gViewPos;
 uniform mat4 gInverseViewMatrix;
 
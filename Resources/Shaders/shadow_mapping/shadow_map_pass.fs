@@ -2,7 +2,6 @@
 layout (location = 0) out vec3 Position;
 layout (location = 1) out vec3 Normal;
 layout (location = 2) out vec3 Flux;
-layout (location = 3) out float Depth;
 
 const vec3 LIGHT_COLOR = vec3(0.3f);
 
@@ -17,5 +16,4 @@ void main()
     Position = WorldPos;
     Normal = normalize(WorldNormal);
     Flux = texture(gDiffuseTexture, TexCoords).rgb * LIGHT_COLOR;
-    Depth = gl_FragCoord.z;
 }
@@ -1,5 +1,5 @@
 #version 460 core
-layout (location = 1) out vec4 BlurredStretchMap;
+layout (location = 0) out vec4 BlurredStretchMap;
 
 const float GAUSS_WIDTH = 15.0f;
 
@@ -1,5 +1,5 @@
 #version 460 core
-layout (location = 1) out vec4 BlurredIrradianceMap;
+layout (location = 0) out vec4 BlurredIrradianceMap;
 
 const float GAUSS_WIDTH = 15.0f;
 
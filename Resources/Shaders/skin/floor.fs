@@ -5,71 +5,7 @@ const float NEAR = 0.1f;
 const float KERNEL_SIZE = 143.36f;
 const int NUM_SAMPLES = 64;
 const int CORRECTION_FACTOR = 100;
-const vec2 POISSON_DISK[NUM_SAMPLES] = vec2[]
-    (vec2(-0.613392f, 0.617481f),
-     vec2(0.170019f, -0.040254f),
-     vec2(-0.299417f, 0.791925f),
-     vec2(0.645680f, 0.493210f),
-     vec2(-0.651784f, 0.717887f),
-     vec2(0.421003f, 0.027070f),
-     vec2(-0.817194f, -0.271096f),
-     vec2(-0.705374f, -0.668203f),
-     vec2(0.977050f, -0.108615f),
-     vec2(0.063326f, 0.142369f),
-     vec2(0.203528f, 0.214331f),
-     vec2(-0.667531f, 0.326090f),
-     vec2(-0.098422f, -0.295755f),
-     vec2(-0.885922f, 0.215369f),
-     vec2(0.566637f, 0.605213f),
-     vec2(0.039766f, -0.396100f),
-     vec2(0.751946f, 0.453352f),
-     vec2(0.078707f, -0.715323f),
-     vec2(-0.075838f, -0.529344f),
-     vec2(0.724479f, -0.580798f),
-     vec2(0.222999f, -0.215125f),
-     vec2(-0.467574f, -0.405438f),
-     vec2(-0.248268f, -0.814753f),
-     vec2(0.354411f, -0.887570f),
-     vec2(0.175817f, 0.382366f),
-     vec2(0.487472f, -0.063082f),
-     vec2(-0.084078f, 0.898312f),
-     vec2(0.488876f, -0.783441f),
-     vec2(0.470016f, 0.217933f),
-     vec2(-0.696890f, -0.549791f),
-     vec2(-0.149693f, 0.605762f),
-     vec2(0.034211f, 0.979980f),
-     vec2(0.503098f, -0.308878f),
-     vec2(-0.016205f, -0.872921f),
-     vec2(0.385784f, -0.393902f),
-     vec2(-0.146886f, -0.859249f),
-     vec2(0.643361f, 0.164098f),
-     vec2(0.634388f, -0.049471f),
-     vec2(-0.688894f, 0.007843f),
-     vec2(0.464034f, -0.188818f),
-     vec2(-0.440840f, 0.137486f),
-     vec2(0.364483f, 0.511704f),
-     vec2(0.034028f, 0.325968f),
-     vec2(0.099094f, -0.308023f),
-     vec2(0.693960f, -0.366253f),
-     vec2(0.678884f, -0.204688f),
-     vec2(0.001801f, 0.780328f),
-     vec2(0.145177f, -0.898984f),
-     vec2(0.062655f, -0.611866f),
-     vec2(0.315226f, -0.604297f),
-     vec2(-0.780145f, 0.486251f),
-     vec2(-0.371868f, 0.882138f),
-     vec2(0.200476f, 0.494430f),
-     vec2(-0.494552f, -0.711051f),
-     vec2(0.612476f, 0.705252f),
-     vec2(-0.578845f, -0.768792f),
-     vec2(-0.772454f, -0.090976f),
-     vec2(0.504440f, 0.372295f),
-     vec2(0.155736f, 0.065157f),
-     vec2(0.391522f, 0.849605f),
-     vec2(-0.620106f, -0.328104f),
-     vec2(0.789239f, -0.419965f),
-     vec2(-0.545396f, 0.538133f),
-     vec2(-0.178564f, -0.596057f));
+#include "../common/poisson_disk.glsl"
 
 in VS_OUT {
     vec3 WorldPos;
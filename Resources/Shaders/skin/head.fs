@@ -1,6 +1,11 @@
 #version 460 core
 out vec4 FragColor;
 
+// Specialized by the application, render mode 7 swaps the skin shading for plain Blinn-Phong
+#ifndef RENDER_MODE
+#define RENDER_MODE 0
+#endif
+
 const float MIX = 0.5f;
 const float SPECULAR_CORRECTION_FACTOR = 50.0f;
 const float DIFFUSE_CORRECTION_FACTOR = 1.4f;
@@ -33,7 +38,6 @@ uniform vec3 gViewPos;
 uniform vec3 gLightColor;
 uniform float gAmbientFactor;
 uniform float gSpecularFactor;
-uniform int gRenderMode;
 
 const vec3 T = normalize(dFdx(fs_in.WorldPos) * dFdy(fs_in.TexCoords).t - dFdy(fs_in.WorldPos) * dFdx(fs_in.TexCoords).t);
 vec3 calcWorldSpaceNormal(vec3 tangentSpaceNormal)
@@ -43,7 +47,10 @@ vec3 calcWorldSpaceNormal(vec3 tangentSpaceNormal)
     mat3 TBN = mat3(T, B, N);
     return normalize(TBN * tangentSpaceNormal);
 }
-const vec3 TANGENT_SPACE_N = texture(gNormalMap, fs_in.TexCoords).xyz * 2.0f - 1.0f;
+
+#include "../common/normal_mapping.glsl"
+
+const vec3 TANGENT_SPACE_N = sampleTangentSpaceNormal(gNormalMap, fs_in.TexCoords);
 const vec3 N = calcWorldSpaceNormal(TANGENT_SPACE_N);
 const vec3 L = normalize(gLightPos - fs_in.WorldPos);
 const vec3 V = normalize(gViewPos - fs_in.WorldPos);
@@ -146,10 +153,9 @@ vec4 calcBlinnPhongColor()
 
 void main()
 {
-    if (gRenderMode == 7)
-    {
-        FragColor = calcBlinnPhongColor();
-        return;
-    }
+#if RENDER_MODE == 7
+    FragColor = calcBlinnPhongColor();
+#else
     FragColor = finalSkinShader();
+#endif
 }
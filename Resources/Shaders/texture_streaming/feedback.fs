@@ -0,0 +1,14 @@
+#version 460 core
+layout (location = 0) out uvec2 Feedback;
+
+in vec2 TexCoords;
+
+uniform int gFeedbackID;
+
+void main()
+{
+    // Log2 of the UV footprint of the pixel, the CPU turns it into a mip level per texture size
+    vec2 dx = dFdx(TexCoords);
+    vec2 dy = dFdy(TexCoords);
+    Feedback = uvec2(gFeedbackID, floatBitsToUint(0.5f * log2(max(dot(dx, dx), dot(dy, dy)))));
+}
@@ -0,0 +1,13 @@
+#version 460 core
+layout (location = 0) in vec3 gPos;
+layout (location = 1) in vec2 gTexCoords;
+
+out vec2 TexCoords;
+
+uniform mat4 gWVP;
+
+void main()
+{
+    TexCoords = gTexCoords;
+    gl_Position = gWVP * vec4(gPos, 1.0f);
+}
@@ -0,0 +1,9 @@
+struct Material
+{
+    vec3 _diffuseColor;
+    vec3 _specularColor;
+    float _specularReflectivity;
+    float _diffuseReflectivity;
+    float _emissivity;
+    float _aperture;
+};
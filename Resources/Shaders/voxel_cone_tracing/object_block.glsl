@@ -0,0 +1,9 @@
+#include "material.glsl"
+
+// Written once per mesh per pass and bound by range for its draw
+layout (std140, binding = 2) uniform ObjectBlock
+{
+    mat4 gWorldMatrix;
+    mat3 gNormalMatrix;
+    Material gMaterial;
+};
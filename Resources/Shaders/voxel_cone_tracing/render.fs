@@ -4,46 +4,25 @@ out vec4 FragColor;
 const float DIRECT_DIFFUSE_CORRECTION_FACTOR = 1.0f / 3.0f;
 const float PI = 3.14159f;
 const float VOXEL_OFFSET_CORRECTION_FACTOR = 1.732f; // sqrt(3.0f)
-const float VOXEL_SIZE = 1.0f / 64.0f;
 const float LIGHT_RADIUS = 3.0f;
-const int NUM_STEPS = 200;
 
-struct Light
-{
-    vec3 _color;
-    float _intensity;
-};
+// Specialized by the application to match its voxel grid and quality
+#ifndef VOXEL_RES
+#define VOXEL_RES 64
+#endif
+#ifndef NUM_STEPS
+#define NUM_STEPS 200
+#endif
 
-struct Attenuation
-{
-    float _constant;
-    float _linear;
-    float _quadratic;
-};
+const float VOXEL_SIZE = 1.0f / float(VOXEL_RES);
 
-struct PointLight
-{
-    struct Light _light;
-    vec3 _position;
-    Attenuation _attenuation;
-};
-
-struct Material
-{
-    vec3 _diffuseColor;
-    vec3 _specularColor;
-    float _specularReflectivity;
-    float _diffuseReflectivity;
-    float _emissivity;
-    float _aperture;
-};
+#include "../common/camera_block.glsl"
+#include "../common/point_light_block.glsl"
+#include "object_block.glsl"
 
 in vec3 WorldPos;
 in vec3 WorldNormal;
 
-uniform Material gMaterial;
-uniform PointLight gPointLight;
-uniform vec3 gViewPos;
 uniform sampler3D gTexture3D;
 
 const vec3 N = normalize(WorldNormal);
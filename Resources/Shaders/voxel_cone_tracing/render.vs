@@ -5,9 +5,8 @@ layout (location = 2) in vec3 gNormal;
 out vec3 WorldPos;
 out vec3 WorldNormal;
 
-uniform mat4 gWorldMatrix;
-uniform mat4 gVP;
-uniform mat3 gNormalMatrix;
+#include "../common/camera_block.glsl"
+#include "object_block.glsl"
 
 void main()
 {
@@ -8,7 +8,8 @@ in vec2 TexCoords;
 uniform sampler2D gBackfaceTexture;
 uniform sampler2D gFrontfaceTexture;
 uniform sampler3D gTexture3D;
-uniform vec3 gViewPos;
+
+#include "../common/camera_block.glsl"
 
 bool isInsideUnitCube()
 {
@@ -1,39 +1,10 @@
 #version 460 core
-struct Light
-{
-    vec3 _color;
-    float _intensity;
-};
-
-struct Attenuation
-{
-    float _constant;
-    float _linear;
-    float _quadratic;
-};
-
-struct PointLight
-{
-    struct Light _light;
-    vec3 _position;
-    Attenuation _attenuation;
-};
-
-struct Material
-{
-    vec3 _diffuseColor;
-    vec3 _specularColor;
-    float _specularReflectivity;
-    float _diffuseReflectivity;
-    float _emissivity;
-};
+#include "../common/point_light_block.glsl"
+#include "object_block.glsl"
 
 in vec3 WorldPos;
 in vec3 WorldNormal;
 
-uniform Material gMaterial;
-uniform PointLight gPointLight;
-uniform vec3 gViewPos;
 layout (RGBA8) uniform image3D gTexture3D;
 
 float calcAttenuation(float distance)
@@ -2,8 +2,7 @@
 layout (location = 0) in vec3 gPos;
 layout (location = 2) in vec3 gNormal;
 
-uniform mat4 gWorldMatrix;
-uniform mat3 gNormalMatrix;
+#include "object_block.glsl"
 
 out vec3 WorldPosGS;
 out vec3 WorldNormalGS;
@@ -3,8 +3,9 @@ layout (location = 0) in vec3 gPos;
 
 out vec3 WorldPos;
 
+#include "../common/camera_block.glsl"
+
 uniform mat4 gWorldMatrix;
-uniform mat4 gVP;
 
 void main()
 {
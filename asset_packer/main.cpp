@@ -0,0 +1,167 @@
+#include <engine/asset_archive.h>
+#include <engine/mesh_cache.h>
+#include <engine/texture_cooker.h>
+#include <engine/environment_map.h>
+#include <engine/common.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+// Packs shader sources and every up to date cooked mesh and texture under the resources directory into one archive.
+// Cooked files are written by the demos on their first run, so run the ones to be shipped before packing. HDR
+// environments need no GL context to be converted, so those are baked here if they haven't been yet.
+// Usage: asset_packer [resources directory] [archive]
+
+void listFiles(const std::string&, const std::string&, std::vector<std::string>&);
+bool endsWith(const std::string&, const std::string&);
+bool isUpToDate(const std::string&);
+
+int main(int argc, char** argv)
+{
+	const std::string resourcesDirectory = argc > 1 ? argv[1] : "../Resources";
+	const std::string archivePath = argc > 2 ? argv[2] : resourcesDirectory + "/assets.pxpk";
+	auto packStart = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::string> files;
+	listFiles(resourcesDirectory, "", files);
+	std::vector<std::string> packed;
+	size_t numShaders = 0, numMeshes = 0, numTextures = 0, numEnvironments = 0, numStale = 0;
+	for (const auto& file : files)
+	{
+		if (file.compare(0, 8, "Shaders/") == 0)
+		{
+			packed.push_back(file);
+			++numShaders;
+		}
+		else if (endsWith(file, ".pxmc") || endsWith(file, ".pxtc"))
+		{
+			if (!isUpToDate(resourcesDirectory + "/" + file))
+			{
+				std::cout << "Skipping stale " << file << "\n";
+				++numStale;
+				continue;
+			}
+			packed.push_back(file);
+			++(endsWith(file, ".pxmc") ? numMeshes : numTextures);
+		}
+		else if (endsWith(file, ".hdr"))
+		{
+			const std::string source = resourcesDirectory + "/" + file;
+			if (!phoenix::EnvironmentMap(source, phoenix::ENVIRONMENT_MAP_RESOLUTION).isValid())
+			{
+				std::cout << "Baking " << file << "\n";
+				if (!phoenix::EnvironmentMap::cook(source, phoenix::ENVIRONMENT_MAP_RESOLUTION))
+				{
+					continue;
+				}
+			}
+			packed.push_back(phoenix::EnvironmentMap::getCachePath(file));
+			++numEnvironments;
+		}
+	}
+
+	if (!phoenix::AssetArchive::write(archivePath, resourcesDirectory, packed))
+	{
+		return -1;
+	}
+	phoenix::AssetArchive archive(archivePath);
+	if (!archive.isOpen() || !archive.verify())
+	{
+		std::cerr << "Verification of " << archivePath << " failed!\n";
+		return -1;
+	}
+	std::cout << "Packed " << numShaders << " shaders, " << numMeshes << " meshes, " << numTextures << " textures and " << numEnvironments << " environment maps into "
+		<< archivePath << " in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - packStart).count() << " ms, skipped " << numStale << " stale files\n";
+	return 0;
+}
+
+// Paths relative to the root, with forward slashes
+void listFiles(const std::string& root, const std::string& directory, std::vector<std::string>& files)
+{
+	const std::string path = directory.empty() ? root : root + "/" + directory;
+	const std::string prefix = directory.empty() ? "" : directory + "/";
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((path + "/*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	do
+	{
+		const std::string name = data.cFileName;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			listFiles(root, prefix + name, files);
+		}
+		else if (data.nFileSizeLow || data.nFileSizeHigh)
+		{
+			files.push_back(prefix + name);
+		}
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* dir = opendir(path.c_str());
+	if (!dir)
+	{
+		return;
+	}
+	while (dirent* entry = readdir(dir))
+	{
+		const std::string name = entry->d_name;
+		struct stat info;
+		if (name == "." || name == ".." || stat((path + "/" + name).c_str(), &info) != 0)
+		{
+			continue;
+		}
+		if (S_ISDIR(info.st_mode))
+		{
+			listFiles(root, prefix + name, files);
+		}
+		else if (info.st_size > 0)
+		{
+			files.push_back(prefix + name);
+		}
+	}
+	closedir(dir);
+#endif
+}
+
+bool endsWith(const std::string& string, const std::string& suffix)
+{
+	return string.size() >= suffix.size() && string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Cooked files are only trusted once archived, so they have to match their source and the current format
+bool isUpToDate(const std::string& cookedPath)
+{
+	const std::string source = cookedPath.substr(0, cookedPath.size() - 5);
+	if (endsWith(cookedPath, ".pxmc"))
+	{
+		return phoenix::MeshCache(source).isValid();
+	}
+	for (int usage = phoenix::USAGE_COLOR; usage <= phoenix::USAGE_MASK; ++usage)
+	{
+		if (phoenix::CookedTexture(source, static_cast<phoenix::TextureUsage>(usage)).isValid())
+		{
+			return true;
+		}
+	}
+	return false;
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <engine/shadow_common.h>
 #include <engine/strings.h>
 #include <engine/common.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <iostream>
@@ -44,6 +45,8 @@ unsigned int FBO;
 std::array<unsigned int, 3> shadowMaps;
 std::array<BoundingBox, 3> shadowOrthoProjInfo;
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -69,7 +72,7 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
@@ -112,7 +115,7 @@ int main()
 		// Shadow map pass
 		execShadowMapPass(shadowMapPassShader, dragon);
 
-		glViewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+		glState.viewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// Render pass
@@ -136,7 +139,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -167,7 +170,7 @@ void setupRenderToTexture()
 	glGenTextures(shadowMaps.size(), &shadowMaps[0]);
 	for (size_t i = 0; i < shadowMaps.size(); ++i)
 	{
-		glBindTexture(GL_TEXTURE_2D, shadowMaps[i]);
+		glState.bindTexture(GL_TEXTURE_2D, shadowMaps[i]);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -180,11 +183,11 @@ void setupRenderToTexture()
 
 	// Attach the render targets to the FBO so we can write to them
 	glGenFramebuffers(1, &FBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, FBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMaps[0], 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void setLightSpaceVP(const phoenix::Shader& shader, unsigned int cascadeIndex, bool isRenderPass)
@@ -197,7 +200,7 @@ void setLightSpaceVP(const phoenix::Shader& shader, unsigned int cascadeIndex, b
 	lightSpaceVP = lightProjection * lightView;
 	if (isRenderPass)
 	{
-		shader.setMat4(phoenix::G_LIGHT_SPACE_VP + "[" + std::to_string(cascadeIndex) + "]", lightSpaceVP);
+		shader.setMat4(shader.getUniform(phoenix::G_LIGHT_SPACE_VP)[cascadeIndex], lightSpaceVP);
 	}
 	else
 	{
@@ -208,7 +211,7 @@ void setLightSpaceVP(const phoenix::Shader& shader, unsigned int cascadeIndex, b
 void execShadowMapPass(const phoenix::Shader& shader, phoenix::Model& object)
 {
 	calcOrthoProjs();
-	glViewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
+	glState.viewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
 
 	for (size_t i = 0; i < shadowMaps.size(); ++i)
 	{
@@ -217,10 +220,10 @@ void execShadowMapPass(const phoenix::Shader& shader, phoenix::Model& object)
 
 		setLightSpaceVP(shader, i, false);
 
-		shadowCommon->renderScene(utils, shader, object);
+		shadowCommon->renderScene(utils, shader, object, phoenix::LOD_SHADOW);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void execRenderPass(const phoenix::Shader& shader, phoenix::Model& object)
@@ -314,20 +317,20 @@ void setClipSpaceCascadeEnds(const phoenix::Shader& shader)
 
 void bindZBufferForWriting(unsigned int cascadeIndex)
 {
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+	glState.bindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMaps[cascadeIndex], 0);
 }
 
 void bindZBufferForReading()
 {
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, shadowMaps[0]);
+	glState.activeTexture(GL_TEXTURE1);
+	glState.bindTexture(GL_TEXTURE_2D, shadowMaps[0]);
 
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, shadowMaps[1]);
+	glState.activeTexture(GL_TEXTURE2);
+	glState.bindTexture(GL_TEXTURE_2D, shadowMaps[1]);
 
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, shadowMaps[2]);
+	glState.activeTexture(GL_TEXTURE3);
+	glState.bindTexture(GL_TEXTURE_2D, shadowMaps[2]);
 }
 
 void initPointers()
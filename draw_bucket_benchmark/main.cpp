@@ -0,0 +1,205 @@
+#include <engine/draw_bucket.h>
+#include <engine/render_stats.h>
+#include <engine/staging_ring.h>
+#include <engine/gl_state.h>
+#include <engine/common.h>
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Measures what recording, sorting and submitting a draw bucket costs on the CPU at 10k to 100k packets, against
+// submitting the same packets in the order they were recorded and against sorting them with std::stable_sort, which
+// keeps equal keys in order like the bucket's radix sort. Draws go to a hidden window and only cover a few pixels,
+// so the submission times are dominated by the driver's CPU side.
+// Usage: draw_bucket_benchmark [iterations]
+
+// std140 layout of voxel_cone_tracing/object_block.glsl
+struct ObjectBlock
+{
+	glm::mat4 _worldMatrix;
+	glm::vec4 _normalMatrix[3];
+	phoenix::Material::Block _material;
+};
+
+struct Timings
+{
+	double _record = 0.0, _sort = 0.0, _stdSort = 0.0, _submit = 0.0, _unsortedSubmit = 0.0;
+	size_t _stateChanges = 0, _unsortedStateChanges = 0;
+};
+
+const unsigned int NUM_PROGRAMS = 4, NUM_MATERIALS = 64, NUM_TEXTURE_SETS = 32, NUM_MESHES = 256;
+const size_t PACKET_COUNTS[] = { 10000, 30000, 100000 };
+
+double getMilliseconds(std::chrono::high_resolution_clock::time_point);
+void record(phoenix::DrawBucket&, size_t, const std::vector<phoenix::Shader*>&, const std::vector<phoenix::Mesh*>&, const std::vector<size_t>&);
+void submit(const phoenix::DrawBucket&, const phoenix::UniformBuffer&, double&, size_t&);
+
+int main(int argc, char** argv)
+{
+	const int iterations = argc > 1 ? std::max(std::stoi(argv[1]), 1) : 10;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Draw Bucket Benchmark", nullptr, nullptr);
+	if (window == nullptr)
+	{
+		std::cerr << "Failed to create GLFW window!\n";
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cerr << "Failed to initialize GLAD!\n";
+		return -1;
+	}
+	phoenix::GLState& glState = phoenix::GLState::getInstance();
+	glState.viewport(0, 0, 64, 64);
+	glState.enable(GL_DEPTH_TEST);
+
+	// Variants of the cone tracing program stand in for distinct programs
+	std::vector<phoenix::Shader*> programs;
+	for (unsigned int i = 0; i < NUM_PROGRAMS; ++i)
+	{
+		programs.push_back(new phoenix::Shader("../Resources/Shaders/voxel_cone_tracing/render.vs", "../Resources/Shaders/voxel_cone_tracing/render.fs",
+			{ { "VOXEL_RES", std::to_string(phoenix::VOXEL_GRID_RES) }, { "NUM_STEPS", std::to_string(i + 1) } }));
+	}
+	phoenix::Shader::finishPending();
+
+	std::vector<unsigned int> textures(NUM_TEXTURE_SETS);
+	glGenTextures(NUM_TEXTURE_SETS, textures.data());
+	const unsigned char texel[4] = { 255, 255, 255, 255 };
+	for (unsigned int texture : textures)
+	{
+		glState.bindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+	}
+
+	std::vector<phoenix::Material*> materials;
+	for (unsigned int i = 0; i < NUM_MATERIALS; ++i)
+	{
+		materials.push_back(new phoenix::Material(glm::vec3(static_cast<float>(i) / NUM_MATERIALS)));
+	}
+
+	// Blocks go with the meshes, so the uniform buffer stays the same size however many packets there are
+	phoenix::UniformBuffer uniformBuffer;
+	const unsigned char sharedBlocks[256] = {};
+	const size_t sharedOffset = uniformBuffer.push(sharedBlocks, sizeof(sharedBlocks));
+	std::vector<phoenix::Mesh*> meshes;
+	std::vector<size_t> blockOffsets;
+	phoenix::Vertex vertex = {};
+	vertex._normal = glm::vec3(0.0f, 0.0f, 1.0f);
+	const std::vector<phoenix::Vertex> vertices(3, vertex);
+	const std::vector<unsigned int> indices{ { 0, 1, 2 } };
+	for (unsigned int i = 0; i < NUM_MESHES; ++i)
+	{
+		const std::vector<phoenix::Texture> meshTextures{ { textures[i % NUM_TEXTURE_SETS], phoenix::DIFFUSE, "" } };
+		meshes.push_back(new phoenix::Mesh(vertices, indices, meshTextures));
+		meshes.back()->_material = materials[i % NUM_MATERIALS];
+		ObjectBlock block{ glm::mat4(1.0f), { glm::vec4(1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(0.0f, 0.0f, 1.0f, 0.0f) },
+			meshes.back()->_material->getBlock() };
+		blockOffsets.push_back(uniformBuffer.push(block));
+	}
+	uniformBuffer.upload();
+	uniformBuffer.bind(phoenix::CAMERA_BLOCK_BINDING, sharedOffset, sizeof(sharedBlocks));
+	uniformBuffer.bind(phoenix::LIGHT_BLOCK_BINDING, sharedOffset, sizeof(sharedBlocks));
+
+	std::cout << iterations << " iterations, " << NUM_PROGRAMS << " programs, " << NUM_MATERIALS << " materials, " << NUM_TEXTURE_SETS << " texture sets, "
+		<< NUM_MESHES << " meshes\n";
+	for (size_t numPackets : PACKET_COUNTS)
+	{
+		Timings timings;
+		phoenix::DrawBucket bucket, unsortedBucket;
+		for (int i = 0; i < iterations; ++i)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			record(bucket, numPackets, programs, meshes, blockOffsets);
+			timings._record += getMilliseconds(start);
+			record(unsortedBucket, numPackets, programs, meshes, blockOffsets);
+
+			std::vector<phoenix::DrawBucket::Packet> packets = bucket.getPackets();
+			start = std::chrono::high_resolution_clock::now();
+			std::stable_sort(packets.begin(), packets.end(), [](const phoenix::DrawBucket::Packet& a, const phoenix::DrawBucket::Packet& b)
+			{
+				return a._key < b._key;
+			});
+			timings._stdSort += getMilliseconds(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			bucket.sort();
+			timings._sort += getMilliseconds(start);
+
+			submit(bucket, uniformBuffer, timings._submit, timings._stateChanges);
+			submit(unsortedBucket, uniformBuffer, timings._unsortedSubmit, timings._unsortedStateChanges);
+			bucket.clear();
+			unsortedBucket.clear();
+			phoenix::StagingRing::getInstance().fence();
+		}
+
+		std::cout << numPackets << " packets: record " << timings._record / iterations << " ms, radix sort " << timings._sort / iterations << " ms (std::stable_sort "
+			<< timings._stdSort / iterations << " ms), sorted submit " << timings._submit / iterations << " ms with " << timings._stateChanges / iterations
+			<< " state changes, unsorted submit " << timings._unsortedSubmit / iterations << " ms with " << timings._unsortedStateChanges / iterations << " state changes\n";
+	}
+
+	for (phoenix::Mesh* mesh : meshes)
+	{
+		// Meshes own their material, these ones are shared
+		mesh->_material = nullptr;
+		delete mesh;
+	}
+	for (phoenix::Material* material : materials)
+	{
+		delete material;
+	}
+	for (phoenix::Shader* program : programs)
+	{
+		delete program;
+	}
+	glState.deleteTextures(NUM_TEXTURE_SETS, textures.data());
+	glfwTerminate();
+	return 0;
+}
+
+double getMilliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void record(phoenix::DrawBucket& bucket, size_t numPackets, const std::vector<phoenix::Shader*>& programs, const std::vector<phoenix::Mesh*>& meshes,
+	const std::vector<size_t>& blockOffsets)
+{
+	// Same seed for every bucket, so the sorted and unsorted ones hold the same packets
+	std::mt19937 generator(1337);
+	std::uniform_int_distribution<size_t> programDistribution(0, programs.size() - 1), meshDistribution(0, meshes.size() - 1);
+	std::uniform_real_distribution<float> depthDistribution(phoenix::PERSPECTIVE_NEAR_PLANE, phoenix::PERSPECTIVE_FAR_PLANE);
+	for (size_t i = 0; i < numPackets; ++i)
+	{
+		const size_t mesh = meshDistribution(generator);
+		const uint64_t key = phoenix::DrawBucket::makeKey(0, bucket.getProgramId(programs[programDistribution(generator)]), bucket.getMaterialId(meshes[mesh]->_material),
+			bucket.getTextureSetId(meshes[mesh]->getTextures()), depthDistribution(generator));
+		bucket.push(key, meshes[mesh], blockOffsets[mesh]);
+	}
+}
+
+void submit(const phoenix::DrawBucket& bucket, const phoenix::UniformBuffer& uniformBuffer, double& milliseconds, size_t& stateChanges)
+{
+	// Everything queued before has to be out of the way, so only this submission is timed
+	glFinish();
+	phoenix::RenderStats& stats = phoenix::RenderStats::getInstance();
+	stats.reset();
+	auto start = std::chrono::high_resolution_clock::now();
+	bucket.submit(uniformBuffer, phoenix::OBJECT_BLOCK_BINDING, sizeof(ObjectBlock));
+	milliseconds += getMilliseconds(start);
+	stateChanges += stats._numStateChanges;
+	glFinish();
+}
\ No newline at end of file
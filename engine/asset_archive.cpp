@@ -0,0 +1,269 @@
+#include <engine/asset_archive.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+namespace phoenix
+{
+	namespace
+	{
+		const char MAGIC[4] = { 'P', 'X', 'P', 'K' };
+		// Bump whenever the layout changes
+		const uint32_t VERSION = 1;
+		const uint64_t BLOB_ALIGNMENT = 16;
+
+		struct Header
+		{
+			char _magic[4];
+			uint32_t _version;
+			uint64_t _numEntries;
+			uint64_t _stringsSize;
+		};
+
+		struct EntryRecord
+		{
+			uint64_t _pathOffset, _pathLength; // Into the string blob
+			uint64_t _offset, _size, _hash;
+		};
+
+		std::unique_ptr<AssetArchive> mounted;
+		std::string mountDirectory;
+
+		uint64_t align(uint64_t offset)
+		{
+			return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+		}
+
+		const EntryRecord* getRecords(const unsigned char* data)
+		{
+			return reinterpret_cast<const EntryRecord*>(data + sizeof(Header));
+		}
+
+		const char* getStrings(const unsigned char* data)
+		{
+			return reinterpret_cast<const char*>(getRecords(data) + reinterpret_cast<const Header*>(data)->_numEntries);
+		}
+	}
+
+	AssetArchive::AssetArchive(const std::string& filename) : _file(filename)
+	{
+		if (!_file.isOpen() || _file.size() < sizeof(Header))
+		{
+			return;
+		}
+
+		const unsigned char* data = _file.data();
+		const Header* header = reinterpret_cast<const Header*>(data);
+		if (std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) || header->_version != VERSION
+			|| _file.size() < sizeof(Header) + header->_numEntries * sizeof(EntryRecord) + header->_stringsSize)
+		{
+			std::cerr << "Invalid asset archive " << filename << "!\n";
+			return;
+		}
+		const EntryRecord* records = getRecords(data);
+		for (size_t i = 0; i < header->_numEntries; ++i)
+		{
+			if (records[i]._pathOffset + records[i]._pathLength > header->_stringsSize || records[i]._offset + records[i]._size > _file.size())
+			{
+				std::cerr << "Corrupt asset archive " << filename << "!\n";
+				return;
+			}
+		}
+		_numEntries = header->_numEntries;
+	}
+
+	AssetArchive::View AssetArchive::find(const std::string& path) const
+	{
+		if (!isOpen())
+		{
+			return View{ nullptr, 0 };
+		}
+		// The table is sorted by path, so a binary search on raw bytes finds the entry without building strings.
+		// std::string orders by unsigned bytes, so compare with memcmp rather than over (possibly signed) chars.
+		const unsigned char* data = _file.data();
+		const EntryRecord* records = getRecords(data);
+		const char* strings = getStrings(data);
+		const EntryRecord* record = std::lower_bound(records, records + _numEntries, path, [strings](const EntryRecord& record, const std::string& path)
+		{
+			const int order = std::memcmp(strings + record._pathOffset, path.data(), std::min(static_cast<size_t>(record._pathLength), path.size()));
+			return order < 0 || (order == 0 && record._pathLength < path.size());
+		});
+		if (record == records + _numEntries || record->_pathLength != path.size() || std::memcmp(strings + record->_pathOffset, path.data(), path.size()))
+		{
+			return View{ nullptr, 0 };
+		}
+		return View{ data + record->_offset, static_cast<size_t>(record->_size) };
+	}
+
+	bool AssetArchive::verify() const
+	{
+		const unsigned char* data = _file.data();
+		const EntryRecord* records = getRecords(data);
+		const char* strings = getStrings(data);
+		bool valid = true;
+		for (size_t i = 0; i < _numEntries; ++i)
+		{
+			if (getHash(data + records[i]._offset, records[i]._size) != records[i]._hash)
+			{
+				std::cerr << "Hash mismatch for " << std::string(strings + records[i]._pathOffset, records[i]._pathLength) << " in the asset archive!\n";
+				valid = false;
+			}
+		}
+		return valid;
+	}
+
+	bool AssetArchive::mount(const std::string& filename, const std::string& directory)
+	{
+		std::unique_ptr<AssetArchive> archive(new AssetArchive(filename));
+		if (!archive->isOpen())
+		{
+			return false;
+		}
+		mounted = std::move(archive);
+		mountDirectory = normalizePath(directory);
+		if (!mountDirectory.empty() && mountDirectory.back() != '/')
+		{
+			mountDirectory += '/';
+		}
+		std::cout << "Mounted " << filename << " with " << mounted->getNumEntries() << " files at " << mountDirectory << "\n";
+		return true;
+	}
+
+	void AssetArchive::unmount()
+	{
+		mounted.reset();
+		mountDirectory.clear();
+	}
+
+	AssetArchive::View AssetArchive::findMounted(const std::string& filename)
+	{
+		if (!mounted)
+		{
+			return View{ nullptr, 0 };
+		}
+		const std::string path = normalizePath(filename);
+		if (path.compare(0, mountDirectory.size(), mountDirectory))
+		{
+			return View{ nullptr, 0 };
+		}
+		return mounted->find(path.substr(mountDirectory.size()));
+	}
+
+	bool AssetArchive::write(const std::string& filename, const std::string& rootDirectory, const std::vector<std::string>& paths)
+	{
+		std::vector<std::string> sortedPaths;
+		for (const auto& path : paths)
+		{
+			sortedPaths.push_back(normalizePath(path));
+		}
+		std::sort(sortedPaths.begin(), sortedPaths.end());
+		sortedPaths.erase(std::unique(sortedPaths.begin(), sortedPaths.end()), sortedPaths.end());
+		std::string root = normalizePath(rootDirectory);
+		if (!root.empty() && root.back() != '/')
+		{
+			root += '/';
+		}
+
+		Header header;
+		std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+		header._version = VERSION;
+		header._numEntries = sortedPaths.size();
+		header._stringsSize = 0;
+		std::vector<EntryRecord> records(sortedPaths.size());
+		for (size_t i = 0; i < sortedPaths.size(); ++i)
+		{
+			records[i]._pathOffset = header._stringsSize;
+			records[i]._pathLength = sortedPaths[i].size();
+			header._stringsSize += sortedPaths[i].size();
+		}
+
+		// Sizes and hashes are only known once the files are mapped, which they stay until everything is written
+		std::vector<std::unique_ptr<MappedFile>> files;
+		uint64_t offset = sizeof(Header) + records.size() * sizeof(EntryRecord) + header._stringsSize;
+		for (size_t i = 0; i < sortedPaths.size(); ++i)
+		{
+			files.emplace_back(new MappedFile(root + sortedPaths[i]));
+			const MappedFile& file = *files.back();
+			if (!file.isOpen())
+			{
+				std::cerr << "Could not pack " << root + sortedPaths[i] << "!\n";
+				return false;
+			}
+			offset = align(offset);
+			records[i]._offset = offset;
+			records[i]._size = file.size();
+			records[i]._hash = getHash(file.data(), file.size());
+			offset += file.size();
+		}
+
+		std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			std::cerr << "Could not write asset archive " << filename << "!\n";
+			return false;
+		}
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		stream.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(EntryRecord));
+		for (const auto& path : sortedPaths)
+		{
+			stream.write(path.data(), path.size());
+		}
+		const char padding[BLOB_ALIGNMENT] = {};
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			stream.write(padding, records[i]._offset - static_cast<uint64_t>(stream.tellp()));
+			stream.write(reinterpret_cast<const char*>(files[i]->data()), files[i]->size());
+		}
+		return static_cast<bool>(stream);
+	}
+
+	uint64_t AssetArchive::getHash(const unsigned char* data, size_t size, uint64_t hash)
+	{
+		// Like the texture registry keys
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash = (hash ^ data[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::string AssetArchive::normalizePath(const std::string& path)
+	{
+		std::string normalized = path;
+		std::replace(normalized.begin(), normalized.end(), '\\', '/');
+#ifdef _WIN32
+		// Paths are case insensitive on Windows
+		std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+		std::vector<std::string> components;
+		size_t begin = 0;
+		while (begin <= normalized.size())
+		{
+			size_t end = normalized.find('/', begin);
+			if (end == std::string::npos)
+			{
+				end = normalized.size();
+			}
+			const std::string component = normalized.substr(begin, end - begin);
+			if (component == ".." && !components.empty() && components.back() != "..")
+			{
+				components.pop_back();
+			}
+			else if (!component.empty() && component != ".")
+			{
+				components.push_back(component);
+			}
+			begin = end + 1;
+		}
+
+		std::string result = !normalized.empty() && normalized[0] == '/' ? "/" : "";
+		for (size_t i = 0; i < components.size(); ++i)
+		{
+			result += (i ? "/" : "") + components[i];
+		}
+		return result;
+	}
+}
\ No newline at end of file
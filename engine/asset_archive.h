@@ -0,0 +1,59 @@
+#pragma once
+#include <engine/mapped_file.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phoenix
+{
+	// Single file holding cooked meshes, cooked textures and shader sources. The file is a header followed by a table
+	// of contents sorted by path, a string blob for the paths and finally the file contents, each with its size and a
+	// content hash. Once an archive is mounted, every MappedFile under the mount directory that the archive holds is
+	// a view into its pages instead of a file of its own. Archived cooked files are trusted as they are, the packer
+	// only takes ones that are up to date with their source.
+	class AssetArchive
+	{
+	public:
+		struct View
+		{
+			const unsigned char* _data;
+			size_t _size;
+		};
+
+		AssetArchive(const std::string&);
+
+		inline bool isOpen() const
+		{
+			return _numEntries > 0;
+		}
+		inline size_t getNumEntries() const
+		{
+			return _numEntries;
+		}
+		// Looks up a path relative to the archive root, the view is empty if the archive doesn't hold it
+		View find(const std::string&) const;
+		// Checks every entry against its content hash
+		bool verify() const;
+
+		// Serves files under the given directory from the archive from now on. Has to happen before any loading starts.
+		static bool mount(const std::string&, const std::string&);
+		static void unmount();
+		// Looks up a path as the loaders spell it in the mounted archive
+		static View findMounted(const std::string&);
+
+		// Packs the files, given relative to the root directory, into a new archive
+		static bool write(const std::string&, const std::string&, const std::vector<std::string>&);
+		// 64-bit FNV-1a, continuing from the given hash so several buffers can be hashed as one
+		static uint64_t getHash(const unsigned char*, size_t, uint64_t = 14695981039346656037ull);
+		// Forward slashes, without . and resolvable .. components
+		static std::string normalizePath(const std::string&);
+
+	private:
+		MappedFile _file;
+		size_t _numEntries = 0;
+
+		AssetArchive(AssetArchive const&) = delete;
+		void operator=(AssetArchive const&) = delete;
+	};
+}
\ No newline at end of file
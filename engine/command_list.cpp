@@ -0,0 +1,32 @@
+#include <engine/command_list.h>
+#include <cstring>
+
+namespace phoenix
+{
+	CommandList::CommandList(size_t alignment) : _alignment(alignment) {}
+
+	size_t CommandList::pushBlock(const void* block, size_t size)
+	{
+		const size_t offset = (_blocks.size() + _alignment - 1) / _alignment * _alignment;
+		_blocks.resize(offset + size);
+		std::memcpy(_blocks.data() + offset, block, size);
+		return offset;
+	}
+
+	void CommandList::replay(UniformBuffer& uniformBuffer, DrawBucket& bucket) const
+	{
+		if (_packets.empty())
+		{
+			return;
+		}
+		// The buffer aligns the copy itself, so offsets within the list stay aligned
+		const size_t offset = _blocks.empty() ? 0 : uniformBuffer.push(_blocks.data(), _blocks.size());
+		bucket.append(_packets, offset);
+	}
+
+	void CommandList::clear()
+	{
+		_packets.clear();
+		_blocks.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <engine/draw_bucket.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace phoenix
+{
+	// Draws of a pass or of a chunk of its meshes, with the uniform blocks they read, recorded without touching GL so
+	// that worker threads can fill lists in parallel. Replaying a list on the GL thread copies its blocks into the
+	// uniform buffer in one go and appends its draws, offset to where the blocks landed, to a draw bucket.
+	class CommandList
+	{
+	public:
+		// Blocks are aligned like the uniform buffer they are replayed into
+		CommandList(size_t = 1);
+
+		// Appends a block and returns its offset within the list
+		size_t pushBlock(const void*, size_t);
+		template<typename T>
+		inline size_t pushBlock(const T& block)
+		{
+			return pushBlock(&block, sizeof(T));
+		}
+		inline void draw(uint64_t key, Mesh* mesh, size_t blockOffset)
+		{
+			_packets.push_back(DrawBucket::Packet{ key, mesh, blockOffset });
+		}
+		void replay(UniformBuffer&, DrawBucket&) const;
+		void clear();
+
+		inline size_t getNumDraws() const
+		{
+			return _packets.size();
+		}
+
+	private:
+		size_t _alignment;
+		std::vector<DrawBucket::Packet> _packets;
+		std::vector<unsigned char> _blocks;
+	};
+}
\ No newline at end of file
@@ -14,6 +14,25 @@ namespace phoenix
 
 	static const unsigned int SCREEN_WIDTH = 2560, SCREEN_HEIGHT = 1440, NUM_CUBEMAP_FACES = 6,
 		HIGH_RES_WIDTH = 4096, HIGH_RES_HEIGHT = 4096, NUM_FRUSTUM_CORNERS = 8;
+	static const unsigned int VERTEX_CACHE_SIZE = 16; // Post-transform cache entries the mesh optimizer targets
+	static const float OVERDRAW_THRESHOLD = 1.05f; // ACMR the overdraw sort may give up relative to the cache-optimal order
+	static const unsigned int MAX_NUM_LODS = 5, MIN_LOD_TRIANGLES = 256;
+	static const float LOD_REDUCTION = 0.5f; // Triangle ratio between consecutive LODs
+	static const float LOD_PIXEL_ERROR = 1.0f; // Geometric error in pixels up to which a coarser LOD is selected
+	static const unsigned int MESHLET_MAX_VERTICES = 64, MESHLET_MAX_TRIANGLES = 124;
+	static const unsigned int ARENA_MIN_VERTICES = 1 << 16, ARENA_MIN_INDICES = 1 << 18; // Initial geometry arena capacities
+	static const size_t MODEL_UPLOAD_BUDGET = 4 << 20; // Bytes of streamed geometry uploaded per frame
+	static const size_t STAGING_RING_SIZE = 32 << 20, STAGING_RING_FENCES = 8, STAGING_ALIGNMENT = 16; // Upload ring size, fence granularity and offset alignment
+	static const size_t MIP_PARALLEL_TEXELS = 256 * 256; // Mip levels at least this big have their rows split across threads
+	static const size_t TEXTURE_STREAMING_BUDGET = 64 << 20, TEXTURE_STREAMING_UPLOAD_BUDGET = 8 << 20; // Bytes of streamed textures resident, and streamed in per frame
+	static const unsigned int TEXTURE_STREAMING_TAIL = 64; // Largest side of the mip tail that stays resident
+	static const unsigned int TEXTURE_FEEDBACK_SCALE = 8, TEXTURE_FEEDBACK_LATENCY = 3; // Feedback resolution divisor and readbacks in flight
+	static const unsigned int ENVIRONMENT_MAP_RESOLUTION = 512; // Face size HDR environments are converted to, at bake time and at load
+	static const unsigned int VOXEL_GRID_RES = 64, VOXEL_CONE_TRACING_STEPS = 200; // Voxels per side of the cone tracing grid and steps per traced cone
+	static const unsigned int CAMERA_BLOCK_BINDING = 0, LIGHT_BLOCK_BINDING = 1, OBJECT_BLOCK_BINDING = 2; // Uniform buffer bindings, matched by the layouts in the shaders
+	static const size_t UNIFORM_BUFFER_SIZE = 64 << 10; // Initial bytes of uniform blocks written per frame
+	static const size_t RECORDING_CHUNK_SIZE = 128; // Meshes a job records draws for, smaller passes are recorded on the GL thread alone
+	static const float MESHLET_CONE_WEIGHT = 2.0f; // New vertices a meshlet may pay for a triangle that keeps its normal cone tight
 
 	static const glm::vec3 UP(0.0f, 1.0f, 0.0f);
 	static const glm::vec3 CAMERA_POS(-9.2906f, 2.03786f, 10.2668f); // Starting position of our camera
@@ -0,0 +1,210 @@
+#include <engine/draw_bucket.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace phoenix
+{
+	namespace
+	{
+		// Key fields, most significant first. Depth comes last, so it only orders draws that share every state.
+		const unsigned int PASS_BITS = 6, PROGRAM_BITS = 10, MATERIAL_BITS = 10, TEXTURE_SET_BITS = 14, DEPTH_BITS = 24;
+		const unsigned int DEPTH_SHIFT = 0, TEXTURE_SET_SHIFT = DEPTH_SHIFT + DEPTH_BITS, MATERIAL_SHIFT = TEXTURE_SET_SHIFT + TEXTURE_SET_BITS,
+			PROGRAM_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS, PASS_SHIFT = PROGRAM_SHIFT + PROGRAM_BITS;
+		// Shared by every texture set beyond the ones the key has room for, which are then bound for each draw
+		const unsigned int UNSHARED_TEXTURE_SET = (1u << TEXTURE_SET_BITS) - 1;
+		const unsigned int RADIX_BITS = 8, RADIX_SIZE = 1 << RADIX_BITS, NUM_RADIX_PASSES = 64 / RADIX_BITS;
+
+		inline uint64_t getMask(unsigned int bits)
+		{
+			return (uint64_t(1) << bits) - 1;
+		}
+
+		inline uint64_t encode(uint64_t value, unsigned int shift, unsigned int bits)
+		{
+			return (value & getMask(bits)) << shift;
+		}
+
+		inline unsigned int decode(uint64_t key, unsigned int shift, unsigned int bits)
+		{
+			return static_cast<unsigned int>((key >> shift) & getMask(bits));
+		}
+
+		// Negative, zero or positive as the texture IDs order lexicographically before, the same as or after the textures
+		int compareTextureSets(const std::vector<unsigned int>& names, const std::vector<Texture>& textures)
+		{
+			const size_t size = std::min(names.size(), textures.size());
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (names[i] != textures[i]._ID)
+				{
+					return names[i] < textures[i]._ID ? -1 : 1;
+				}
+			}
+			return names.size() < textures.size() ? -1 : names.size() > textures.size() ? 1 : 0;
+		}
+	}
+
+	uint64_t DrawBucket::makeKey(unsigned int pass, unsigned int program, unsigned int material, unsigned int textureSet, float depth, bool backToFront)
+	{
+		// The bits of a non-negative float grow with its value, so the top ones order depths without a conversion
+		const float clamped = std::max(depth, 0.0f);
+		uint32_t depthBits;
+		std::memcpy(&depthBits, &clamped, sizeof(float));
+		uint64_t depthField = depthBits >> (32 - DEPTH_BITS);
+		if (backToFront)
+		{
+			depthField = getMask(DEPTH_BITS) - depthField;
+		}
+		return encode(pass, PASS_SHIFT, PASS_BITS) | encode(program, PROGRAM_SHIFT, PROGRAM_BITS) | encode(material, MATERIAL_SHIFT, MATERIAL_BITS)
+			| encode(textureSet, TEXTURE_SET_SHIFT, TEXTURE_SET_BITS) | encode(depthField, DEPTH_SHIFT, DEPTH_BITS);
+	}
+
+	unsigned int DrawBucket::getProgramId(const Shader* shader)
+	{
+		std::lock_guard<std::mutex> lock(_idMutex);
+		auto it = _programIds.find(shader);
+		if (it != _programIds.end())
+		{
+			return it->second;
+		}
+		if (_programs.size() == (1u << PROGRAM_BITS))
+		{
+			std::cerr << "Too many programs in a draw bucket!\n";
+			return 0;
+		}
+		_programs.push_back(shader);
+		return _programIds[shader] = static_cast<unsigned int>(_programs.size() - 1);
+	}
+
+	unsigned int DrawBucket::getMaterialId(const Material* material)
+	{
+		// Fibonacci hashing of the address, whose low bits are always zero. Colliding materials are merely grouped
+		// less tightly, without a table that workers would have to share.
+		const uint64_t address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(material)) >> 4;
+		return static_cast<unsigned int>((address * 11400714819323198485ull) >> (64 - MATERIAL_BITS));
+	}
+
+	unsigned int DrawBucket::getTextureSetId(const std::vector<Texture>& textures)
+	{
+		if (textures.empty())
+		{
+			return 0;
+		}
+		std::lock_guard<std::mutex> lock(_idMutex);
+		auto it = _textureSetIds.find(textures);
+		if (it != _textureSetIds.end())
+		{
+			return it->second;
+		}
+		if (_textureSetIds.size() + 1 == UNSHARED_TEXTURE_SET)
+		{
+			return UNSHARED_TEXTURE_SET;
+		}
+		// Only new sets get a key of their own
+		std::vector<unsigned int> names(textures.size());
+		for (size_t i = 0; i < textures.size(); ++i)
+		{
+			names[i] = textures[i]._ID;
+		}
+		const unsigned int id = static_cast<unsigned int>(_textureSetIds.size() + 1);
+		_textureSetIds.emplace(std::move(names), id);
+		return id;
+	}
+
+	bool DrawBucket::TextureSetLess::operator()(const std::vector<unsigned int>& a, const std::vector<unsigned int>& b) const
+	{
+		return a < b;
+	}
+
+	bool DrawBucket::TextureSetLess::operator()(const std::vector<unsigned int>& a, const std::vector<Texture>& b) const
+	{
+		return compareTextureSets(a, b) < 0;
+	}
+
+	bool DrawBucket::TextureSetLess::operator()(const std::vector<Texture>& a, const std::vector<unsigned int>& b) const
+	{
+		return compareTextureSets(b, a) > 0;
+	}
+
+	void DrawBucket::append(const std::vector<Packet>& packets, size_t blockOffset)
+	{
+		_packets.reserve(_packets.size() + packets.size());
+		for (const Packet& packet : packets)
+		{
+			_packets.push_back(Packet{ packet._key, packet._mesh, blockOffset + packet._blockOffset });
+		}
+	}
+
+	void DrawBucket::sort()
+	{
+		const size_t numPackets = _packets.size();
+		if (numPackets < 2)
+		{
+			return;
+		}
+		// Least significant digit first, with the histograms of every digit gathered in a single pass over the keys
+		std::vector<size_t> counts(NUM_RADIX_PASSES * RADIX_SIZE, 0);
+		for (const Packet& packet : _packets)
+		{
+			for (unsigned int pass = 0; pass < NUM_RADIX_PASSES; ++pass)
+			{
+				++counts[pass * RADIX_SIZE + ((packet._key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1))];
+			}
+		}
+
+		_sorted.resize(numPackets);
+		for (unsigned int pass = 0; pass < NUM_RADIX_PASSES; ++pass)
+		{
+			const unsigned int shift = pass * RADIX_BITS;
+			size_t* passCounts = &counts[pass * RADIX_SIZE];
+			// A digit every key shares, like the pass of a bucket holding a single one, leaves the order as it is
+			if (passCounts[(_packets[0]._key >> shift) & (RADIX_SIZE - 1)] == numPackets)
+			{
+				continue;
+			}
+			size_t offset = 0;
+			for (unsigned int digit = 0; digit < RADIX_SIZE; ++digit)
+			{
+				const size_t count = passCounts[digit];
+				passCounts[digit] = offset;
+				offset += count;
+			}
+			for (const Packet& packet : _packets)
+			{
+				_sorted[passCounts[(packet._key >> shift) & (RADIX_SIZE - 1)]++] = packet;
+			}
+			_packets.swap(_sorted);
+		}
+	}
+
+	void DrawBucket::submit(const UniformBuffer& uniformBuffer, unsigned int binding, size_t blockSize) const
+	{
+		const Shader* shader = nullptr;
+		unsigned int textureSet = 0;
+		for (const Packet& packet : _packets)
+		{
+			const Shader* packetShader = _programs[decode(packet._key, PROGRAM_SHIFT, PROGRAM_BITS)];
+			const unsigned int packetTextureSet = decode(packet._key, TEXTURE_SET_SHIFT, TEXTURE_SET_BITS);
+			if (packetShader != shader)
+			{
+				shader = packetShader;
+				shader->use();
+				// Sampler uniforms belong to the program, so its textures have to be set up again
+				textureSet = 0;
+			}
+			if (packetTextureSet != textureSet || packetTextureSet == UNSHARED_TEXTURE_SET)
+			{
+				textureSet = packetTextureSet;
+				packet._mesh->bindTextures(*shader);
+			}
+			uniformBuffer.bind(binding, packet._blockOffset, blockSize);
+			packet._mesh->render();
+		}
+	}
+
+	void DrawBucket::clear()
+	{
+		_packets.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <engine/mesh.h>
+#include <engine/uniform_buffer.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace phoenix
+{
+	// Draws recorded as compact packets, each with a 64-bit sort key holding, from the most significant bits down,
+	// the pass, program, material, texture set and depth. The bucket is radix sorted on the keys and then submitted,
+	// so draws sharing a program and textures end up next to each other and only switch state where the key changes,
+	// and within that opaque draws go front to back. Programs and texture sets are given small ids for the keys,
+	// which stay the same for the bucket's lifetime, and materials hashed ones.
+	class DrawBucket
+	{
+	public:
+		struct Packet
+		{
+			uint64_t _key;
+			Mesh* _mesh;
+			size_t _blockOffset; // Of the draw's block in the uniform buffer
+		};
+
+		// Depth is the view space distance, negative values count as 0. Back to front reverses the depth order only.
+		static uint64_t makeKey(unsigned int, unsigned int, unsigned int, unsigned int, float, bool = false);
+
+		// Ids may be asked for from several threads at once
+		unsigned int getProgramId(const Shader*);
+		// Materials only live in the per draw blocks, so they merely have to be told apart well enough to group draws
+		static unsigned int getMaterialId(const Material*);
+		// 0 for meshes without textures
+		unsigned int getTextureSetId(const std::vector<Texture>&);
+
+		inline void push(uint64_t key, Mesh* mesh, size_t blockOffset)
+		{
+			_packets.push_back(Packet{ key, mesh, blockOffset });
+		}
+		// Appends packets recorded elsewhere, whose block offsets are relative to the given one
+		void append(const std::vector<Packet>&, size_t);
+		// Stable, so packets with equal keys keep the order they were pushed in
+		void sort();
+		// Draws every packet in order and binds its block range to the given binding before each draw. Programs and
+		// textures are only bound where the key changes.
+		void submit(const UniformBuffer&, unsigned int, size_t) const;
+		void clear();
+
+		inline const std::vector<Packet>& getPackets() const
+		{
+			return _packets;
+		}
+
+	private:
+		// Orders texture sets by their texture IDs and finds them straight from a mesh's textures, without building a key
+		struct TextureSetLess
+		{
+			using is_transparent = void;
+
+			bool operator()(const std::vector<unsigned int>&, const std::vector<unsigned int>&) const;
+			bool operator()(const std::vector<unsigned int>&, const std::vector<Texture>&) const;
+			bool operator()(const std::vector<Texture>&, const std::vector<unsigned int>&) const;
+		};
+
+		std::vector<Packet> _packets, _sorted;
+		std::vector<const Shader*> _programs;
+		std::unordered_map<const Shader*, unsigned int> _programIds;
+		std::map<std::vector<unsigned int>, unsigned int, TextureSetLess> _textureSetIds;
+		std::mutex _idMutex;
+	};
+}
\ No newline at end of file
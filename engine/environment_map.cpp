@@ -0,0 +1,489 @@
+#include <engine/environment_map.h>
+#include <engine/gl_state.h>
+#include <engine/asset_archive.h>
+#include <engine/staging_ring.h>
+#include <engine/common.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <emmintrin.h>
+
+namespace phoenix
+{
+	namespace
+	{
+		const char MAGIC[4] = { 'P', 'X', 'E', 'C' };
+		// Bump whenever the layout, the resampling or the mip filter change
+		const uint32_t VERSION = 1;
+		const uint64_t BLOB_ALIGNMENT = 16;
+		const float PI = 3.14159265359f;
+
+		struct Header
+		{
+			char _magic[4];
+			uint32_t _version;
+			uint64_t _sourceSize;
+			int64_t _sourceTimestamp;
+			uint64_t _sourceHash;
+			uint32_t _resolution;
+			uint32_t _numLevels;
+		};
+
+		struct LevelRecord
+		{
+			uint64_t _offset, _faceSize;
+			uint32_t _resolution, _padding;
+		};
+
+		uint64_t align(uint64_t offset)
+		{
+			return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+		}
+
+		// Reads a header line without its newline, returns false past the end of the data
+		bool readLine(const unsigned char*& data, const unsigned char* end, std::string& line)
+		{
+			line.clear();
+			while (data < end && *data != '\n')
+			{
+				line += static_cast<char>(*data++);
+			}
+			if (data == end)
+			{
+				return false;
+			}
+			++data;
+			return true;
+		}
+
+		// Runs of equal bytes have their count above 128, anything else is a count of literal bytes
+		bool decodeRuns(const unsigned char*& data, const unsigned char* end, int width, unsigned char* channel)
+		{
+			int x = 0;
+			while (x < width)
+			{
+				if (data == end)
+				{
+					return false;
+				}
+				int count = *data++;
+				if (count > 128)
+				{
+					count -= 128;
+					if (count > width - x || data == end)
+					{
+						return false;
+					}
+					std::memset(channel + x, *data++, count);
+				}
+				else
+				{
+					if (count == 0 || count > width - x || end - data < count)
+					{
+						return false;
+					}
+					std::memcpy(channel + x, data, count);
+					data += count;
+				}
+				x += count;
+			}
+			return true;
+		}
+
+		__m128i widenBytes(const unsigned char* bytes)
+		{
+			int32_t packed;
+			std::memcpy(&packed, bytes, sizeof(packed));
+			const __m128i zero = _mm_setzero_si128();
+			return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+		}
+
+		// Scanline stored as separate R, G, B and E planes. Each texel is its mantissas times 2^(E - 136), which is
+		// built straight into the float exponent bits. Exponents too small for a normal float flush to 0.
+		void convertScanline(const unsigned char* planes, int width, float* destination)
+		{
+			const unsigned char* r = planes;
+			const unsigned char* g = planes + width;
+			const unsigned char* b = planes + width * 2;
+			const unsigned char* e = planes + width * 3;
+			const __m128i minExponent = _mm_set1_epi32(9);
+			int x = 0;
+			// Four texels per iteration. The last store spills one float into the next texel, so the final group is left to the scalar loop.
+			for (; x + 4 < width; x += 4)
+			{
+				const __m128i exponent = widenBytes(e + x);
+				const __m128 scale = _mm_and_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(exponent, minExponent), 23)),
+					_mm_castsi128_ps(_mm_cmpgt_epi32(exponent, minExponent)));
+				__m128 red = _mm_mul_ps(_mm_cvtepi32_ps(widenBytes(r + x)), scale);
+				__m128 green = _mm_mul_ps(_mm_cvtepi32_ps(widenBytes(g + x)), scale);
+				__m128 blue = _mm_mul_ps(_mm_cvtepi32_ps(widenBytes(b + x)), scale);
+				__m128 unused = _mm_setzero_ps();
+				_MM_TRANSPOSE4_PS(red, green, blue, unused);
+				float* texels = destination + x * 3;
+				_mm_storeu_ps(texels, red);
+				_mm_storeu_ps(texels + 3, green);
+				_mm_storeu_ps(texels + 6, blue);
+				_mm_storeu_ps(texels + 9, unused);
+			}
+			for (; x < width; ++x)
+			{
+				const float scale = e[x] > 9 ? std::ldexp(1.0f, e[x] - 136) : 0.0f;
+				destination[x * 3] = r[x] * scale;
+				destination[x * 3 + 1] = g[x] * scale;
+				destination[x * 3 + 2] = b[x] * scale;
+			}
+		}
+
+		// Rounds to nearest even, saturating at the largest finite half so bright texels don't turn into infinities when filtered
+		uint16_t toHalf(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			const uint16_t sign = static_cast<uint16_t>(bits >> 16 & 0x8000);
+			bits &= 0x7FFFFFFF;
+			if (bits > 0x7F800000)
+			{
+				return sign | 0x7E00;
+			}
+			if (bits >= 0x477FF000)
+			{
+				return sign | 0x7BFF;
+			}
+			if (bits < 0x38800000)
+			{
+				// Subnormal, adding 0.5 lines the mantissa up so the FPU does the rounding
+				const float magic = 0.5f;
+				float shifted;
+				std::memcpy(&shifted, &bits, sizeof(shifted));
+				shifted += magic;
+				uint32_t shiftedBits, magicBits;
+				std::memcpy(&shiftedBits, &shifted, sizeof(shiftedBits));
+				std::memcpy(&magicBits, &magic, sizeof(magicBits));
+				return sign | static_cast<uint16_t>(shiftedBits - magicBits);
+			}
+			const uint32_t odd = bits >> 13 & 1;
+			bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF + odd;
+			return sign | static_cast<uint16_t>(bits >> 13);
+		}
+
+		// Direction through the texel center of a face, following the GL cube map face layout
+		void getDirection(int face, float s, float t, float* direction)
+		{
+			switch (face)
+			{
+			case 0: direction[0] = 1.0f; direction[1] = -t; direction[2] = -s; break;
+			case 1: direction[0] = -1.0f; direction[1] = -t; direction[2] = s; break;
+			case 2: direction[0] = s; direction[1] = 1.0f; direction[2] = t; break;
+			case 3: direction[0] = s; direction[1] = -1.0f; direction[2] = -t; break;
+			case 4: direction[0] = s; direction[1] = -t; direction[2] = 1.0f; break;
+			default: direction[0] = -s; direction[1] = -t; direction[2] = -1.0f; break;
+			}
+		}
+
+		// Bilinear lookup, wrapping around horizontally and clamped at the poles
+		void sampleEquirectangular(const float* image, int width, int height, const float* direction, float* color)
+		{
+			const float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+			const float u = std::atan2(direction[0], -direction[2]) / (2.0f * PI) + 0.5f;
+			const float v = std::acos(std::min(std::max(direction[1] / length, -1.0f), 1.0f)) / PI;
+			const float x = u * width - 0.5f, y = std::min(std::max(v * height - 0.5f, 0.0f), height - 1.0f);
+			const int x0 = static_cast<int>(std::floor(x)), y0 = static_cast<int>(y);
+			const float fx = x - x0, fy = y - y0;
+			const int left = (x0 % width + width) % width, right = (left + 1) % width, y1 = std::min(y0 + 1, height - 1);
+			const float* row0 = image + static_cast<size_t>(y0) * width * 3;
+			const float* row1 = image + static_cast<size_t>(y1) * width * 3;
+			for (int c = 0; c < 3; ++c)
+			{
+				const float top = row0[left * 3 + c] + (row0[right * 3 + c] - row0[left * 3 + c]) * fx;
+				const float bottom = row1[left * 3 + c] + (row1[right * 3 + c] - row1[left * 3 + c]) * fx;
+				color[c] = top + (bottom - top) * fy;
+			}
+		}
+
+		// Runs the function over ranges of the given rows on every hardware thread
+		template <typename Function>
+		void forEachRows(int numRows, const Function& function)
+		{
+			const int numThreads = std::min(std::max(static_cast<int>(std::thread::hardware_concurrency()), 1), numRows);
+			std::vector<std::thread> threads;
+			const int rowsPerThread = (numRows + numThreads - 1) / numThreads;
+			for (int begin = rowsPerThread; begin < numRows; begin += rowsPerThread)
+			{
+				threads.emplace_back(function, begin, std::min(begin + rowsPerThread, numRows));
+			}
+			function(0, std::min(rowsPerThread, numRows));
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		// Returns the faces of every level as RGB floats, each level's faces back to back
+		std::vector<std::vector<float>> convertToCubemap(const float* image, int width, int height, int resolution)
+		{
+			std::vector<std::vector<float>> levels(1, std::vector<float>(static_cast<size_t>(resolution) * resolution * 3 * NUM_CUBEMAP_FACES));
+			// Every face row is its own work item. The texels average a 2x2 grid of bilinear taps, which keeps the
+			// rows squeezed together towards the poles from aliasing.
+			float* faces = levels[0].data();
+			forEachRows(resolution * NUM_CUBEMAP_FACES, [&](int begin, int end)
+			{
+				for (int row = begin; row < end; ++row)
+				{
+					const int face = row / resolution, y = row % resolution;
+					float* texel = faces + static_cast<size_t>(row) * resolution * 3;
+					for (int x = 0; x < resolution; ++x, texel += 3)
+					{
+						texel[0] = texel[1] = texel[2] = 0.0f;
+						for (int i = 0; i < 4; ++i)
+						{
+							const float s = 2.0f * (x + 0.25f + 0.5f * (i & 1)) / resolution - 1.0f;
+							const float t = 2.0f * (y + 0.25f + 0.5f * (i >> 1)) / resolution - 1.0f;
+							float direction[3], color[3];
+							getDirection(face, s, t, direction);
+							sampleEquirectangular(image, width, height, direction, color);
+							for (int c = 0; c < 3; ++c)
+							{
+								texel[c] += color[c] * 0.25f;
+							}
+						}
+					}
+				}
+			});
+
+			// 2x2 box filter per face, like glGenerateMipmap
+			while (resolution > 1)
+			{
+				const int mipResolution = resolution / 2;
+				const std::vector<float>& previous = levels.back();
+				std::vector<float> level(static_cast<size_t>(mipResolution) * mipResolution * 3 * NUM_CUBEMAP_FACES);
+				for (int row = 0; row < mipResolution * static_cast<int>(NUM_CUBEMAP_FACES); ++row)
+				{
+					const int face = row / mipResolution, y = row % mipResolution;
+					const float* row0 = previous.data() + (static_cast<size_t>(face) * resolution + y * 2) * resolution * 3;
+					const float* row1 = row0 + resolution * 3;
+					float* texel = level.data() + static_cast<size_t>(row) * mipResolution * 3;
+					for (int x = 0; x < mipResolution; ++x, texel += 3)
+					{
+						for (int c = 0; c < 3; ++c)
+						{
+							texel[c] = (row0[x * 6 + c] + row0[x * 6 + 3 + c] + row1[x * 6 + c] + row1[x * 6 + 3 + c]) * 0.25f;
+						}
+					}
+				}
+				levels.push_back(std::move(level));
+				resolution = mipResolution;
+			}
+			return levels;
+		}
+	}
+
+	bool decodeRadiance(const unsigned char* data, size_t size, int& width, int& height, std::vector<float>& texels)
+	{
+		const unsigned char* end = data + size;
+		std::string line;
+		if (!readLine(data, end, line) || (line != "#?RADIANCE" && line != "#?RGBE"))
+		{
+			return false;
+		}
+		while (readLine(data, end, line) && !line.empty())
+		{
+			if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+			{
+				return false;
+			}
+		}
+		// Only the standard orientation, rows top to bottom and texels left to right
+		if (!readLine(data, end, line) || std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2 || width <= 0 || height <= 0)
+		{
+			return false;
+		}
+
+		texels.resize(static_cast<size_t>(width) * height * 3);
+		std::vector<unsigned char> planes(static_cast<size_t>(width) * 4);
+		for (int y = 0; y < height; ++y)
+		{
+			// Files where scanlines don't start with the run-length marker store flat RGBE texels throughout
+			const bool encoded = width >= 8 && width < 0x8000 && end - data >= 4 && data[0] == 2 && data[1] == 2 && !(data[2] & 0x80);
+			if (encoded)
+			{
+				if ((data[2] << 8 | data[3]) != width)
+				{
+					return false;
+				}
+				data += 4;
+				for (int c = 0; c < 4; ++c)
+				{
+					if (!decodeRuns(data, end, width, planes.data() + static_cast<size_t>(c) * width))
+					{
+						return false;
+					}
+				}
+			}
+			else
+			{
+				if (static_cast<size_t>(end - data) < static_cast<size_t>(width) * 4)
+				{
+					return false;
+				}
+				for (int x = 0; x < width; ++x, data += 4)
+				{
+					for (int c = 0; c < 4; ++c)
+					{
+						planes[static_cast<size_t>(c) * width + x] = data[c];
+					}
+				}
+			}
+			convertScanline(planes.data(), width, texels.data() + static_cast<size_t>(y) * width * 3);
+		}
+		return true;
+	}
+
+	std::string EnvironmentMap::getCachePath(const std::string& sourceFilename)
+	{
+		return sourceFilename + ".pxec";
+	}
+
+	EnvironmentMap::EnvironmentMap(const std::string& sourceFilename, int resolution) : _file(getCachePath(sourceFilename))
+	{
+		if (!_file.isOpen() || _file.size() < sizeof(Header))
+		{
+			return;
+		}
+
+		const unsigned char* data = _file.data();
+		const Header* header = reinterpret_cast<const Header*>(data);
+		if (std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) || header->_version != VERSION || header->_resolution != static_cast<uint32_t>(resolution)
+			|| _file.size() < sizeof(Header) + header->_numLevels * sizeof(LevelRecord))
+		{
+			return;
+		}
+		// Archived copies were checked against their source when packed. Otherwise a differing timestamp alone only
+		// costs hashing the source, which is still far cheaper than converting it again.
+		if (!_file.isArchived())
+		{
+			uint64_t sourceSize;
+			int64_t sourceTimestamp;
+			if (!MappedFile::getFileInfo(sourceFilename, sourceSize, sourceTimestamp) || sourceSize != header->_sourceSize)
+			{
+				return;
+			}
+			if (sourceTimestamp != header->_sourceTimestamp)
+			{
+				MappedFile source(sourceFilename);
+				if (!source.isOpen() || AssetArchive::getHash(source.data(), source.size()) != header->_sourceHash)
+				{
+					return;
+				}
+			}
+		}
+
+		const LevelRecord* records = reinterpret_cast<const LevelRecord*>(data + sizeof(Header));
+		for (size_t i = 0; i < header->_numLevels; ++i)
+		{
+			if (records[i]._offset + records[i]._faceSize * NUM_CUBEMAP_FACES > _file.size())
+			{
+				std::cerr << "Corrupt environment map for " << sourceFilename << "!\n";
+				_levels.clear();
+				return;
+			}
+			_levels.emplace_back(Level{ data + records[i]._offset, static_cast<size_t>(records[i]._faceSize), static_cast<int>(records[i]._resolution) });
+		}
+		_valid = !_levels.empty();
+	}
+
+	unsigned int EnvironmentMap::upload() const
+	{
+		unsigned int textureID;
+		glGenTextures(1, &textureID);
+		GLState::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+		// Rows of RGB16F are only 2 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+		for (size_t i = 0; i < _levels.size(); ++i)
+		{
+			for (size_t face = 0; face < NUM_CUBEMAP_FACES; ++face)
+			{
+				StagingRing::getInstance().uploadTexture(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, i, GL_RGB16F, _levels[i]._resolution, _levels[i]._resolution, GL_RGB,
+					GL_HALF_FLOAT, _levels[i]._data + face * _levels[i]._faceSize, _levels[i]._faceSize);
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, _levels.size() - 1);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		return textureID;
+	}
+
+	bool EnvironmentMap::cook(const std::string& sourceFilename, int resolution)
+	{
+		Header header;
+		std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+		header._version = VERSION;
+		MappedFile source(sourceFilename);
+		if (!source.isOpen() || !MappedFile::getFileInfo(sourceFilename, header._sourceSize, header._sourceTimestamp))
+		{
+			std::cerr << "Failed to load file: " << sourceFilename << "\n";
+			return false;
+		}
+		header._sourceHash = AssetArchive::getHash(source.data(), source.size());
+		header._resolution = static_cast<uint32_t>(resolution);
+
+		int width, height;
+		std::vector<float> image;
+		if (!decodeRadiance(source.data(), source.size(), width, height, image))
+		{
+			std::cerr << "Invalid Radiance HDR image " << sourceFilename << "!\n";
+			return false;
+		}
+		const std::vector<std::vector<float>> levels = convertToCubemap(image.data(), width, height, resolution);
+		header._numLevels = static_cast<uint32_t>(levels.size());
+
+		std::vector<LevelRecord> records;
+		uint64_t offset = sizeof(Header) + levels.size() * sizeof(LevelRecord);
+		for (const auto& level : levels)
+		{
+			offset = align(offset);
+			records.emplace_back(LevelRecord{ offset, level.size() / NUM_CUBEMAP_FACES * sizeof(uint16_t), static_cast<uint32_t>(resolution), 0 });
+			offset += level.size() * sizeof(uint16_t);
+			resolution = std::max(resolution / 2, 1);
+		}
+
+		const std::string cachePath = getCachePath(sourceFilename);
+		std::ofstream stream(cachePath, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			std::cerr << "Could not write environment map " << cachePath << "!\n";
+			return false;
+		}
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		stream.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(LevelRecord));
+		const char padding[BLOB_ALIGNMENT] = {};
+		std::vector<uint16_t> halves;
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			halves.resize(levels[i].size());
+			std::transform(levels[i].begin(), levels[i].end(), halves.begin(), toHalf);
+			stream.write(padding, records[i]._offset - static_cast<uint64_t>(stream.tellp()));
+			stream.write(reinterpret_cast<const char*>(halves.data()), halves.size() * sizeof(uint16_t));
+		}
+		return static_cast<bool>(stream);
+	}
+
+	unsigned int EnvironmentMap::load(const std::string& sourceFilename, int resolution)
+	{
+		std::unique_ptr<EnvironmentMap> environmentMap(new EnvironmentMap(sourceFilename, resolution));
+		if (!environmentMap->isValid() && cook(sourceFilename, resolution))
+		{
+			environmentMap.reset(new EnvironmentMap(sourceFilename, resolution));
+		}
+		return environmentMap->isValid() ? environmentMap->upload() : 0;
+	}
+}
\ No newline at end of file
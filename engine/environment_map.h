@@ -0,0 +1,48 @@
+#pragma once
+#include <engine/mapped_file.h>
+
+#include <string>
+#include <vector>
+
+namespace phoenix
+{
+	// Cube map converted on the CPU from an equirectangular Radiance HDR image, with every mip level precomputed in
+	// RGB16F. The file is a header followed by a level table and the six faces of each level back to back, uploaded
+	// straight from the mapped pages. It is keyed by a content hash of the source, so a touched but unchanged source
+	// still hits, and needs no GL context to be converted, which lets it run as a bake step.
+	class EnvironmentMap
+	{
+	public:
+		struct Level
+		{
+			const unsigned char* _data; // Faces in GL order, +X first
+			size_t _faceSize;
+			int _resolution;
+		};
+
+		std::vector<Level> _levels;
+
+		// Maps the converted file for the given source, if one exists at this face resolution and is still up to date
+		EnvironmentMap(const std::string&, int);
+
+		inline bool isValid() const
+		{
+			return _valid;
+		}
+		// Creates the GL cube map from every level, on the GL thread
+		unsigned int upload() const;
+
+		static std::string getCachePath(const std::string&);
+		// Decodes the source, resamples it to the faces of the given resolution, builds their mip chain and writes the file
+		static bool cook(const std::string&, int);
+		// Uploads the converted cube map, converting the source first if needed. Returns 0 on failure.
+		static unsigned int load(const std::string&, int);
+
+	private:
+		MappedFile _file;
+		bool _valid = false;
+	};
+
+	// Decodes a Radiance RGBE image, flat or run-length encoded, to RGB floats with the first row at the top
+	bool decodeRadiance(const unsigned char*, size_t, int&, int&, std::vector<float>&);
+}
\ No newline at end of file
@@ -1,98 +1,255 @@
 #include <engine/framebuffer.h>
+#include <engine/gl_state.h>
 #include <engine/strings.h>
 #include <engine/common.h>
+#include <algorithm>
 #include <iostream>
+#include <tuple>
 
 namespace phoenix
 {
-	void Framebuffer::genColorMemoryAttachment(bool clampToBorder, bool hasAlpha)
+	bool Framebuffer::Attachment::operator<(const Attachment& attachment) const
 	{
-		glGenTextures(1, &_textureID);
-		glBindTexture(GL_TEXTURE_2D, _textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, hasAlpha ? GL_RGBA32F : GL_RGB16F, _width, _height, 0, GL_RGBA, GL_FLOAT, nullptr);
+		return std::tie(_internalFormat, _clampToBorder, _filter) < std::tie(attachment._internalFormat, attachment._clampToBorder, attachment._filter);
+	}
+
+	bool Framebuffer::Desc::operator<(const Desc& desc) const
+	{
+		return std::tie(_width, _height, _colorAttachments, _depthAttachment, _depthRenderbuffer, _layers, _samples)
+			< std::tie(desc._width, desc._height, desc._colorAttachments, desc._depthAttachment, desc._depthRenderbuffer, desc._layers, desc._samples);
+	}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		if (clampToBorder)
+	Framebuffer::Framebuffer(const Desc& desc) : _width(desc._width), _height(desc._height), _textureID(0), _desc(desc)
+	{
+		GLState& state = GLState::getInstance();
+		const unsigned int previousDrawFBO = state.getFramebuffer(GL_DRAW_FRAMEBUFFER), previousReadFBO = state.getFramebuffer(GL_READ_FRAMEBUFFER);
+		glGenFramebuffers(1, &_FBO);
+		state.bindFramebuffer(GL_FRAMEBUFFER, _FBO);
+
+		std::vector<GLenum> drawBuffers;
+		for (const Attachment& attachment : _desc._colorAttachments)
+		{
+			_colorTextures.push_back(genAttachmentTexture(attachment));
+			drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(drawBuffers.size()));
+			glFramebufferTexture(GL_FRAMEBUFFER, drawBuffers.back(), _colorTextures.back(), 0);
+		}
+		if (drawBuffers.empty())
 		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, phoenix::BORDER_COLOR);
+			// Depth only, the fragment shaders' outputs go nowhere
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
 		}
 		else
 		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glDrawBuffers(static_cast<int>(drawBuffers.size()), drawBuffers.data());
 		}
-	}
 
-	void Framebuffer::setZBufferMemoryAttachment()
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, _FBO);
-		glBindRenderbuffer(GL_RENDERBUFFER, _RBO);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _width, _height);
-	}
+		if (_desc._depthAttachment._internalFormat != GL_NONE)
+		{
+			if (_desc._depthRenderbuffer && _desc._layers == 0)
+			{
+				glGenRenderbuffers(1, &_RBO);
+				glBindRenderbuffer(GL_RENDERBUFFER, _RBO);
+				glRenderbufferStorageMultisample(GL_RENDERBUFFER, _desc._samples, _desc._depthAttachment._internalFormat, _width, _height);
+				glBindRenderbuffer(GL_RENDERBUFFER, 0);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, getDepthAttachmentPoint(), GL_RENDERBUFFER, _RBO);
+			}
+			else
+			{
+				_depthTexture = genAttachmentTexture(_desc._depthAttachment);
+				glFramebufferTexture(GL_FRAMEBUFFER, getDepthAttachmentPoint(), _depthTexture, 0);
+			}
+		}
+		_textureID = _colorTextures.empty() ? _depthTexture : _colorTextures[0];
 
-	void Framebuffer::unbindFBOAndZBufferAttachment()
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, _previousFBO);
-		glBindRenderbuffer(GL_RENDERBUFFER, 0);
 		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		{
 			std::cerr << phoenix::FRAMEBUFFER_INIT_ERROR;
 		}
+		state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDrawFBO);
+		state.bindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFBO);
+	}
+
+	Framebuffer& Framebuffer::acquire(const Desc& desc)
+	{
+		auto& acquired = getAcquired();
+		auto it = acquired.find(desc);
+		if (it == acquired.end())
+		{
+			it = acquired.emplace(desc, std::unique_ptr<Framebuffer>(new Framebuffer(desc))).first;
+		}
+		return *it->second;
 	}
 
-	void Framebuffer::setupFramebuffer()
+	void Framebuffer::releaseAcquired()
 	{
-		glGenFramebuffers(1, &_FBO); 
-		glGenRenderbuffers(1, &_RBO);
+		getAcquired().clear();
+	}
 
-		setZBufferMemoryAttachment();
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + _numAttachments++, GL_TEXTURE_2D, _textureID, 0);
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _RBO);
+	bool Framebuffer::isDepthFormat(GLenum internalFormat)
+	{
+		return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24 || internalFormat == GL_DEPTH_COMPONENT32
+			|| internalFormat == GL_DEPTH_COMPONENT32F || internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8;
+	}
 
-		unbindFBOAndZBufferAttachment();
+	size_t Framebuffer::getTexelSize(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+		case GL_RGBA32F:
+			return 16;
+		case GL_RGB32F:
+			return 12;
+		case GL_RGBA16F:
+		case GL_RG32F:
+		case GL_DEPTH32F_STENCIL8:
+			return 8;
+		case GL_RGB16F:
+			return 6;
+		case GL_R8:
+			return 1;
+		case GL_RG8:
+		case GL_R16F:
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		case GL_DEPTH_COMPONENT24:
+			return 3;
+		default:
+			return 4;
+		}
 	}
 
-	Framebuffer::Framebuffer(unsigned int width, unsigned int height, bool clampToBorder, bool hasAlpha) : _width(width), _height(height)
+	size_t Framebuffer::getMemorySize() const
 	{
-		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &_previousFBO);
-		genColorMemoryAttachment(clampToBorder, hasAlpha);
-		setupFramebuffer();
+		size_t texelSize = 0;
+		for (const Attachment& attachment : _desc._colorAttachments)
+		{
+			texelSize += getTexelSize(attachment._internalFormat);
+		}
+		if (_desc._depthAttachment._internalFormat != GL_NONE)
+		{
+			texelSize += getTexelSize(_desc._depthAttachment._internalFormat);
+		}
+		return static_cast<size_t>(_width) * _height * texelSize * std::max(_desc._layers, 1u) * std::max(_desc._samples, 1u);
 	}
 
 	void Framebuffer::bindTexture(const Shader& shader, const std::string& name, int textureUnit)
 	{
-		glActiveTexture(GL_TEXTURE0 + textureUnit);
-		glBindTexture(GL_TEXTURE_2D, _textureID);
+		GLState::getInstance().activeTexture(GL_TEXTURE0 + textureUnit);
+		GLState::getInstance().bindTexture(getTextureTarget(), _textureID);
 		shader.setInt(name, textureUnit);
 	}
 
-	unsigned int Framebuffer::genAttachment(GLenum internalFormat, GLenum format, GLenum type, bool clampToBorder, GLenum minFilter, GLenum magFilter)
+	void Framebuffer::attachLayer(int layer)
 	{
-		unsigned int textureID;
+		GLState& state = GLState::getInstance();
+		const unsigned int previousDrawFBO = state.getFramebuffer(GL_DRAW_FRAMEBUFFER), previousReadFBO = state.getFramebuffer(GL_READ_FRAMEBUFFER);
+		state.bindFramebuffer(GL_FRAMEBUFFER, _FBO);
+		auto attach = [layer](GLenum attachmentPoint, unsigned int texture)
+		{
+			if (layer < 0)
+			{
+				glFramebufferTexture(GL_FRAMEBUFFER, attachmentPoint, texture, 0);
+			}
+			else
+			{
+				glFramebufferTextureLayer(GL_FRAMEBUFFER, attachmentPoint, texture, 0, layer);
+			}
+		};
+		for (size_t i = 0; i < _colorTextures.size(); ++i)
+		{
+			attach(GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i), _colorTextures[i]);
+		}
+		if (_depthTexture)
+		{
+			attach(getDepthAttachmentPoint(), _depthTexture);
+		}
+		state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDrawFBO);
+		state.bindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFBO);
+	}
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, _width, _height, 0, format, type, nullptr);
+	void Framebuffer::blit(const Framebuffer& target, GLbitfield mask) const
+	{
+		GLState& state = GLState::getInstance();
+		const unsigned int previousDrawFBO = state.getFramebuffer(GL_DRAW_FRAMEBUFFER), previousReadFBO = state.getFramebuffer(GL_READ_FRAMEBUFFER);
+		state.bindFramebuffer(GL_READ_FRAMEBUFFER, _FBO);
+		state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, target._FBO);
+		glBlitFramebuffer(0, 0, _width, _height, 0, 0, target._width, target._height, mask, GL_NEAREST);
+		state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDrawFBO);
+		state.bindFramebuffer(GL_READ_FRAMEBUFFER, previousReadFBO);
+	}
+
+	Framebuffer::~Framebuffer()
+	{
+		GLState& state = GLState::getInstance();
+		state.deleteTextures(static_cast<int>(_colorTextures.size()), _colorTextures.data());
+		if (_depthTexture)
+		{
+			state.deleteTextures(1, &_depthTexture);
+		}
+		if (_RBO)
+		{
+			glDeleteRenderbuffers(1, &_RBO);
+		}
+		state.deleteFramebuffers(1, &_FBO);
+	}
+
+	std::map<Framebuffer::Desc, std::unique_ptr<Framebuffer>>& Framebuffer::getAcquired()
+	{
+		static std::map<Desc, std::unique_ptr<Framebuffer>> acquired;
+		return acquired;
+	}
+
+	GLenum Framebuffer::getTextureTarget() const
+	{
+		if (_desc._samples)
+		{
+			return _desc._layers ? GL_TEXTURE_2D_MULTISAMPLE_ARRAY : GL_TEXTURE_2D_MULTISAMPLE;
+		}
+		return _desc._layers ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+	}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
-		if (clampToBorder)
+	unsigned int Framebuffer::genAttachmentTexture(const Attachment& attachment) const
+	{
+		const GLenum target = getTextureTarget();
+		unsigned int textureID;
+		glGenTextures(1, &textureID);
+		GLState::getInstance().bindTexture(target, textureID);
+		switch (target)
 		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, phoenix::BORDER_COLOR);
+		case GL_TEXTURE_2D_MULTISAMPLE_ARRAY:
+			glTexStorage3DMultisample(target, _desc._samples, attachment._internalFormat, _width, _height, _desc._layers, GL_TRUE);
+			return textureID;
+		case GL_TEXTURE_2D_MULTISAMPLE:
+			glTexStorage2DMultisample(target, _desc._samples, attachment._internalFormat, _width, _height, GL_TRUE);
+			return textureID;
+		case GL_TEXTURE_2D_ARRAY:
+			glTexStorage3D(target, 1, attachment._internalFormat, _width, _height, _desc._layers);
+			break;
+		default:
+			glTexStorage2D(target, 1, attachment._internalFormat, _width, _height);
+			break;
 		}
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + _numAttachments++, GL_TEXTURE_2D, textureID, 0);
 
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, attachment._filter);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, attachment._filter);
+		if (attachment._clampToBorder)
+		{
+			glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+			glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, phoenix::BORDER_COLOR);
+		}
+		else
+		{
+			glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		}
 		return textureID;
 	}
 
-	Framebuffer::~Framebuffer()
+	GLenum Framebuffer::getDepthAttachmentPoint() const
 	{
-		glDeleteTextures(1, &_textureID);
-		glDeleteFramebuffers(1, &_FBO);
+		const GLenum internalFormat = _desc._depthAttachment._internalFormat;
+		return internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
 	}
 }
\ No newline at end of file
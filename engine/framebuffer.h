@@ -1,27 +1,92 @@
 #pragma once
 #include <engine/shader.h>
 
+#include <map>
+#include <memory>
+#include <vector>
+
 namespace phoenix
 {
+	// Render target built from a description of its attachments. Every attachment is a texture of its own format, and
+	// only the attachments described are created, so a shadow map can be depth alone and a G-buffer can mix formats.
+	// Layered framebuffers attach 2D array textures whole for layered rendering, or one layer at a time.
 	class Framebuffer
 	{
 	public:
+		// Multisampled textures have no sampler state, so the wrap and filter of those are ignored
+		struct Attachment
+		{
+			GLenum _internalFormat = GL_NONE;
+			bool _clampToBorder = false;
+			GLenum _filter = GL_NEAREST;
+
+			bool operator<(const Attachment&) const;
+		};
+
+		struct Desc
+		{
+			unsigned int _width = 0, _height = 0;
+			std::vector<Attachment> _colorAttachments;
+			// GL_NONE for no depth, the depth-stencil formats add a stencil buffer
+			Attachment _depthAttachment = Attachment();
+			// A renderbuffer is enough for depth that is only tested against, never for layered framebuffers
+			bool _depthRenderbuffer = false;
+			unsigned int _layers = 0, _samples = 0; // 0 for plain and single sampled textures
+
+			bool operator<(const Desc&) const;
+		};
+
+		// First color attachment, or the depth texture of framebuffers without color
 		unsigned int _width, _height, _FBO, _textureID;
 
-		Framebuffer(unsigned int, unsigned int, bool = false, bool = false);
+		explicit Framebuffer(const Desc&);
+
+		// Shared framebuffer of the description, created on first use. Only for passes that don't need what another
+		// pass with the same description left in it.
+		static Framebuffer& acquire(const Desc&);
+		// Deletes the shared framebuffers, which has to happen while the context is still alive
+		static void releaseAcquired();
+
+		static bool isDepthFormat(GLenum);
+		// Nominal bytes per texel, drivers may pad three channel and 24-bit depth formats
+		static size_t getTexelSize(GLenum);
+
+		inline const Desc& getDesc() const
+		{
+			return _desc;
+		}
+		inline unsigned int getColorTexture(size_t index) const
+		{
+			return _colorTextures[index];
+		}
+		// 0 without a depth texture
+		inline unsigned int getDepthTexture() const
+		{
+			return _depthTexture;
+		}
+		// Memory of all the attachments at their nominal size, samples and layers included
+		size_t getMemorySize() const;
 
 		void bindTexture(const Shader&, const std::string&, int = GL_TEXTURE0);
-		unsigned int genAttachment(GLenum, GLenum, GLenum, bool = false, GLenum = GL_NEAREST, GLenum = GL_NEAREST);
+		// Attaches a single layer of every attachment, or all of them again for a negative layer
+		void attachLayer(int);
+		// Blits the given buffers into another framebuffer of the same size, resolving multisampled attachments
+		void blit(const Framebuffer&, GLbitfield) const;
 
 		~Framebuffer();
 
 	private:
-		unsigned int _RBO, _numAttachments = 0;
-		int _previousFBO;
+		Desc _desc;
+		std::vector<unsigned int> _colorTextures;
+		unsigned int _depthTexture = 0, _RBO = 0;
+
+		static std::map<Desc, std::unique_ptr<Framebuffer>>& getAcquired();
+
+		Framebuffer(Framebuffer const&) = delete;
+		void operator=(Framebuffer const&) = delete;
 
-		void genColorMemoryAttachment(bool = false, bool = false);
-		void setZBufferMemoryAttachment();
-		void unbindFBOAndZBufferAttachment();
-		void setupFramebuffer();
+		GLenum getTextureTarget() const;
+		unsigned int genAttachmentTexture(const Attachment&) const;
+		GLenum getDepthAttachmentPoint() const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include <engine/geometry_arena.h>
+#include <engine/gl_state.h>
+#include <engine/common.h>
+#include <engine/staging_ring.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+
+namespace phoenix
+{
+	namespace
+	{
+		// Copies the contents over to a bigger buffer, the old one is deleted
+		unsigned int resizeBuffer(unsigned int buffer, size_t oldSize, size_t newSize)
+		{
+			unsigned int newBuffer;
+			glGenBuffers(1, &newBuffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+			if (buffer)
+			{
+				glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+				glDeleteBuffers(1, &buffer);
+			}
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			return newBuffer;
+		}
+	}
+
+	bool GeometryArena::RangeAllocator::allocate(unsigned int size, unsigned int& offset)
+	{
+		for (auto it = _freeRanges.begin(); it != _freeRanges.end(); ++it)
+		{
+			if (it->second >= size)
+			{
+				offset = it->first;
+				if (it->second > size)
+				{
+					_freeRanges.emplace(it->first + size, it->second - size);
+				}
+				_freeRanges.erase(it);
+				_used += size;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void GeometryArena::RangeAllocator::free(unsigned int offset, unsigned int size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		_used -= size;
+		auto it = _freeRanges.emplace(offset, size).first;
+		auto next = std::next(it);
+		if (next != _freeRanges.end() && it->first + it->second == next->first)
+		{
+			it->second += next->second;
+			_freeRanges.erase(next);
+		}
+		if (it != _freeRanges.begin())
+		{
+			auto previous = std::prev(it);
+			if (previous->first + previous->second == it->first)
+			{
+				previous->second += it->second;
+				_freeRanges.erase(it);
+			}
+		}
+	}
+
+	void GeometryArena::RangeAllocator::grow(unsigned int capacity)
+	{
+		const unsigned int oldCapacity = _capacity;
+		_capacity = capacity;
+		// Hands the new tail out as free space, merging it with a free range at the old end
+		_used += capacity - oldCapacity;
+		free(oldCapacity, capacity - oldCapacity);
+	}
+
+	GeometryArena& GeometryArena::getInstance(VertexFormat vertexFormat)
+	{
+		static GeometryArena unpacked(UNPACKED), packed(PACKED);
+		return vertexFormat == PACKED ? packed : unpacked;
+	}
+
+	GeometryArena::GeometryArena(VertexFormat vertexFormat) : _vertexFormat(vertexFormat), _vertexSize(getVertexSize(vertexFormat)) {}
+
+	GeometryArena::Allocation GeometryArena::allocate(const void* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices)
+	{
+		Allocation allocation{ 0, numVertices, 0, numIndices };
+		const bool verticesFit = _vertices.allocate(numVertices, allocation._baseVertex);
+		const bool indicesFit = _indices.allocate(numIndices, allocation._firstIndex);
+		if (!verticesFit || !indicesFit)
+		{
+			reserve(verticesFit ? 0 : numVertices, indicesFit ? 0 : numIndices);
+			if (!verticesFit)
+			{
+				_vertices.allocate(numVertices, allocation._baseVertex);
+			}
+			if (!indicesFit)
+			{
+				_indices.allocate(numIndices, allocation._firstIndex);
+			}
+		}
+
+		StagingRing& ring = StagingRing::getInstance();
+		ring.upload(_VBO, static_cast<size_t>(allocation._baseVertex) * _vertexSize, vertices, static_cast<size_t>(numVertices) * _vertexSize);
+		ring.upload(_EBO, static_cast<size_t>(allocation._firstIndex) * sizeof(unsigned int), indices, static_cast<size_t>(numIndices) * sizeof(unsigned int));
+		return allocation;
+	}
+
+	void GeometryArena::free(const Allocation& allocation)
+	{
+		_vertices.free(allocation._baseVertex, allocation._numVertices);
+		_indices.free(allocation._firstIndex, allocation._numIndices);
+	}
+
+	void GeometryArena::reserve(unsigned int numVertices, unsigned int numIndices)
+	{
+		// Doubling keeps the number of copies logarithmic, the grown tail alone has room for the request
+		unsigned int vertexCapacity = _vertices._capacity;
+		if (numVertices)
+		{
+			vertexCapacity = std::max(vertexCapacity, ARENA_MIN_VERTICES);
+			while (vertexCapacity < _vertices._capacity + numVertices)
+			{
+				vertexCapacity *= 2;
+			}
+		}
+		unsigned int indexCapacity = _indices._capacity;
+		if (numIndices)
+		{
+			indexCapacity = std::max(indexCapacity, ARENA_MIN_INDICES);
+			while (indexCapacity < _indices._capacity + numIndices)
+			{
+				indexCapacity *= 2;
+			}
+		}
+
+		if (!_VAO)
+		{
+			glGenVertexArrays(1, &_VAO);
+		}
+		GLState::getInstance().bindVertexArray(_VAO);
+		if (vertexCapacity != _vertices._capacity)
+		{
+			_VBO = resizeBuffer(_VBO, static_cast<size_t>(_vertices._capacity) * _vertexSize, static_cast<size_t>(vertexCapacity) * _vertexSize);
+			_vertices.grow(vertexCapacity);
+			glBindBuffer(GL_ARRAY_BUFFER, _VBO);
+			setVertexAttributes(_vertexFormat);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		if (indexCapacity != _indices._capacity)
+		{
+			_EBO = resizeBuffer(_EBO, static_cast<size_t>(_indices._capacity) * sizeof(unsigned int), static_cast<size_t>(indexCapacity) * sizeof(unsigned int));
+			_indices.grow(indexCapacity);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO);
+		}
+		GLState::getInstance().bindVertexArray(0);
+	}
+
+	void GeometryArena::printStats() const
+	{
+		std::cout << "Geometry arena (" << (_vertexFormat == PACKED ? "packed" : "unpacked") << "): " << _vertices._used << "/" << _vertices._capacity << " vertices, "
+			<< _indices._used << "/" << _indices._capacity << " indices, " << (static_cast<size_t>(_vertices._capacity) * _vertexSize
+			+ static_cast<size_t>(_indices._capacity) * sizeof(unsigned int)) / (1024.0 * 1024.0) << " MB\n";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <engine/vertex_format.h>
+
+#include <map>
+
+namespace phoenix
+{
+	// Suballocates static geometry of one vertex format from a shared vertex and index buffer behind a single VAO.
+	// Indices stay relative to their allocation and are offset by the base vertex when drawn. Buffers double in size
+	// when they run out of space, so the arena grows to the working set instead of being sized up front.
+	class GeometryArena
+	{
+	public:
+		struct Allocation
+		{
+			unsigned int _baseVertex, _numVertices, _firstIndex, _numIndices;
+		};
+
+		static GeometryArena& getInstance(VertexFormat);
+
+		Allocation allocate(const void*, unsigned int, const unsigned int*, unsigned int);
+		void free(const Allocation&);
+
+		inline unsigned int getVAO() const
+		{
+			return _VAO;
+		}
+		void printStats() const;
+
+	private:
+		// First fit over a sorted free list, adjacent free ranges are merged
+		class RangeAllocator
+		{
+		public:
+			unsigned int _capacity = 0, _used = 0;
+
+			bool allocate(unsigned int, unsigned int&);
+			void free(unsigned int, unsigned int);
+			void grow(unsigned int);
+
+		private:
+			std::map<unsigned int, unsigned int> _freeRanges; // Offset to size
+		};
+
+		VertexFormat _vertexFormat;
+		unsigned int _vertexSize, _VAO = 0, _VBO = 0, _EBO = 0;
+		RangeAllocator _vertices, _indices;
+
+		GeometryArena(VertexFormat);
+		GeometryArena(GeometryArena const&) = delete;
+		void operator=(GeometryArena const&) = delete;
+
+		void reserve(unsigned int, unsigned int);
+	};
+}
\ No newline at end of file
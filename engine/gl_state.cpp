@@ -0,0 +1,286 @@
+#include <engine/gl_state.h>
+#include <engine/render_stats.h>
+
+namespace phoenix
+{
+	namespace
+	{
+		int getTargetIndex(GLenum target)
+		{
+			switch (target)
+			{
+			case GL_TEXTURE_2D:
+				return 0;
+			case GL_TEXTURE_3D:
+				return 1;
+			case GL_TEXTURE_CUBE_MAP:
+				return 2;
+			case GL_TEXTURE_2D_ARRAY:
+				return 3;
+			default:
+				return -1;
+			}
+		}
+
+		int getCapabilityIndex(GLenum capability)
+		{
+			switch (capability)
+			{
+			case GL_DEPTH_TEST:
+				return 0;
+			case GL_CULL_FACE:
+				return 1;
+			case GL_BLEND:
+				return 2;
+			case GL_MULTISAMPLE:
+				return 3;
+			default:
+				return -1;
+			}
+		}
+	}
+
+	GLState& GLState::getInstance()
+	{
+		static GLState instance;
+		return instance;
+	}
+
+	GLState::GLState()
+	{
+		invalidate();
+	}
+
+	void GLState::useProgram(unsigned int program)
+	{
+		if (changes(program != _program))
+		{
+			glUseProgram(program);
+			_program = program;
+		}
+	}
+
+	void GLState::bindVertexArray(unsigned int vertexArray)
+	{
+		if (changes(vertexArray != _vertexArray))
+		{
+			glBindVertexArray(vertexArray);
+			_vertexArray = vertexArray;
+			++RenderStats::getInstance()._numVAOBinds;
+		}
+	}
+
+	void GLState::bindFramebuffer(GLenum target, unsigned int framebuffer)
+	{
+		const bool draw = target != GL_READ_FRAMEBUFFER, read = target != GL_DRAW_FRAMEBUFFER;
+		if (changes((draw && framebuffer != _drawFramebuffer) || (read && framebuffer != _readFramebuffer)))
+		{
+			glBindFramebuffer(target, framebuffer);
+			_drawFramebuffer = draw ? framebuffer : _drawFramebuffer;
+			_readFramebuffer = read ? framebuffer : _readFramebuffer;
+		}
+	}
+
+	void GLState::activeTexture(GLenum texture)
+	{
+		const unsigned int unit = texture - GL_TEXTURE0;
+		if (changes(unit != _activeTexture))
+		{
+			glActiveTexture(texture);
+			_activeTexture = unit;
+		}
+	}
+
+	void GLState::bindTexture(GLenum target, unsigned int texture)
+	{
+		// Units past the mirrored ones and other targets are always bound
+		const int targetIndex = getTargetIndex(target);
+		unsigned int* binding = targetIndex >= 0 && _activeTexture < MAX_TEXTURE_UNITS ? &_textures[_activeTexture][targetIndex] : nullptr;
+		if (changes(!binding || texture != *binding))
+		{
+			glBindTexture(target, texture);
+			if (binding)
+			{
+				*binding = texture;
+			}
+			++RenderStats::getInstance()._numTextureBinds;
+		}
+	}
+
+	void GLState::enable(GLenum capability)
+	{
+		setCapability(capability, true);
+	}
+
+	void GLState::disable(GLenum capability)
+	{
+		setCapability(capability, false);
+	}
+
+	void GLState::cullFace(GLenum mode)
+	{
+		if (changes(mode != _cullFace))
+		{
+			glCullFace(mode);
+			_cullFace = mode;
+		}
+	}
+
+	void GLState::blendFunc(GLenum source, GLenum destination)
+	{
+		if (changes(source != _blendSource || destination != _blendDestination))
+		{
+			glBlendFunc(source, destination);
+			_blendSource = source;
+			_blendDestination = destination;
+		}
+	}
+
+	void GLState::depthFunc(GLenum func)
+	{
+		if (changes(func != _depthFunc))
+		{
+			glDepthFunc(func);
+			_depthFunc = func;
+		}
+	}
+
+	void GLState::depthMask(GLboolean flag)
+	{
+		const int mask = flag ? 1 : 0;
+		if (changes(mask != _depthMask))
+		{
+			glDepthMask(flag);
+			_depthMask = mask;
+		}
+	}
+
+	void GLState::colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+	{
+		const int mask = (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0) | (alpha ? 8 : 0);
+		if (changes(mask != _colorMask))
+		{
+			glColorMask(red, green, blue, alpha);
+			_colorMask = mask;
+		}
+	}
+
+	void GLState::viewport(int x, int y, int width, int height)
+	{
+		if (changes(x != _viewport[0] || y != _viewport[1] || width != _viewport[2] || height != _viewport[3]))
+		{
+			glViewport(x, y, width, height);
+			_viewport[0] = x;
+			_viewport[1] = y;
+			_viewport[2] = width;
+			_viewport[3] = height;
+		}
+	}
+
+	void GLState::deleteTextures(int n, const unsigned int* textures)
+	{
+		// Deleting a bound object reverts its bindings to 0
+		glDeleteTextures(n, textures);
+		for (int i = 0; i < n; ++i)
+		{
+			for (auto& unit : _textures)
+			{
+				for (auto& binding : unit)
+				{
+					binding = binding == textures[i] ? 0 : binding;
+				}
+			}
+		}
+	}
+
+	void GLState::deleteFramebuffers(int n, const unsigned int* framebuffers)
+	{
+		glDeleteFramebuffers(n, framebuffers);
+		for (int i = 0; i < n; ++i)
+		{
+			_drawFramebuffer = _drawFramebuffer == framebuffers[i] ? 0 : _drawFramebuffer;
+			_readFramebuffer = _readFramebuffer == framebuffers[i] ? 0 : _readFramebuffer;
+		}
+	}
+
+	void GLState::deleteVertexArrays(int n, const unsigned int* vertexArrays)
+	{
+		glDeleteVertexArrays(n, vertexArrays);
+		for (int i = 0; i < n; ++i)
+		{
+			_vertexArray = _vertexArray == vertexArrays[i] ? 0 : _vertexArray;
+		}
+	}
+
+	unsigned int GLState::getFramebuffer(GLenum target) const
+	{
+		const bool read = target == GL_READ_FRAMEBUFFER;
+		const unsigned int framebuffer = read ? _readFramebuffer : _drawFramebuffer;
+		if (framebuffer != UNKNOWN)
+		{
+			return framebuffer;
+		}
+		int binding;
+		glGetIntegerv(read ? GL_READ_FRAMEBUFFER_BINDING : GL_DRAW_FRAMEBUFFER_BINDING, &binding);
+		return static_cast<unsigned int>(binding);
+	}
+
+	unsigned int GLState::getTexture(GLenum target) const
+	{
+		const int targetIndex = getTargetIndex(target);
+		if (targetIndex < 0 || _activeTexture >= MAX_TEXTURE_UNITS || _textures[_activeTexture][targetIndex] == UNKNOWN)
+		{
+			return 0;
+		}
+		return _textures[_activeTexture][targetIndex];
+	}
+
+	void GLState::invalidate()
+	{
+		_program = _vertexArray = _drawFramebuffer = _readFramebuffer = _activeTexture = UNKNOWN;
+		for (auto& unit : _textures)
+		{
+			for (auto& binding : unit)
+			{
+				binding = UNKNOWN;
+			}
+		}
+		for (auto& capability : _capabilities)
+		{
+			capability = -1;
+		}
+		_cullFace = _blendSource = _blendDestination = _depthFunc = GL_NONE;
+		_depthMask = _colorMask = -1;
+		for (auto& value : _viewport)
+		{
+			value = -1;
+		}
+	}
+
+	void GLState::setCapability(GLenum capability, bool enabled)
+	{
+		const int index = getCapabilityIndex(capability);
+		if (changes(index < 0 || _capabilities[index] != static_cast<int>(enabled)))
+		{
+			if (enabled)
+			{
+				glEnable(capability);
+			}
+			else
+			{
+				glDisable(capability);
+			}
+			if (index >= 0)
+			{
+				_capabilities[index] = enabled;
+			}
+		}
+	}
+
+	bool GLState::changes(bool changed) const
+	{
+		RenderStats& stats = RenderStats::getInstance();
+		++(changed ? stats._numStateChanges : stats._numFilteredStateChanges);
+		return changed;
+	}
+}
\ No newline at end of file
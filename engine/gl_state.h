@@ -0,0 +1,62 @@
+#pragma once
+#include <glad/glad.h>
+
+namespace phoenix
+{
+	// Mirror of the GL state that changes between passes and draws: program, VAO, framebuffers, texture bindings,
+	// the depth, cull and blend switches and their functions, masks and viewport. Calls that leave the state as it is
+	// are dropped, the rest go to GL and update the mirror. Anything that changes this state has to go through here,
+	// or the mirror goes stale, and objects have to be deleted through here so their names can't alias new ones.
+	// Only functions and capabilities without a slot in the mirror pass straight through.
+	class GLState
+	{
+	public:
+		static GLState& getInstance();
+
+		void useProgram(unsigned int);
+		void bindVertexArray(unsigned int);
+		void bindFramebuffer(GLenum, unsigned int);
+		void activeTexture(GLenum);
+		void bindTexture(GLenum, unsigned int);
+		void enable(GLenum);
+		void disable(GLenum);
+		void cullFace(GLenum);
+		void blendFunc(GLenum, GLenum);
+		void depthFunc(GLenum);
+		void depthMask(GLboolean);
+		void colorMask(GLboolean, GLboolean, GLboolean, GLboolean);
+		void viewport(int, int, int, int);
+
+		void deleteTextures(int, const unsigned int*);
+		void deleteFramebuffers(int, const unsigned int*);
+		void deleteVertexArrays(int, const unsigned int*);
+
+		// Framebuffer bound to the target, asked from GL if it isn't known so that it can always be bound again
+		unsigned int getFramebuffer(GLenum) const;
+		// Texture bound to the target of the active unit, or 0 if it isn't known
+		unsigned int getTexture(GLenum) const;
+
+		// Forgets everything, so the next call of each kind is issued whatever it sets
+		void invalidate();
+
+	private:
+		static const unsigned int MAX_TEXTURE_UNITS = 32, NUM_TEXTURE_TARGETS = 4, NUM_CAPABILITIES = 4;
+		static const unsigned int UNKNOWN = ~0u;
+
+		unsigned int _program, _vertexArray, _drawFramebuffer, _readFramebuffer;
+		unsigned int _activeTexture;
+		unsigned int _textures[MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+		int _capabilities[NUM_CAPABILITIES]; // -1 when unknown
+		GLenum _cullFace, _blendSource, _blendDestination, _depthFunc;
+		int _depthMask, _colorMask; // Masks packed as bits, -1 when unknown
+		int _viewport[4];
+
+		GLState();
+		GLState(GLState const&) = delete;
+		void operator=(GLState const&) = delete;
+
+		void setCapability(GLenum, bool);
+		// Counts the call towards the issued or the filtered state changes and returns whether it has to be issued
+		bool changes(bool) const;
+	};
+}
\ No newline at end of file
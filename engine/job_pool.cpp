@@ -0,0 +1,140 @@
+#include <engine/job_pool.h>
+#include <algorithm>
+
+namespace phoenix
+{
+	namespace
+	{
+		// Queue of the calling thread, workers set their own
+		thread_local unsigned int threadIndex = 0;
+	}
+
+	JobPool& JobPool::getInstance()
+	{
+		static JobPool instance;
+		return instance;
+	}
+
+	JobPool::JobPool(unsigned int numThreads) : _numQueued(0)
+	{
+		// The threads outside the pool make up for the one worker less
+		numThreads = std::max(numThreads, 1u);
+		for (unsigned int i = 0; i < numThreads; ++i)
+		{
+			_queues.emplace_back(new Queue());
+		}
+		for (unsigned int i = 1; i < numThreads; ++i)
+		{
+			_workers.emplace_back(&JobPool::work, this, i);
+		}
+	}
+
+	void JobPool::parallelFor(size_t count, size_t rangeSize, const std::function<void(size_t, size_t)>& function)
+	{
+		rangeSize = std::max(rangeSize, size_t(1));
+		if (count <= rangeSize || _workers.empty())
+		{
+			if (count)
+			{
+				function(0, count);
+			}
+			return;
+		}
+
+		const size_t numRanges = (count + rangeSize - 1) / rangeSize;
+		std::atomic<size_t> remaining(numRanges - 1);
+		const unsigned int index = threadIndex;
+		{
+			// Counted before they are pushed, so a thief popping one right away can't take the count below zero
+			std::lock_guard<std::mutex> lock(_mutex);
+			_numQueued += numRanges - 1;
+		}
+		{
+			// Queued last to first, so this thread pops the early ranges while thieves take the late ones
+			Queue& queue = *_queues[index];
+			std::lock_guard<std::mutex> lock(queue._mutex);
+			for (size_t range = numRanges - 1; range > 0; --range)
+			{
+				const size_t begin = range * rangeSize, end = std::min(begin + rangeSize, count);
+				queue._jobs.emplace_back([&function, &remaining, begin, end]()
+				{
+					function(begin, end);
+					remaining.fetch_sub(1, std::memory_order_release);
+				});
+			}
+		}
+		_jobQueued.notify_all();
+
+		function(0, rangeSize);
+		while (remaining.load(std::memory_order_acquire))
+		{
+			// Anything will do, the ranges left may be running elsewhere or be stuck behind other jobs
+			if (!runJob(index))
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	JobPool::~JobPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_jobQueued.notify_all();
+		for (auto& worker : _workers)
+		{
+			worker.join();
+		}
+	}
+
+	void JobPool::work(unsigned int index)
+	{
+		threadIndex = index;
+		while (true)
+		{
+			if (runJob(index))
+			{
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(_mutex);
+			_jobQueued.wait(lock, [this] { return _stopping || _numQueued > 0; });
+			if (_stopping)
+			{
+				return;
+			}
+		}
+	}
+
+	bool JobPool::runJob(unsigned int index)
+	{
+		Job job;
+		for (size_t i = 0; i < _queues.size() && !job; ++i)
+		{
+			Queue& queue = *_queues[(index + i) % _queues.size()];
+			std::lock_guard<std::mutex> lock(queue._mutex);
+			if (queue._jobs.empty())
+			{
+				continue;
+			}
+			if (i == 0)
+			{
+				job = std::move(queue._jobs.back());
+				queue._jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(queue._jobs.front());
+				queue._jobs.pop_front();
+			}
+		}
+		if (!job)
+		{
+			return false;
+		}
+		--_numQueued;
+		job();
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phoenix
+{
+	// Work-stealing pool for the CPU side of a frame. Every thread has a queue of its own, pushes and pops its jobs at
+	// the back, and steals from the front of the others once it runs dry, so threads mostly stay on their own recent
+	// work and only contend when the load is uneven. Threads outside the pool share the first queue and work along
+	// while they wait for their jobs, which may queue jobs of their own.
+	class JobPool
+	{
+	public:
+		static JobPool& getInstance();
+
+		// Workers plus the threads outside the pool
+		inline unsigned int getNumThreads() const
+		{
+			return static_cast<unsigned int>(_queues.size());
+		}
+		// Calls the function on ranges of at most the given size covering [0, count), in any order and on any thread.
+		// Returns once every range is done.
+		void parallelFor(size_t, size_t, const std::function<void(size_t, size_t)>&);
+
+		~JobPool();
+
+	private:
+		typedef std::function<void()> Job;
+
+		struct Queue
+		{
+			std::mutex _mutex;
+			std::deque<Job> _jobs;
+		};
+
+		std::vector<std::unique_ptr<Queue>> _queues;
+		std::vector<std::thread> _workers;
+		std::atomic<size_t> _numQueued;
+		bool _stopping = false;
+		std::mutex _mutex;
+		std::condition_variable _jobQueued;
+
+		JobPool(unsigned int = std::thread::hardware_concurrency());
+		JobPool(JobPool const&) = delete;
+		void operator=(JobPool const&) = delete;
+
+		void work(unsigned int);
+		// Runs a job from the thread's own queue or, failing that, one stolen from another. False if all are empty.
+		bool runJob(unsigned int);
+	};
+}
\ No newline at end of file
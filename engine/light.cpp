@@ -2,24 +2,9 @@
 
 namespace phoenix
 {
-	void PointLight::setUniforms(const Shader& shader)
+	PointLight::Block PointLight::getBlock() const
 	{
-		shader.setVec3("gPointLight._position", _position);
-		shader.setVec3("gPointLight._light._color", _color);
-		shader.setFloat("gPointLight._light._intensity", _intensity);
-		shader.setFloat("gPointLight._attenuation._constant", _attenuation._constant);
-		shader.setFloat("gPointLight._attenuation._linear", _attenuation._linear);
-		shader.setFloat("gPointLight._attenuation._quadratic", _attenuation._quadratic);
-	}
-
-	void PointLight::setUniforms(const Shader& shader, unsigned int index)
-	{
-		shader.setVec3("gPointLights[" + std::to_string(index) + "]._position", _position);
-		shader.setVec3("gPointLights[" + std::to_string(index) + "]._light._color", _color);
-		shader.setFloat("gPointLights[" + std::to_string(index) + "]._light._intensity", _intensity);
-		shader.setFloat("gPointLights[" + std::to_string(index) + "]._attenuation._constant", _attenuation._constant);
-		shader.setFloat("gPointLights[" + std::to_string(index) + "]._attenuation._linear", _attenuation._linear);
-		shader.setFloat("gPointLights[" + std::to_string(index) + "]._attenuation._quadratic", _attenuation._quadratic);
+		return Block{ _color, _intensity, _position, 0.0f, _attenuation._constant, _attenuation._linear, _attenuation._quadratic, 0.0f };
 	}
 
 	void DirectLight::setUniforms(const Shader& shader)
@@ -17,8 +17,17 @@ namespace phoenix
 			float _constant = 1.0f, _linear = 0.0f, _quadratic = 1.0f;
 		} _attenuation;
 
-		void setUniforms(const Shader&);
-		void setUniforms(const Shader&, unsigned int);
+		// std140 layout of the PointLight struct in the shaders
+		struct Block
+		{
+			glm::vec3 _color;
+			float _intensity;
+			glm::vec3 _position;
+			float _padding0;
+			float _constant, _linear, _quadratic, _padding1;
+		};
+
+		Block getBlock() const;
 	};
 
 	struct DirectLight : public Light
@@ -0,0 +1,130 @@
+#include <engine/mapped_file.h>
+#include <engine/asset_archive.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace phoenix
+{
+	bool MappedFile::getFileInfo(const std::string& filename, uint64_t& size, int64_t& timestamp)
+	{
+		struct stat info;
+		if (stat(filename.c_str(), &info) != 0)
+		{
+			return false;
+		}
+		size = static_cast<uint64_t>(info.st_size);
+		timestamp = static_cast<int64_t>(info.st_mtime);
+		return true;
+	}
+
+	bool MappedFile::mapFromArchive(const std::string& filename)
+	{
+		const AssetArchive::View view = AssetArchive::findMounted(filename);
+		if (!view._data)
+		{
+			return false;
+		}
+		_data = view._data;
+		_size = view._size;
+		_archived = true;
+		return true;
+	}
+
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& filename)
+	{
+		if (mapFromArchive(filename))
+		{
+			return;
+		}
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+		_file = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			return;
+		}
+
+		_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mapping)
+		{
+			return;
+		}
+
+		_data = static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (_data)
+		{
+			_size = static_cast<size_t>(size.QuadPart);
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (_data && !_archived)
+		{
+			UnmapViewOfFile(_data);
+		}
+		if (_mapping)
+		{
+			CloseHandle(_mapping);
+		}
+		if (_file)
+		{
+			CloseHandle(_file);
+		}
+	}
+#else
+	MappedFile::MappedFile(const std::string& filename)
+	{
+		if (mapFromArchive(filename))
+		{
+			return;
+		}
+		_file = open(filename.c_str(), O_RDONLY);
+		if (_file < 0)
+		{
+			return;
+		}
+
+		struct stat info;
+		if (fstat(_file, &info) != 0 || info.st_size == 0)
+		{
+			return;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+		if (data != MAP_FAILED)
+		{
+			_data = static_cast<const unsigned char*>(data);
+			_size = static_cast<size_t>(info.st_size);
+		}
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (_data && !_archived)
+		{
+			munmap(const_cast<unsigned char*>(_data), _size);
+		}
+		if (_file >= 0)
+		{
+			close(_file);
+		}
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace phoenix
+{
+	// Read-only view of an entire file mapped into our address space, or of its copy in the mounted asset archive
+	class MappedFile
+	{
+	public:
+		MappedFile(const std::string&);
+
+		inline bool isOpen() const
+		{
+			return _data != nullptr;
+		}
+		inline const unsigned char* data() const
+		{
+			return _data;
+		}
+		inline size_t size() const
+		{
+			return _size;
+		}
+		// Served from the mounted asset archive rather than the file system
+		inline bool isArchived() const
+		{
+			return _archived;
+		}
+
+		// Size and modification time, which cooked files record to detect stale copies of their source
+		static bool getFileInfo(const std::string&, uint64_t&, int64_t&);
+
+		~MappedFile();
+
+	private:
+		const unsigned char* _data = nullptr;
+		size_t _size = 0;
+		bool _archived = false;
+#ifdef _WIN32
+		void* _file = nullptr;
+		void* _mapping = nullptr;
+#else
+		int _file = -1;
+#endif
+
+		bool mapFromArchive(const std::string&);
+
+		MappedFile(MappedFile const&) = delete;
+		void operator=(MappedFile const&) = delete;
+	};
+}
\ No newline at end of file
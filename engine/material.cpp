@@ -2,16 +2,8 @@
 
 namespace phoenix
 {
-	void Material::setUniforms(const Shader& shader)
+	Material::Block Material::getBlock() const
 	{
-		shader.use();
-
-		shader.setVec3("gMaterial._diffuseColor", _diffuseColor);
-		shader.setVec3("gMaterial._specularColor", _specularColor);
-
-		shader.setFloat("gMaterial._specularReflectivity", _specularReflectivity);
-		shader.setFloat("gMaterial._diffuseReflectivity", _diffuseReflectivity);
-		shader.setFloat("gMaterial._emissivity", _emissivity);
-		shader.setFloat("gMaterial._aperture", _aperture);
+		return Block{ _diffuseColor, 0.0f, _specularColor, _specularReflectivity, _diffuseReflectivity, _emissivity, _aperture, 0.0f };
 	}
 }
\ No newline at end of file
@@ -11,7 +11,16 @@ namespace phoenix
 		Material(const glm::vec3 diffuseColor = glm::vec3(1.0f))
 			: _diffuseColor(diffuseColor), _specularColor(diffuseColor) {}
 
-		void setUniforms(const Shader&);
+		// std140 layout of the Material struct in the shaders
+		struct Block
+		{
+			glm::vec3 _diffuseColor;
+			float _padding0;
+			glm::vec3 _specularColor;
+			float _specularReflectivity, _diffuseReflectivity, _emissivity, _aperture, _padding1;
+		};
+
+		Block getBlock() const;
 
 		static Material* defaultMaterial()
 		{
@@ -1,4 +1,5 @@
 #include <engine/material_store.h>
+#include <engine/common.h>
 #include <iostream>
 
 namespace phoenix
@@ -8,7 +9,8 @@ namespace phoenix
 		_materials.emplace("voxelize", new Shader("../Resources/Shaders/voxel_cone_tracing/voxelize.vs", "../Resources/Shaders/voxel_cone_tracing/voxelize.gs", "../Resources/Shaders/voxel_cone_tracing/voxelize.fs"));
 		_materials.emplace("world_position_output", new Shader("../Resources/Shaders/voxel_cone_tracing/world_position_output.vs", "../Resources/Shaders/voxel_cone_tracing/world_position_output.fs"));
 		_materials.emplace("visualize_voxels", new Shader("../Resources/Shaders/voxel_cone_tracing/visualize_voxels.vs", "../Resources/Shaders/voxel_cone_tracing/visualize_voxels.fs"));
-		_materials.emplace("render", new Shader("../Resources/Shaders/voxel_cone_tracing/render.vs", "../Resources/Shaders/voxel_cone_tracing/render.fs"));
+		_materials.emplace("render", new Shader("../Resources/Shaders/voxel_cone_tracing/render.vs", "../Resources/Shaders/voxel_cone_tracing/render.fs",
+			{ { "VOXEL_RES", std::to_string(VOXEL_GRID_RES) }, { "NUM_STEPS", std::to_string(VOXEL_CONE_TRACING_STEPS) } }));
 	}
 
 	MaterialStore& MaterialStore::getInstance()
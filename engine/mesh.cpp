@@ -1,84 +1,270 @@
 #include <engine/mesh.h>
+#include <engine/gl_state.h>
+#include <engine/common.h>
+#include <engine/render_stats.h>
+#include <engine/staging_ring.h>
 #include <engine/strings.h>
+#include <engine/texture_registry.h>
 #include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
 
 namespace phoenix
 {
-	Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures) : _numIndices(indices.size()), _textures(textures)
+	namespace
 	{
+		// Sampler names of every texture type by index, built once rather than on every bind
+		const std::string& getSamplerName(TextureType type, unsigned int index)
+		{
+			static const std::string* const PREFIXES[] = { nullptr, &G_DIFFUSE_MAP, &G_SPECULAR_MAP, &G_AMBIENT_MAP, &G_BUMP_MAP, &G_OPACITY_MAP };
+			static const std::string NONE_NAME;
+			static std::vector<std::string> names[OPACITY + 1];
+			if (!PREFIXES[type])
+			{
+				return NONE_NAME;
+			}
+			while (names[type].size() <= index)
+			{
+				names[type].push_back(*PREFIXES[type] + std::to_string(names[type].size()));
+			}
+			return names[type][index];
+		}
+	}
+
+	Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures, VertexFormat vertexFormat, const std::vector<MeshLod>& lods,
+		const std::vector<Meshlet>& meshlets, GeometryArena* arena) : Mesh(vertices.data(), vertices.size(), indices.data(), indices.size(), textures, vertexFormat, lods, meshlets, arena) {}
+
+	Mesh::Mesh(const Vertex* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices, const std::vector<Texture>& textures, VertexFormat vertexFormat,
+		const std::vector<MeshLod>& lods, const std::vector<Meshlet>& meshlets, GeometryArena* arena) : _vertexFormat(vertexFormat), _textures(textures), _lods(lods),
+		_meshlets(meshlets)
+	{
+		if (_lods.empty())
+		{
+			_lods.push_back(MeshLod{ 0, numIndices, numVertices, 0.0f });
+		}
+
+		if (numVertices)
+		{
+			glm::vec3 min = vertices[0]._position, max = min;
+			for (size_t i = 1; i < numVertices; ++i)
+			{
+				min = glm::min(min, vertices[i]._position);
+				max = glm::max(max, vertices[i]._position);
+			}
+			_boundingCenter = (min + max) * 0.5f;
+			_boundingRadius = glm::length(max - min) * 0.5f;
+		}
+
+		const void* vertexData = vertices;
+		std::vector<PackedVertex> packedVertices;
+		if (vertexFormat == PACKED)
+		{
+			PackingError error;
+			_dequantization = packVertices(vertices, numVertices, packedVertices, error);
+			error.print(numVertices);
+			vertexData = packedVertices.data();
+		}
+
+		if (arena)
+		{
+			_arena = arena;
+			_allocation = arena->allocate(vertexData, numVertices, indices, numIndices);
+			_VAO = arena->getVAO();
+			return;
+		}
+
+		_allocation = GeometryArena::Allocation{ 0, numVertices, 0, numIndices };
 		glGenVertexArrays(1, &_VAO);
-		unsigned int VBO, EBO;
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
-
-		glBindVertexArray(_VAO);
-
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, _numIndices * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _normal));
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _texCoords));
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _tangent));
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _bitangent));
-		glBindVertexArray(0);
+		glGenBuffers(1, &_VBO);
+		glGenBuffers(1, &_EBO);
+
+		const size_t vertexBytes = numVertices * getVertexSize(vertexFormat), indexBytes = numIndices * sizeof(unsigned int);
+		GLState::getInstance().bindVertexArray(_VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, _VBO);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+		setVertexAttributes(vertexFormat);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+		GLState::getInstance().bindVertexArray(0);
+		StagingRing::getInstance().upload(_VBO, 0, vertexData, vertexBytes);
+		StagingRing::getInstance().upload(_EBO, 0, indices, indexBytes);
 	}
 
 	void Mesh::render()
 	{
-		glBindVertexArray(_VAO);
-		glDrawElements(GL_TRIANGLES, _numIndices, GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+		RenderStats& stats = RenderStats::getInstance();
+		GLState::getInstance().bindVertexArray(_VAO);
+		if (_culled && _lod == 0)
+		{
+			// Drawn straight from the staging ring
+			StagingRing& ring = StagingRing::getInstance();
+			const size_t offset = _drawCommands.empty() ? SIZE_MAX : ring.stage(_drawCommands.data(), _drawCommands.size() * sizeof(DrawElementsIndirectCommand));
+			if (offset != SIZE_MAX)
+			{
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.getBuffer());
+				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)offset, _drawCommands.size(), 0);
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+				++stats._numDrawCalls;
+				stats._numDrawCommands += _drawCommands.size();
+			}
+		}
+		else
+		{
+			const MeshLod& lod = _lods[_lod];
+			glDrawElementsBaseVertex(GL_TRIANGLES, lod._numIndices, GL_UNSIGNED_INT, (void*)((_allocation._firstIndex + lod._firstIndex) * sizeof(unsigned int)),
+				_allocation._baseVertex);
+			++stats._numDrawCalls;
+			++stats._numDrawCommands;
+		}
+		// The VAO stays bound, the next draw from it needs no bind at all
+		_culled = false;
 	}
 
-	void Mesh::render(const Shader& shader)
+	void Mesh::getDrawCommands(std::vector<DrawElementsIndirectCommand>& commands)
 	{
-		unsigned int numDiffuseMaps = 0;
-		unsigned int numSpecularMaps = 0;
-		unsigned int numAmbientMaps = 0;
-		unsigned int numBumpMaps = 0;
-		unsigned int numOpacityMaps = 0;
-		for (size_t i = 0; i < _textures.size(); ++i)
+		if (_culled && _lod == 0)
+		{
+			commands.insert(commands.end(), _drawCommands.begin(), _drawCommands.end());
+		}
+		else
+		{
+			const MeshLod& lod = _lods[_lod];
+			commands.push_back(DrawElementsIndirectCommand{ lod._numIndices, 1, _allocation._firstIndex + lod._firstIndex, _allocation._baseVertex, 0 });
+		}
+		_culled = false;
+	}
+
+	unsigned int Mesh::cull(const glm::mat4& world, const glm::mat4& viewProjection, const glm::vec3& viewPos, bool cullBackfaces)
+	{
+		_drawCommands.clear();
+		_culled = !_meshlets.empty();
+		unsigned int numVisible = 0;
+		if (!_culled)
+		{
+			return numVisible;
+		}
+
+		// Frustum planes in world space (Gribb and Hartmann), normals pointing inwards
+		const glm::mat4 m = glm::transpose(viewProjection);
+		glm::vec4 planes[6] = { m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2] };
+		for (auto& plane : planes)
 		{
-			glActiveTexture(GL_TEXTURE0 + i);
+			plane /= glm::length(glm::vec3(plane));
+		}
+		const float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world)));
 
-			std::string name;
-			switch (_textures[i]._textureType)
+		for (const auto& meshlet : _meshlets)
+		{
+			const glm::vec3 center = glm::vec3(world * glm::vec4(meshlet._center, 1.0f));
+			const float radius = meshlet._radius * scale;
+			bool visible = true;
+			for (int i = 0; i < 6 && visible; ++i)
+			{
+				visible = glm::dot(glm::vec3(planes[i]), center) + planes[i].w > -radius;
+			}
+			if (visible && cullBackfaces && meshlet._coneCutoff < 1.0f)
+			{
+				const glm::vec3 toCenter = center - viewPos;
+				const float distance = glm::length(toCenter);
+				visible = distance <= radius || glm::dot(toCenter / distance, glm::normalize(normalMatrix * meshlet._coneAxis)) < meshlet._coneCutoff + radius / distance;
+			}
+			if (!visible)
+			{
+				continue;
+			}
+
+			++numVisible;
+			const unsigned int firstIndex = _allocation._firstIndex + meshlet._firstIndex;
+			if (!_drawCommands.empty() && _drawCommands.back()._firstIndex + _drawCommands.back()._count == firstIndex)
+			{
+				_drawCommands.back()._count += meshlet._numIndices;
+			}
+			else
 			{
-			case DIFFUSE:
-				name = G_DIFFUSE_MAP + std::to_string(numDiffuseMaps++);
-				break;
-			case SPECULAR:
-				name = G_SPECULAR_MAP + std::to_string(numSpecularMaps++);
-				break;
-			case AMBIENT:
-				name = G_AMBIENT_MAP + std::to_string(numAmbientMaps++);
-				break;
-			case HEIGHT:
-				name = G_BUMP_MAP + std::to_string(numBumpMaps++);
-				break;
-			case OPACITY:
-				name = G_OPACITY_MAP + std::to_string(numOpacityMaps++);
-				break;
+				_drawCommands.push_back(DrawElementsIndirectCommand{ meshlet._numIndices, 1, firstIndex, _allocation._baseVertex, 0 });
 			}
+		}
+		return numVisible;
+	}
+
+	void Mesh::setLod(unsigned int lod)
+	{
+		_lod = std::min(lod, getNumLods() - 1);
+	}
 
-			glUniform1i(glGetUniformLocation(shader._program, name.c_str()), i);
-			glBindTexture(GL_TEXTURE_2D, _textures[i]._ID);
+	float Mesh::getScreenSize(const glm::mat4& world, const glm::mat4& view, const glm::mat4& projection, float viewportHeight) const
+	{
+		const glm::vec3 center = glm::vec3(view * world * glm::vec4(_boundingCenter, 1.0f));
+		const float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+		const float radius = _boundingRadius * scale;
+		if (projection[3][3] == 0.0f)
+		{
+			// Perspective, the sphere covers the whole screen once the camera is inside of it
+			const float distance = std::abs(center.z);
+			if (distance <= radius)
+			{
+				return std::numeric_limits<float>::max();
+			}
+			return radius * projection[1][1] / distance * viewportHeight;
 		}
+		return radius * projection[1][1] * viewportHeight;
+	}
 
+	unsigned int Mesh::selectLod(float screenSize, LodHint hint)
+	{
+		static const float LOD_HINT_SCALES[] = { 1.0f, 4.0f, 0.5f };
+		const float maxError = LOD_PIXEL_ERROR * LOD_HINT_SCALES[hint];
+		_lod = 0;
+		while (_lod + 1 < getNumLods() && _lods[_lod + 1]._error * screenSize <= maxError)
+		{
+			++_lod;
+		}
+		return _lod;
+	}
+
+	void Mesh::render(const Shader& shader)
+	{
+		if (_vertexFormat == PACKED)
+		{
+			std::cerr << PACKED_RENDER_ERROR;
+			return;
+		}
+		bindTextures(shader);
 		render();
 	}
 
+	void Mesh::bindTextures(const Shader& shader)
+	{
+		unsigned int numMaps[OPACITY + 1] = {};
+		for (size_t i = 0; i < _textures.size(); ++i)
+		{
+			GLState::getInstance().activeTexture(GL_TEXTURE0 + i);
+
+			const TextureType type = _textures[i]._textureType;
+			shader.setInt(getSamplerName(type, numMaps[type]++), static_cast<int>(i));
+			GLState::getInstance().bindTexture(GL_TEXTURE_2D, _textures[i]._ID);
+		}
+	}
+
 	Mesh::~Mesh()
 	{
-		glDeleteVertexArrays(1, &_VAO);
+		if (_arena)
+		{
+			_arena->free(_allocation);
+		}
+		else
+		{
+			GLState::getInstance().deleteVertexArrays(1, &_VAO);
+			glDeleteBuffers(1, &_VBO);
+			glDeleteBuffers(1, &_EBO);
+		}
+		for (auto& texture : _textures)
+		{
+			TextureRegistry::getInstance().release(texture._ID);
+		}
 		if (_material)
 		{
 			delete _material;
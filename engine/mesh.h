@@ -3,6 +3,8 @@
 
 #include <engine/shader.h>
 #include <engine/material.h>
+#include <engine/vertex_format.h>
+#include <engine/geometry_arena.h>
 
 #include <vector>
 
@@ -27,6 +29,38 @@ namespace phoenix
 		glm::vec3 _bitangent;
 	};
 
+	// Index range of one level of detail, all levels share the vertex buffer
+	struct MeshLod
+	{
+		unsigned int _firstIndex, _numIndices, _numVertices;
+		float _error; // Geometric deviation from LOD 0 relative to the mesh's bounding sphere diameter
+	};
+
+	// Contiguous run of LOD 0 triangles, small enough to be rejected on its own
+	struct Meshlet
+	{
+		glm::vec3 _center;
+		float _radius;
+		// Normal cone, every triangle faces away from viewers with dot(normalize(center - viewPos), axis) >= cutoff + radius / distance
+		glm::vec3 _coneAxis;
+		float _coneCutoff;
+		unsigned int _firstIndex, _numIndices;
+	};
+
+	// Layout consumed by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		unsigned int _count, _instanceCount, _firstIndex, _baseVertex, _baseInstance;
+	};
+
+	// How much geometric error a pass tolerates on top of LOD_PIXEL_ERROR
+	enum LodHint
+	{
+		LOD_MAIN,
+		LOD_SHADOW, // Filtered and rarely magnified, can go coarser
+		LOD_VOXELIZATION // Sizes are given in voxels rather than pixels
+	};
+
 	struct Texture
 	{
 		unsigned int _ID;
@@ -40,16 +74,77 @@ namespace phoenix
 		float _rotation = glm::radians(0.0f);
 		glm::vec3 _translation = glm::vec3(0.0f), _rotationAxis = glm::vec3(0.0f, 1.0f, 0.0f), _scale = glm::vec3(1.0f);
 		Material* _material = nullptr;
+		// Maps packed positions back to object space, to be folded into the world matrix. Identity when unpacked.
+		glm::mat4 _dequantization = glm::mat4(1.0f);
 
-		Mesh(const std::vector<Vertex>&, const std::vector<unsigned int>&, const std::vector<Texture> & = {});
+		// Without LODs the whole index buffer is a single level. Without an arena the mesh gets buffers of its own.
+		Mesh(const std::vector<Vertex>&, const std::vector<unsigned int>&, const std::vector<Texture> & = {}, VertexFormat = UNPACKED, const std::vector<MeshLod> & = {},
+			const std::vector<Meshlet> & = {}, GeometryArena* = nullptr);
+		Mesh(const Vertex*, unsigned int, const unsigned int*, unsigned int, const std::vector<Texture> & = {}, VertexFormat = UNPACKED, const std::vector<MeshLod> & = {},
+			const std::vector<Meshlet> & = {}, GeometryArena* = nullptr);
 
 		void render();
+		// Binds the textures first. Rejects packed meshes, whose _dequantization can't be folded in here.
 		void render(const Shader&);
+		void bindTextures(const Shader&);
+		// Appends what render would draw, with offsets into the shared buffers, and consumes the culling result like render
+		void getDrawCommands(std::vector<DrawElementsIndirectCommand>&);
+		inline const std::vector<Texture>& getTextures() const
+		{
+			return _textures;
+		}
+		inline VertexFormat getVertexFormat() const
+		{
+			return _vertexFormat;
+		}
+
+		inline unsigned int getNumLods() const
+		{
+			return _lods.size();
+		}
+		inline unsigned int getNumVertices(unsigned int lod) const
+		{
+			return _lods[lod]._numVertices;
+		}
+		inline unsigned int getNumTriangles(unsigned int lod) const
+		{
+			return _lods[lod]._numIndices / 3;
+		}
+		inline unsigned int getLod() const
+		{
+			return _lod;
+		}
+		void setLod(unsigned int);
+		inline const glm::vec3& getBoundingCenter() const
+		{
+			return _boundingCenter;
+		}
+		// Diameter of the bounding sphere in pixels, works with both perspective and orthographic projections
+		float getScreenSize(const glm::mat4&, const glm::mat4&, const glm::mat4&, float) const;
+		// Picks the coarsest LOD whose error stays below LOD_PIXEL_ERROR at the given screen size
+		unsigned int selectLod(float, LodHint = LOD_MAIN);
+
+		inline unsigned int getNumMeshlets() const
+		{
+			return _meshlets.size();
+		}
+		// Rejects the meshlets outside the frustum and, if back faces are culled in the pass, those facing away from
+		// the viewer. Only the next render call draws the survivors, and only at LOD 0. Returns the visible count.
+		unsigned int cull(const glm::mat4&, const glm::mat4&, const glm::vec3&, bool = true);
 
 		~Mesh();
 
 	private:
-		unsigned int _VAO, _numIndices;
+		unsigned int _VAO = 0, _VBO = 0, _EBO = 0, _lod = 0;
+		VertexFormat _vertexFormat;
+		GeometryArena* _arena = nullptr;
+		GeometryArena::Allocation _allocation;
 		std::vector<Texture> _textures;
+		std::vector<MeshLod> _lods;
+		std::vector<Meshlet> _meshlets;
+		std::vector<DrawElementsIndirectCommand> _drawCommands; // Visible meshlets, adjacent ones merged
+		bool _culled = false;
+		glm::vec3 _boundingCenter = glm::vec3(0.0f);
+		float _boundingRadius = 0.0f;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include <engine/mesh_cache.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace phoenix
+{
+	namespace
+	{
+		const char MAGIC[4] = { 'P', 'X', 'M', 'C' };
+		// Bump whenever the layout, the vertex format or the import post-processing changes
+		const uint32_t VERSION = 4;
+		const uint64_t BLOB_ALIGNMENT = 16;
+
+		struct Header
+		{
+			char _magic[4];
+			uint32_t _version;
+			uint64_t _sourceSize;
+			int64_t _sourceTimestamp;
+			uint32_t _vertexSize;
+			uint32_t _numMeshes;
+			uint32_t _numTextures;
+			uint32_t _numLods;
+			uint32_t _numMeshlets;
+			uint32_t _stringsSize;
+		};
+
+		struct MeshRecord
+		{
+			uint64_t _vertexOffset, _indexOffset;
+			uint32_t _numVertices, _numIndices;
+			uint32_t _firstTexture, _numTextures;
+			uint32_t _firstLod, _numLods;
+			uint32_t _firstMeshlet, _numMeshlets;
+		};
+
+		struct TextureRecord
+		{
+			uint32_t _textureType;
+			uint32_t _keyOffset, _keyLength;
+		};
+
+		uint64_t align(uint64_t offset)
+		{
+			return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+		}
+	}
+
+	std::string MeshCache::getCachePath(const std::string& sourceFilename)
+	{
+		return sourceFilename + ".pxmc";
+	}
+
+	MeshCache::MeshCache(const std::string& sourceFilename) : _file(getCachePath(sourceFilename))
+	{
+		if (!_file.isOpen() || _file.size() < sizeof(Header))
+		{
+			return;
+		}
+
+		const unsigned char* data = _file.data();
+		const Header* header = reinterpret_cast<const Header*>(data);
+		// Archived copies were checked against their source when packed, and the source need not ship with them
+		uint64_t sourceSize = header->_sourceSize;
+		int64_t sourceTimestamp = header->_sourceTimestamp;
+		if (!_file.isArchived() && !MappedFile::getFileInfo(sourceFilename, sourceSize, sourceTimestamp))
+		{
+			return;
+		}
+		if (std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) || header->_version != VERSION || header->_vertexSize != sizeof(Vertex)
+			|| header->_sourceSize != sourceSize || header->_sourceTimestamp != sourceTimestamp)
+		{
+			return;
+		}
+
+		const uint64_t tablesSize = sizeof(Header) + header->_numMeshes * sizeof(MeshRecord) + header->_numTextures * sizeof(TextureRecord)
+			+ header->_numLods * sizeof(MeshLod) + header->_numMeshlets * sizeof(Meshlet) + header->_stringsSize;
+		if (_file.size() < tablesSize)
+		{
+			return;
+		}
+		const MeshRecord* meshRecords = reinterpret_cast<const MeshRecord*>(data + sizeof(Header));
+		const TextureRecord* textureRecords = reinterpret_cast<const TextureRecord*>(meshRecords + header->_numMeshes);
+		const MeshLod* lods = reinterpret_cast<const MeshLod*>(textureRecords + header->_numTextures);
+		const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(lods + header->_numLods);
+		const char* strings = reinterpret_cast<const char*>(meshlets + header->_numMeshlets);
+
+		_entries.reserve(header->_numMeshes);
+		for (size_t i = 0; i < header->_numMeshes; ++i)
+		{
+			const MeshRecord& record = meshRecords[i];
+			if (record._vertexOffset + record._numVertices * sizeof(Vertex) > _file.size()
+				|| record._indexOffset + record._numIndices * sizeof(unsigned int) > _file.size()
+				|| record._firstTexture + record._numTextures > header->_numTextures
+				|| record._firstLod + record._numLods > header->_numLods
+				|| record._firstMeshlet + record._numMeshlets > header->_numMeshlets)
+			{
+				std::cerr << "Corrupt mesh cache for " << sourceFilename << "!\n";
+				_entries.clear();
+				return;
+			}
+
+			Entry entry;
+			entry._vertices = reinterpret_cast<const Vertex*>(data + record._vertexOffset);
+			entry._indices = reinterpret_cast<const unsigned int*>(data + record._indexOffset);
+			entry._numVertices = record._numVertices;
+			entry._numIndices = record._numIndices;
+			for (size_t j = record._firstTexture; j < record._firstTexture + record._numTextures; ++j)
+			{
+				const TextureRecord& texture = textureRecords[j];
+				if (static_cast<uint64_t>(texture._keyOffset) + texture._keyLength > header->_stringsSize)
+				{
+					std::cerr << "Corrupt mesh cache for " << sourceFilename << "!\n";
+					_entries.clear();
+					return;
+				}
+				entry._textures.emplace_back(Texture{ 0, static_cast<TextureType>(texture._textureType), std::string(strings + texture._keyOffset, texture._keyLength) });
+			}
+			// LODs and meshlets are index ranges of the mesh, drawn and culled without further checks
+			entry._lods.assign(lods + record._firstLod, lods + record._firstLod + record._numLods);
+			entry._meshlets.assign(meshlets + record._firstMeshlet, meshlets + record._firstMeshlet + record._numMeshlets);
+			const bool lodsValid = std::all_of(entry._lods.begin(), entry._lods.end(), [&record](const MeshLod& lod)
+			{
+				return static_cast<uint64_t>(lod._firstIndex) + lod._numIndices <= record._numIndices && lod._numVertices <= record._numVertices;
+			});
+			const bool meshletsValid = std::all_of(entry._meshlets.begin(), entry._meshlets.end(), [&record](const Meshlet& meshlet)
+			{
+				return static_cast<uint64_t>(meshlet._firstIndex) + meshlet._numIndices <= record._numIndices;
+			});
+			if (!lodsValid || !meshletsValid)
+			{
+				std::cerr << "Corrupt mesh cache for " << sourceFilename << "!\n";
+				_entries.clear();
+				return;
+			}
+			_entries.emplace_back(entry);
+		}
+
+		_valid = true;
+	}
+
+	bool MeshCache::write(const std::string& sourceFilename, const std::vector<MeshData>& meshes)
+	{
+		Header header;
+		std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+		header._version = VERSION;
+		if (!MappedFile::getFileInfo(sourceFilename, header._sourceSize, header._sourceTimestamp))
+		{
+			return false;
+		}
+		header._vertexSize = sizeof(Vertex);
+		header._numMeshes = static_cast<uint32_t>(meshes.size());
+
+		std::vector<MeshRecord> meshRecords;
+		std::vector<TextureRecord> textureRecords;
+		std::vector<MeshLod> lods;
+		std::vector<Meshlet> meshlets;
+		std::string strings;
+		for (auto& mesh : meshes)
+		{
+			MeshRecord record;
+			record._numVertices = static_cast<uint32_t>(mesh._vertices.size());
+			record._numIndices = static_cast<uint32_t>(mesh._indices.size());
+			record._firstTexture = static_cast<uint32_t>(textureRecords.size());
+			record._numTextures = static_cast<uint32_t>(mesh._textures.size());
+			record._firstLod = static_cast<uint32_t>(lods.size());
+			record._numLods = static_cast<uint32_t>(mesh._lods.size());
+			lods.insert(lods.end(), mesh._lods.begin(), mesh._lods.end());
+			record._firstMeshlet = static_cast<uint32_t>(meshlets.size());
+			record._numMeshlets = static_cast<uint32_t>(mesh._meshlets.size());
+			meshlets.insert(meshlets.end(), mesh._meshlets.begin(), mesh._meshlets.end());
+			for (auto& texture : mesh._textures)
+			{
+				textureRecords.emplace_back(TextureRecord{ static_cast<uint32_t>(texture._textureType), static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(texture._key.size()) });
+				strings += texture._key;
+			}
+			meshRecords.emplace_back(record);
+		}
+		header._numTextures = static_cast<uint32_t>(textureRecords.size());
+		header._numLods = static_cast<uint32_t>(lods.size());
+		header._numMeshlets = static_cast<uint32_t>(meshlets.size());
+		header._stringsSize = static_cast<uint32_t>(strings.size());
+
+		// Lay out the blobs after the tables
+		uint64_t offset = sizeof(Header) + meshRecords.size() * sizeof(MeshRecord) + textureRecords.size() * sizeof(TextureRecord)
+			+ lods.size() * sizeof(MeshLod) + meshlets.size() * sizeof(Meshlet) + strings.size();
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			offset = align(offset);
+			meshRecords[i]._vertexOffset = offset;
+			offset += meshes[i]._vertices.size() * sizeof(Vertex);
+			offset = align(offset);
+			meshRecords[i]._indexOffset = offset;
+			offset += meshes[i]._indices.size() * sizeof(unsigned int);
+		}
+
+		const std::string cachePath = getCachePath(sourceFilename);
+		std::ofstream stream(cachePath, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			std::cerr << "Could not write mesh cache " << cachePath << "!\n";
+			return false;
+		}
+
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		stream.write(reinterpret_cast<const char*>(meshRecords.data()), meshRecords.size() * sizeof(MeshRecord));
+		stream.write(reinterpret_cast<const char*>(textureRecords.data()), textureRecords.size() * sizeof(TextureRecord));
+		stream.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(MeshLod));
+		stream.write(reinterpret_cast<const char*>(meshlets.data()), meshlets.size() * sizeof(Meshlet));
+		stream.write(strings.data(), strings.size());
+		const char padding[BLOB_ALIGNMENT] = {};
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			stream.write(padding, meshRecords[i]._vertexOffset - static_cast<uint64_t>(stream.tellp()));
+			stream.write(reinterpret_cast<const char*>(meshes[i]._vertices.data()), meshes[i]._vertices.size() * sizeof(Vertex));
+			stream.write(padding, meshRecords[i]._indexOffset - static_cast<uint64_t>(stream.tellp()));
+			stream.write(reinterpret_cast<const char*>(meshes[i]._indices.data()), meshes[i]._indices.size() * sizeof(unsigned int));
+		}
+
+		return static_cast<bool>(stream);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include <engine/mesh.h>
+#include <engine/mapped_file.h>
+
+#include <string>
+#include <vector>
+
+namespace phoenix
+{
+	// CPU-side mesh data as produced by the importer, prior to upload
+	struct MeshData
+	{
+		std::vector<Vertex> _vertices;
+		std::vector<unsigned int> _indices; // All LODs back to back
+		std::vector<Texture> _textures;
+		std::vector<MeshLod> _lods;
+		std::vector<Meshlet> _meshlets;
+	};
+
+	// Cooked binary copy of an imported model. The file is a header followed by a mesh table, a texture table,
+	// a LOD table, a meshlet table, a string blob for the texture keys and finally the raw vertex and index
+	// blobs, so that meshes can be uploaded straight from the mapped pages on warm starts.
+	class MeshCache
+	{
+	public:
+		struct Entry
+		{
+			const Vertex* _vertices;
+			const unsigned int* _indices;
+			unsigned int _numVertices, _numIndices;
+			std::vector<Texture> _textures; // Keys and types only, texture IDs are resolved by the model
+			std::vector<MeshLod> _lods;
+			std::vector<Meshlet> _meshlets;
+		};
+
+		std::vector<Entry> _entries;
+
+		// Maps the cooked file for the given source, if one exists and is still up to date
+		MeshCache(const std::string&);
+
+		inline bool isValid() const
+		{
+			return _valid;
+		}
+
+		static std::string getCachePath(const std::string&);
+		static bool write(const std::string&, const std::vector<MeshData>&);
+
+	private:
+		MappedFile _file;
+		bool _valid = false;
+	};
+}
\ No newline at end of file
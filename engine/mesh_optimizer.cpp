@@ -0,0 +1,358 @@
+#include <engine/mesh_optimizer.h>
+#include <engine/common.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace phoenix
+{
+	namespace
+	{
+		struct VertexHasher
+		{
+			size_t operator()(const Vertex& vertex) const
+			{
+				// 64-bit FNV-1a over the raw bytes, the struct is tightly packed floats
+				const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+				uint64_t hash = 14695981039346656037ull;
+				for (size_t i = 0; i < sizeof(Vertex); ++i)
+				{
+					hash = (hash ^ bytes[i]) * 1099511628211ull;
+				}
+				return static_cast<size_t>(hash);
+			}
+		};
+
+		struct VertexEqual
+		{
+			bool operator()(const Vertex& a, const Vertex& b) const
+			{
+				return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+			}
+		};
+
+		void weldVertices(MeshData& mesh)
+		{
+			std::unordered_map<Vertex, unsigned int, VertexHasher, VertexEqual> uniqueVertices(mesh._vertices.size());
+			std::vector<unsigned int> remap(mesh._vertices.size());
+			std::vector<Vertex> vertices;
+			vertices.reserve(mesh._vertices.size());
+			for (size_t i = 0; i < mesh._vertices.size(); ++i)
+			{
+				auto result = uniqueVertices.emplace(mesh._vertices[i], static_cast<unsigned int>(vertices.size()));
+				if (result.second)
+				{
+					vertices.push_back(mesh._vertices[i]);
+				}
+				remap[i] = result.first->second;
+			}
+			for (auto& index : mesh._indices)
+			{
+				index = remap[index];
+			}
+			mesh._vertices.swap(vertices);
+		}
+
+		// Per vertex list of the triangles using it
+		struct Adjacency
+		{
+			std::vector<unsigned int> _offsets, _counts, _triangles;
+
+			Adjacency(const std::vector<unsigned int>& indices, size_t numVertices) : _offsets(numVertices), _counts(numVertices, 0), _triangles(indices.size())
+			{
+				for (auto index : indices)
+				{
+					++_counts[index];
+				}
+				unsigned int offset = 0;
+				for (size_t i = 0; i < numVertices; ++i)
+				{
+					_offsets[i] = offset;
+					offset += _counts[i];
+				}
+				std::vector<unsigned int> fill(_offsets);
+				for (size_t i = 0; i < indices.size(); ++i)
+				{
+					_triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+				}
+			}
+		};
+
+		// Tipsify, see Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw". Fans around
+		// the vertex that is expected to stay in the cache longest and falls back to the dead end stack otherwise.
+		// Records a cluster boundary every time the fan has to restart from a vertex that is no longer cached.
+		std::vector<unsigned int> tipsify(const std::vector<unsigned int>& indices, size_t numVertices, std::vector<unsigned int>& clusters)
+		{
+			const size_t numTriangles = indices.size() / 3;
+			const int cacheSize = static_cast<int>(VERTEX_CACHE_SIZE);
+			Adjacency adjacency(indices, numVertices);
+			std::vector<unsigned int> liveTriangles(adjacency._counts);
+			std::vector<int> cacheTimestamps(numVertices, 0);
+			std::vector<bool> emitted(numTriangles, false);
+			std::vector<unsigned int> deadEnds, candidates;
+			std::vector<unsigned int> triangles;
+			triangles.reserve(numTriangles);
+
+			int timestamp = cacheSize + 1;
+			size_t cursor = 0;
+			long long fanningVertex = numVertices ? 0 : -1;
+			bool restarted = true;
+			while (fanningVertex >= 0)
+			{
+				candidates.clear();
+				const unsigned int vertex = static_cast<unsigned int>(fanningVertex);
+				for (unsigned int i = 0; i < adjacency._counts[vertex]; ++i)
+				{
+					const unsigned int triangle = adjacency._triangles[adjacency._offsets[vertex] + i];
+					if (emitted[triangle])
+					{
+						continue;
+					}
+					for (int j = 0; j < 3; ++j)
+					{
+						const unsigned int v = indices[triangle * 3 + j];
+						deadEnds.push_back(v);
+						candidates.push_back(v);
+						--liveTriangles[v];
+						if (timestamp - cacheTimestamps[v] > cacheSize)
+						{
+							cacheTimestamps[v] = timestamp++;
+						}
+					}
+					emitted[triangle] = true;
+					if (restarted)
+					{
+						clusters.push_back(static_cast<unsigned int>(triangles.size()));
+						restarted = false;
+					}
+					triangles.push_back(triangle);
+				}
+
+				// Prefer the candidate that will still be cached after fanning around it, and among those the oldest one
+				fanningVertex = -1;
+				int bestPriority = -1;
+				for (auto v : candidates)
+				{
+					if (liveTriangles[v] == 0)
+					{
+						continue;
+					}
+					int priority = 0;
+					if (timestamp - cacheTimestamps[v] + 2 * static_cast<int>(liveTriangles[v]) <= cacheSize)
+					{
+						priority = timestamp - cacheTimestamps[v];
+					}
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						fanningVertex = v;
+					}
+				}
+				restarted = restarted || fanningVertex < 0;
+				while (fanningVertex < 0 && !deadEnds.empty())
+				{
+					const unsigned int v = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveTriangles[v] > 0)
+					{
+						fanningVertex = v;
+					}
+				}
+				while (fanningVertex < 0 && cursor < numVertices)
+				{
+					if (liveTriangles[cursor] > 0)
+					{
+						fanningVertex = static_cast<long long>(cursor);
+					}
+					++cursor;
+				}
+			}
+			return triangles;
+		}
+
+		// Splits the hard clusters further wherever the running ACMR is already close to that of the whole cluster,
+		// which gives the overdraw sort more freedom at a bounded cost in cache efficiency
+		std::vector<unsigned int> splitClusters(const std::vector<unsigned int>& indices, const std::vector<unsigned int>& clusters, size_t numVertices)
+		{
+			std::vector<unsigned int> splitClusters;
+			std::vector<size_t> cacheTimestamps(numVertices, 0);
+			size_t timestamp = VERTEX_CACHE_SIZE + 1;
+			const size_t numTriangles = indices.size() / 3;
+			for (size_t c = 0; c < clusters.size(); ++c)
+			{
+				const size_t begin = clusters[c], end = c + 1 < clusters.size() ? clusters[c + 1] : numTriangles;
+
+				auto simulate = [&](size_t triangle)
+				{
+					size_t misses = 0;
+					for (int j = 0; j < 3; ++j)
+					{
+						const unsigned int v = indices[triangle * 3 + j];
+						if (timestamp - cacheTimestamps[v] > VERTEX_CACHE_SIZE)
+						{
+							cacheTimestamps[v] = timestamp++;
+							++misses;
+						}
+					}
+					return misses;
+				};
+
+				timestamp += VERTEX_CACHE_SIZE + 1;
+				size_t clusterMisses = 0;
+				for (size_t t = begin; t < end; ++t)
+				{
+					clusterMisses += simulate(t);
+				}
+				const float threshold = OVERDRAW_THRESHOLD * clusterMisses / (end - begin);
+
+				timestamp += VERTEX_CACHE_SIZE + 1;
+				splitClusters.push_back(static_cast<unsigned int>(begin));
+				size_t start = begin, misses = 0;
+				for (size_t t = begin; t < end; ++t)
+				{
+					misses += simulate(t);
+					if (t + 1 < end && static_cast<float>(misses) / (t + 1 - start) <= threshold)
+					{
+						splitClusters.push_back(static_cast<unsigned int>(t + 1));
+						start = t + 1;
+						misses = 0;
+						// Each sub cluster may end up anywhere in the draw order, so it starts from a cold cache
+						timestamp += VERTEX_CACHE_SIZE + 1;
+					}
+				}
+			}
+			return splitClusters;
+		}
+
+		// Linear-time overdraw ordering from the same paper: clusters on the outside of the mesh facing away from its
+		// centroid are the likeliest occluders, so they are drawn first
+		void sortClusters(std::vector<unsigned int>& indices, const std::vector<unsigned int>& clusters, const std::vector<Vertex>& vertices)
+		{
+			const size_t numTriangles = indices.size() / 3;
+			glm::vec3 meshCentroid(0.0f);
+			for (const auto& vertex : vertices)
+			{
+				meshCentroid += vertex._position;
+			}
+			meshCentroid /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+			std::vector<float> sortKeys(clusters.size());
+			for (size_t c = 0; c < clusters.size(); ++c)
+			{
+				const size_t begin = clusters[c], end = c + 1 < clusters.size() ? clusters[c + 1] : numTriangles;
+				glm::vec3 centroid(0.0f), normal(0.0f);
+				float area = 0.0f;
+				for (size_t t = begin; t < end; ++t)
+				{
+					const glm::vec3& p0 = vertices[indices[t * 3]]._position;
+					const glm::vec3& p1 = vertices[indices[t * 3 + 1]]._position;
+					const glm::vec3& p2 = vertices[indices[t * 3 + 2]]._position;
+					const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+					const float triangleArea = glm::length(n);
+					centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+					normal += n;
+					area += triangleArea;
+				}
+				centroid = area > 0.0f ? centroid / area : meshCentroid;
+				const float length = glm::length(normal);
+				sortKeys[c] = length > 0.0f ? glm::dot(centroid - meshCentroid, normal / length) : 0.0f;
+			}
+
+			std::vector<size_t> order(clusters.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&sortKeys](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+			std::vector<unsigned int> sortedIndices;
+			sortedIndices.reserve(indices.size());
+			for (auto c : order)
+			{
+				const size_t begin = clusters[c], end = c + 1 < clusters.size() ? clusters[c + 1] : numTriangles;
+				sortedIndices.insert(sortedIndices.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+			}
+			indices.swap(sortedIndices);
+		}
+
+		void reorderTriangles(std::vector<unsigned int>& indices, const std::vector<unsigned int>& triangles)
+		{
+			std::vector<unsigned int> reorderedIndices;
+			reorderedIndices.reserve(indices.size());
+			for (auto triangle : triangles)
+			{
+				reorderedIndices.insert(reorderedIndices.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+			}
+			indices.swap(reorderedIndices);
+		}
+
+		void optimizeVertexFetch(MeshData& mesh)
+		{
+			const unsigned int UNUSED = ~0u;
+			std::vector<unsigned int> remap(mesh._vertices.size(), UNUSED);
+			std::vector<Vertex> vertices;
+			vertices.reserve(mesh._vertices.size());
+			for (auto& index : mesh._indices)
+			{
+				if (remap[index] == UNUSED)
+				{
+					remap[index] = static_cast<unsigned int>(vertices.size());
+					vertices.push_back(mesh._vertices[index]);
+				}
+				index = remap[index];
+			}
+			// Vertices no triangle references are dropped as well
+			mesh._vertices.swap(vertices);
+		}
+	}
+
+	VertexCacheStats& VertexCacheStats::operator+=(const VertexCacheStats& other)
+	{
+		_numTriangles += other._numTriangles;
+		_numVertices += other._numVertices;
+		_numCacheMisses += other._numCacheMisses;
+		return *this;
+	}
+
+	VertexCacheStats analyzeVertexCache(const unsigned int* indices, size_t numIndices, size_t numVertices)
+	{
+		VertexCacheStats stats;
+		stats._numTriangles = numIndices / 3;
+		stats._numVertices = numVertices;
+		std::vector<size_t> cacheTimestamps(numVertices, 0);
+		size_t timestamp = VERTEX_CACHE_SIZE + 1;
+		for (size_t i = 0; i < numIndices; ++i)
+		{
+			if (timestamp - cacheTimestamps[indices[i]] > VERTEX_CACHE_SIZE)
+			{
+				cacheTimestamps[indices[i]] = timestamp++;
+				++stats._numCacheMisses;
+			}
+		}
+		return stats;
+	}
+
+	void optimizeVertexCache(std::vector<unsigned int>& indices, size_t numVertices)
+	{
+		std::vector<unsigned int> clusters;
+		reorderTriangles(indices, tipsify(indices, numVertices, clusters));
+	}
+
+	void optimizeMesh(MeshData& mesh, VertexCacheStats& before, VertexCacheStats& after)
+	{
+		before = analyzeVertexCache(mesh._indices.data(), mesh._indices.size(), mesh._vertices.size());
+		if (mesh._indices.size() % 3 != 0)
+		{
+			// Not a triangle list, leave it as it is
+			after = before;
+			return;
+		}
+
+		weldVertices(mesh);
+		std::vector<unsigned int> clusters;
+		reorderTriangles(mesh._indices, tipsify(mesh._indices, mesh._vertices.size(), clusters));
+		sortClusters(mesh._indices, splitClusters(mesh._indices, clusters, mesh._vertices.size()), mesh._vertices);
+		optimizeVertexFetch(mesh);
+
+		after = analyzeVertexCache(mesh._indices.data(), mesh._indices.size(), mesh._vertices.size());
+	}
+}
\ No newline at end of file
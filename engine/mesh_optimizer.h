@@ -0,0 +1,34 @@
+#pragma once
+#include <engine/mesh_cache.h>
+
+#include <vector>
+
+namespace phoenix
+{
+	// Post-transform vertex cache behaviour of an index buffer, simulated as a FIFO of VERTEX_CACHE_SIZE entries
+	struct VertexCacheStats
+	{
+		size_t _numTriangles = 0, _numVertices = 0, _numCacheMisses = 0;
+
+		// Average cache miss ratio, transformed vertices per triangle (0.5 is the lower bound on regular meshes)
+		inline float getACMR() const
+		{
+			return _numTriangles ? static_cast<float>(_numCacheMisses) / _numTriangles : 0.0f;
+		}
+		// Average transform to vertex ratio, 1 means every vertex is transformed exactly once
+		inline float getATVR() const
+		{
+			return _numVertices ? static_cast<float>(_numCacheMisses) / _numVertices : 0.0f;
+		}
+		VertexCacheStats& operator+=(const VertexCacheStats&);
+	};
+
+	VertexCacheStats analyzeVertexCache(const unsigned int*, size_t, size_t);
+	// Only reorders the triangles of the index buffer for the post-transform cache
+	void optimizeVertexCache(std::vector<unsigned int>&, size_t);
+
+	// Runs the whole pass on a freshly imported triangle list: welds bitwise identical vertices, reorders triangles for
+	// the post-transform cache (Tipsify), sorts the resulting clusters to reduce overdraw and finally renumbers the
+	// vertices in first use order for fetch locality. Returns the cache statistics before and after.
+	void optimizeMesh(MeshData&, VertexCacheStats&, VertexCacheStats&);
+}
\ No newline at end of file
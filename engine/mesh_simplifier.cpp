@@ -0,0 +1,361 @@
+#include <engine/mesh_simplifier.h>
+#include <engine/mesh_optimizer.h>
+#include <engine/common.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace phoenix
+{
+	namespace
+	{
+		// Symmetric 4x4 matrix of the summed squared plane distances, weighted by triangle area
+		struct Quadric
+		{
+			double _a00 = 0.0, _a01 = 0.0, _a02 = 0.0, _a11 = 0.0, _a12 = 0.0, _a22 = 0.0;
+			double _b0 = 0.0, _b1 = 0.0, _b2 = 0.0, _c = 0.0;
+			double _weight = 0.0;
+
+			Quadric() {}
+			Quadric(const glm::dvec3& normal, double distance, double weight)
+			{
+				_a00 = weight * normal.x * normal.x;
+				_a01 = weight * normal.x * normal.y;
+				_a02 = weight * normal.x * normal.z;
+				_a11 = weight * normal.y * normal.y;
+				_a12 = weight * normal.y * normal.z;
+				_a22 = weight * normal.z * normal.z;
+				_b0 = weight * normal.x * distance;
+				_b1 = weight * normal.y * distance;
+				_b2 = weight * normal.z * distance;
+				_c = weight * distance * distance;
+				_weight = weight;
+			}
+
+			Quadric& operator+=(const Quadric& other)
+			{
+				_a00 += other._a00;
+				_a01 += other._a01;
+				_a02 += other._a02;
+				_a11 += other._a11;
+				_a12 += other._a12;
+				_a22 += other._a22;
+				_b0 += other._b0;
+				_b1 += other._b1;
+				_b2 += other._b2;
+				_c += other._c;
+				_weight += other._weight;
+				return *this;
+			}
+
+			// Area weighted mean of the squared distances to the planes
+			double evaluate(const glm::vec3& p) const
+			{
+				const double x = p.x, y = p.y, z = p.z;
+				const double error = _a00 * x * x + 2.0 * _a01 * x * y + 2.0 * _a02 * x * z + _a11 * y * y + 2.0 * _a12 * y * z + _a22 * z * z
+					+ 2.0 * (_b0 * x + _b1 * y + _b2 * z) + _c;
+				return _weight > 0.0 ? std::max(error, 0.0) / _weight : 0.0;
+			}
+		};
+
+		struct Collapse
+		{
+			unsigned int _from, _to;
+			double _error;
+		};
+
+		struct PositionHasher
+		{
+			size_t operator()(const glm::vec3& position) const
+			{
+				uint32_t bits[3];
+				std::memcpy(bits, &position, sizeof(bits));
+				return static_cast<size_t>((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+			}
+		};
+
+		class Simplifier
+		{
+		public:
+			Simplifier(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) : _vertices(vertices), _indices(indices)
+			{
+				// Vertices only differing in their attributes share a position and thus a quadric
+				std::unordered_map<glm::vec3, unsigned int, PositionHasher> positions;
+				_positionIDs.resize(vertices.size());
+				std::vector<unsigned int> numCopies;
+				for (size_t i = 0; i < vertices.size(); ++i)
+				{
+					auto result = positions.emplace(vertices[i]._position, static_cast<unsigned int>(numCopies.size()));
+					if (result.second)
+					{
+						numCopies.push_back(0);
+					}
+					_positionIDs[i] = result.first->second;
+					++numCopies[result.first->second];
+				}
+
+				// Edges used by a single triangle are on a border, edges used by more than two are non-manifold
+				std::unordered_map<uint64_t, unsigned int> edges;
+				for (size_t i = 0; i < indices.size(); i += 3)
+				{
+					for (int j = 0; j < 3; ++j)
+					{
+						edges[getEdgeKey(_positionIDs[indices[i + j]], _positionIDs[indices[i + (j + 1) % 3]])]++;
+					}
+				}
+				_locked.assign(numCopies.size(), false);
+				for (size_t i = 0; i < numCopies.size(); ++i)
+				{
+					_locked[i] = numCopies[i] > 1;
+				}
+				for (auto& edge : edges)
+				{
+					if (edge.second != 2)
+					{
+						_locked[edge.first >> 32] = true;
+						_locked[edge.first & 0xffffffffu] = true;
+					}
+				}
+
+				_quadrics.resize(numCopies.size());
+				for (size_t i = 0; i < indices.size(); i += 3)
+				{
+					const glm::dvec3 p0(vertices[indices[i]]._position), p1(vertices[indices[i + 1]]._position), p2(vertices[indices[i + 2]]._position);
+					glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+					const double area = glm::length(normal);
+					if (area == 0.0)
+					{
+						continue;
+					}
+					normal /= area;
+					const Quadric quadric(normal, -glm::dot(normal, p0), area);
+					for (int j = 0; j < 3; ++j)
+					{
+						_quadrics[_positionIDs[indices[i + j]]] += quadric;
+					}
+				}
+			}
+
+			// Collapses edges until at most the given number of triangles is left or no collapse is possible without
+			// flipping triangles. Returns false when stuck.
+			bool simplify(size_t targetNumTriangles)
+			{
+				while (_indices.size() / 3 > targetNumTriangles)
+				{
+					// Every collapse removes about two triangles
+					const size_t maxNumCollapses = std::max<size_t>((_indices.size() / 3 - targetNumTriangles) / 2, 1);
+					if (!collapseEdges(maxNumCollapses))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+			inline const std::vector<unsigned int>& getIndices() const
+			{
+				return _indices;
+			}
+
+			// Square root of the largest quadric error accepted so far, in object space units
+			inline float getError() const
+			{
+				return static_cast<float>(std::sqrt(_maxError));
+			}
+
+		private:
+			const std::vector<Vertex>& _vertices;
+			std::vector<unsigned int> _indices, _positionIDs;
+			std::vector<Quadric> _quadrics;
+			std::vector<bool> _locked;
+			double _maxError = 0.0;
+
+			static uint64_t getEdgeKey(unsigned int a, unsigned int b)
+			{
+				return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+			}
+
+			// One pass over all edges, cheapest first, touching every vertex at most once so the costs stay valid
+			bool collapseEdges(size_t maxNumCollapses)
+			{
+				std::vector<Collapse> collapses;
+				collapses.reserve(_indices.size() * 2);
+				for (size_t i = 0; i < _indices.size(); i += 3)
+				{
+					for (int j = 0; j < 3; ++j)
+					{
+						const unsigned int a = _indices[i + j], b = _indices[i + (j + 1) % 3];
+						const unsigned int pa = _positionIDs[a], pb = _positionIDs[b];
+						Quadric quadric = _quadrics[pa];
+						quadric += _quadrics[pb];
+						if (!_locked[pa])
+						{
+							collapses.push_back(Collapse{ a, b, quadric.evaluate(_vertices[b]._position) });
+						}
+						if (!_locked[pb])
+						{
+							collapses.push_back(Collapse{ b, a, quadric.evaluate(_vertices[a]._position) });
+						}
+					}
+				}
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a._error < b._error; });
+
+				// Triangles around every vertex
+				std::vector<unsigned int> offsets(_vertices.size() + 1, 0), triangles(_indices.size());
+				for (auto index : _indices)
+				{
+					++offsets[index + 1];
+				}
+				for (size_t i = 0; i < _vertices.size(); ++i)
+				{
+					offsets[i + 1] += offsets[i];
+				}
+				std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+				for (size_t i = 0; i < _indices.size(); ++i)
+				{
+					triangles[fill[_indices[i]]++] = static_cast<unsigned int>(i / 3);
+				}
+
+				std::vector<unsigned int> remap(_vertices.size());
+				for (size_t i = 0; i < remap.size(); ++i)
+				{
+					remap[i] = static_cast<unsigned int>(i);
+				}
+				std::vector<bool> touched(_quadrics.size(), false);
+				size_t numCollapses = 0;
+				for (const auto& collapse : collapses)
+				{
+					const unsigned int from = collapse._from, to = collapse._to;
+					if (touched[_positionIDs[from]] || touched[_positionIDs[to]] || flipsTriangles(from, to, offsets, triangles))
+					{
+						continue;
+					}
+
+					remap[from] = to;
+					_quadrics[_positionIDs[to]] += _quadrics[_positionIDs[from]];
+					_maxError = std::max(_maxError, collapse._error);
+					// The neighbourhood changed shape, so its remaining costs and flip tests are stale
+					for (unsigned int i = offsets[from]; i < offsets[from + 1]; ++i)
+					{
+						for (int j = 0; j < 3; ++j)
+						{
+							touched[_positionIDs[_indices[triangles[i] * 3 + j]]] = true;
+						}
+					}
+					if (++numCollapses == maxNumCollapses)
+					{
+						break;
+					}
+				}
+				if (numCollapses == 0)
+				{
+					return false;
+				}
+
+				// Apply the collapses and drop the triangles that became degenerate
+				size_t numIndices = 0;
+				for (size_t i = 0; i < _indices.size(); i += 3)
+				{
+					const unsigned int a = remap[_indices[i]], b = remap[_indices[i + 1]], c = remap[_indices[i + 2]];
+					const unsigned int pa = _positionIDs[a], pb = _positionIDs[b], pc = _positionIDs[c];
+					if (pa != pb && pb != pc && pa != pc)
+					{
+						_indices[numIndices++] = a;
+						_indices[numIndices++] = b;
+						_indices[numIndices++] = c;
+					}
+				}
+				_indices.resize(numIndices);
+				return true;
+			}
+
+			// Rejects collapses that would turn any of the remaining triangles around the vertex upside down
+			bool flipsTriangles(unsigned int from, unsigned int to, const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& triangles) const
+			{
+				const glm::vec3& target = _vertices[to]._position;
+				for (unsigned int i = offsets[from]; i < offsets[from + 1]; ++i)
+				{
+					const unsigned int* triangle = &_indices[triangles[i] * 3];
+					glm::vec3 before[3], after[3];
+					bool collapses = false;
+					for (int j = 0; j < 3; ++j)
+					{
+						collapses = collapses || _positionIDs[triangle[j]] == _positionIDs[to];
+						before[j] = _vertices[triangle[j]]._position;
+						after[j] = triangle[j] == from ? target : before[j];
+					}
+					if (collapses)
+					{
+						continue;
+					}
+					const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					if (glm::dot(normalBefore, normalAfter) <= 0.25f * glm::length(normalBefore) * glm::length(normalAfter))
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+		};
+
+		unsigned int getNumUsedVertices(const unsigned int* indices, size_t numIndices, size_t numVertices)
+		{
+			std::vector<bool> used(numVertices, false);
+			unsigned int numUsed = 0;
+			for (size_t i = 0; i < numIndices; ++i)
+			{
+				if (!used[indices[i]])
+				{
+					used[indices[i]] = true;
+					++numUsed;
+				}
+			}
+			return numUsed;
+		}
+	}
+
+	void generateLods(MeshData& mesh)
+	{
+		const unsigned int numIndices = static_cast<unsigned int>(mesh._indices.size());
+		mesh._lods.assign(1, MeshLod{ 0, numIndices, static_cast<unsigned int>(mesh._vertices.size()), 0.0f });
+		if (numIndices % 3 != 0 || numIndices / 3 < MIN_LOD_TRIANGLES)
+		{
+			return;
+		}
+
+		glm::vec3 min = mesh._vertices[0]._position, max = min;
+		for (const auto& vertex : mesh._vertices)
+		{
+			min = glm::min(min, vertex._position);
+			max = glm::max(max, vertex._position);
+		}
+		const float diameter = glm::length(max - min);
+
+		// The quadrics keep accumulating across levels, so every error is measured against the full resolution mesh
+		Simplifier simplifier(mesh._vertices, mesh._indices);
+		size_t numTriangles = numIndices / 3;
+		while (mesh._lods.size() < MAX_NUM_LODS && numTriangles * LOD_REDUCTION >= MIN_LOD_TRIANGLES)
+		{
+			const size_t targetNumTriangles = static_cast<size_t>(numTriangles * LOD_REDUCTION);
+			simplifier.simplify(targetNumTriangles);
+			std::vector<unsigned int> indices = simplifier.getIndices();
+			// Not worth another draw range if the seams and borders held most of the mesh in place
+			if (indices.size() / 3 > numTriangles * (1.0f + LOD_REDUCTION) / 2.0f)
+			{
+				break;
+			}
+			numTriangles = indices.size() / 3;
+
+			optimizeVertexCache(indices, mesh._vertices.size());
+			MeshLod lod;
+			lod._firstIndex = static_cast<unsigned int>(mesh._indices.size());
+			lod._numIndices = static_cast<unsigned int>(indices.size());
+			lod._numVertices = getNumUsedVertices(indices.data(), indices.size(), mesh._vertices.size());
+			lod._error = diameter > 0.0f ? simplifier.getError() / diameter : 0.0f;
+			mesh._indices.insert(mesh._indices.end(), indices.begin(), indices.end());
+			mesh._lods.push_back(lod);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+#include <engine/mesh_cache.h>
+
+namespace phoenix
+{
+	// Builds the LOD chain of an optimized mesh with quadric error edge collapses (Garland and Heckbert). Every level
+	// has about LOD_REDUCTION times the triangles of the previous one and is appended to the index buffer, the vertex
+	// buffer is shared by all levels. Vertices on borders and attribute seams stay in place so that UVs don't tear.
+	void generateLods(MeshData&);
+}
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include <engine/meshlet_builder.h>
+#include <engine/mesh_optimizer.h>
+#include <engine/common.h>
+#include <algorithm>
+#include <cmath>
+
+namespace phoenix
+{
+	namespace
+	{
+		// Growing by score loses the vertex cache order, so redo it on meshlet local indices
+		void reorderMeshlet(std::vector<unsigned int>& indices, unsigned int firstIndex, unsigned int numVertices)
+		{
+			std::vector<unsigned int> vertices, localIndices(indices.size() - firstIndex);
+			vertices.reserve(numVertices);
+			for (size_t i = firstIndex; i < indices.size(); ++i)
+			{
+				auto it = std::find(vertices.begin(), vertices.end(), indices[i]);
+				localIndices[i - firstIndex] = static_cast<unsigned int>(it - vertices.begin());
+				if (it == vertices.end())
+				{
+					vertices.push_back(indices[i]);
+				}
+			}
+			optimizeVertexCache(localIndices, vertices.size());
+			for (size_t i = 0; i < localIndices.size(); ++i)
+			{
+				indices[firstIndex + i] = vertices[localIndices[i]];
+			}
+		}
+
+		Meshlet finishMeshlet(const MeshData& mesh, const std::vector<unsigned int>& meshletIndices, unsigned int firstIndex, unsigned int numIndices)
+		{
+			Meshlet meshlet;
+			meshlet._firstIndex = firstIndex;
+			meshlet._numIndices = numIndices;
+
+			const unsigned int* indices = &meshletIndices[firstIndex];
+			glm::vec3 min = mesh._vertices[indices[0]]._position, max = min;
+			glm::vec3 normals[MESHLET_MAX_TRIANGLES];
+			unsigned int numNormals = 0;
+			glm::vec3 axis(0.0f);
+			for (unsigned int i = 0; i < numIndices; i += 3)
+			{
+				const glm::vec3& p0 = mesh._vertices[indices[i]]._position;
+				const glm::vec3& p1 = mesh._vertices[indices[i + 1]]._position;
+				const glm::vec3& p2 = mesh._vertices[indices[i + 2]]._position;
+				min = glm::min(min, glm::min(p0, glm::min(p1, p2)));
+				max = glm::max(max, glm::max(p0, glm::max(p1, p2)));
+
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const float length = glm::length(normal);
+				if (length > 0.0f)
+				{
+					normals[numNormals++] = normal / length;
+					axis += normal / length;
+				}
+			}
+
+			meshlet._center = (min + max) * 0.5f;
+			meshlet._radius = 0.0f;
+			for (unsigned int i = 0; i < numIndices; ++i)
+			{
+				meshlet._radius = std::max(meshlet._radius, glm::distance(meshlet._center, mesh._vertices[indices[i]]._position));
+			}
+
+			// The cone has to contain every face normal. Spreads close to a hemisphere never cull anything, so they are
+			// disabled with a cutoff of 1 right away.
+			const float axisLength = glm::length(axis);
+			meshlet._coneAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+			float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+			for (unsigned int i = 0; i < numNormals; ++i)
+			{
+				minDot = std::min(minDot, glm::dot(normals[i], meshlet._coneAxis));
+			}
+			meshlet._coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+			return meshlet;
+		}
+	}
+
+	void buildMeshlets(MeshData& mesh)
+	{
+		mesh._meshlets.clear();
+		const unsigned int numIndices = mesh._lods.empty() ? static_cast<unsigned int>(mesh._indices.size()) : mesh._lods[0]._numIndices;
+		if (numIndices == 0 || numIndices % 3 != 0)
+		{
+			return;
+		}
+		const unsigned int numTriangles = numIndices / 3;
+
+		// Triangles around every vertex
+		std::vector<unsigned int> offsets(mesh._vertices.size() + 1, 0), adjacency(numIndices);
+		for (unsigned int i = 0; i < numIndices; ++i)
+		{
+			++offsets[mesh._indices[i] + 1];
+		}
+		for (size_t i = 0; i < mesh._vertices.size(); ++i)
+		{
+			offsets[i + 1] += offsets[i];
+		}
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (unsigned int i = 0; i < numIndices; ++i)
+		{
+			adjacency[fill[mesh._indices[i]]++] = i / 3;
+		}
+
+		std::vector<glm::vec3> normals(numTriangles);
+		for (unsigned int i = 0; i < numTriangles; ++i)
+		{
+			const glm::vec3& p0 = mesh._vertices[mesh._indices[i * 3]]._position;
+			const glm::vec3& p1 = mesh._vertices[mesh._indices[i * 3 + 1]]._position;
+			const glm::vec3& p2 = mesh._vertices[mesh._indices[i * 3 + 2]]._position;
+			const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float length = glm::length(normal);
+			normals[i] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+		}
+
+		// Grows every meshlet from the first unused triangle in the optimized order, which keeps the overdraw order
+		// at meshlet granularity. Neighbours adding few vertices and bending the normal cone the least go first.
+		// Membership of the meshlet being built is tagged with its number, which saves clearing it.
+		std::vector<unsigned int> tags(mesh._vertices.size(), ~0u);
+		std::vector<bool> emitted(numTriangles, false);
+		std::vector<unsigned int> indices, candidates;
+		indices.reserve(numIndices);
+		unsigned int seed = 0;
+		for (unsigned int tag = 0; ; ++tag)
+		{
+			while (seed < numTriangles && emitted[seed])
+			{
+				++seed;
+			}
+			if (seed == numTriangles)
+			{
+				break;
+			}
+
+			const unsigned int firstIndex = static_cast<unsigned int>(indices.size());
+			unsigned int numVertices = 0, numMeshletTriangles = 0;
+			glm::vec3 normalSum(0.0f);
+			candidates.assign(1, seed);
+			while (numMeshletTriangles < MESHLET_MAX_TRIANGLES)
+			{
+				const glm::vec3 axis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+				int best = -1;
+				float bestScore = 0.0f;
+				unsigned int bestNumNewVertices = 0;
+				for (size_t i = 0; i < candidates.size(); ++i)
+				{
+					const unsigned int triangle = candidates[i];
+					if (emitted[triangle])
+					{
+						continue;
+					}
+					unsigned int numNewVertices = 0;
+					for (int j = 0; j < 3; ++j)
+					{
+						numNewVertices += tags[mesh._indices[triangle * 3 + j]] != tag;
+					}
+					if (numVertices + numNewVertices > MESHLET_MAX_VERTICES)
+					{
+						continue;
+					}
+					const float score = numNewVertices + MESHLET_CONE_WEIGHT * (1.0f - glm::dot(normals[triangle], axis));
+					if (best < 0 || score < bestScore)
+					{
+						best = static_cast<int>(i);
+						bestScore = score;
+						bestNumNewVertices = numNewVertices;
+					}
+				}
+				if (best < 0)
+				{
+					break;
+				}
+
+				const unsigned int triangle = candidates[best];
+				candidates[best] = candidates.back();
+				candidates.pop_back();
+				emitted[triangle] = true;
+				normalSum += normals[triangle];
+				numVertices += bestNumNewVertices;
+				++numMeshletTriangles;
+				for (int j = 0; j < 3; ++j)
+				{
+					const unsigned int vertex = mesh._indices[triangle * 3 + j];
+					indices.push_back(vertex);
+					if (tags[vertex] != tag)
+					{
+						tags[vertex] = tag;
+						for (unsigned int k = offsets[vertex]; k < offsets[vertex + 1]; ++k)
+						{
+							if (!emitted[adjacency[k]])
+							{
+								candidates.push_back(adjacency[k]);
+							}
+						}
+					}
+				}
+			}
+			reorderMeshlet(indices, firstIndex, numVertices);
+			mesh._meshlets.push_back(finishMeshlet(mesh, indices, firstIndex, static_cast<unsigned int>(indices.size()) - firstIndex));
+		}
+		std::copy(indices.begin(), indices.end(), mesh._indices.begin());
+	}
+}
\ No newline at end of file
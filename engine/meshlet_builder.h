@@ -0,0 +1,11 @@
+#pragma once
+#include <engine/mesh_cache.h>
+
+namespace phoenix
+{
+	// Partitions LOD 0 into meshlets of at most MESHLET_MAX_VERTICES unique vertices and MESHLET_MAX_TRIANGLES
+	// triangles, grown over adjacent triangles with similar normals to keep the normal cones tight. LOD 0 is
+	// rewritten in meshlet order, so every meshlet is a contiguous index range that can be drawn or skipped
+	// without touching the index buffer.
+	void buildMeshlets(MeshData&);
+}
\ No newline at end of file
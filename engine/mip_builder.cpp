@@ -0,0 +1,249 @@
+#include <engine/mip_builder.h>
+#include <engine/common.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// MSVC emits any intrinsic it is given, GCC and Clang only inside functions that target the instruction set
+#if defined(_MSC_VER)
+#define TARGET_AVX
+#else
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace phoenix
+{
+	namespace
+	{
+		const int LINEAR_TO_SRGB_SIZE = 4096;
+
+		// How the stored channels relate to what gets averaged
+		enum Encoding
+		{
+			ENCODING_LINEAR,
+			ENCODING_SRGB,
+			ENCODING_NORMAL
+		};
+
+		struct ConversionTables
+		{
+			float _toLinear[3][256]; // Indexed by encoding
+			unsigned char _linearToSrgb[LINEAR_TO_SRGB_SIZE];
+
+			ConversionTables()
+			{
+				for (int i = 0; i < 256; ++i)
+				{
+					const float c = i / 255.0f;
+					_toLinear[ENCODING_LINEAR][i] = c;
+					_toLinear[ENCODING_SRGB][i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+					_toLinear[ENCODING_NORMAL][i] = c * 2.0f - 1.0f;
+				}
+				for (int i = 0; i < LINEAR_TO_SRGB_SIZE; ++i)
+				{
+					const float c = i / static_cast<float>(LINEAR_TO_SRGB_SIZE - 1);
+					const float srgb = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+					_linearToSrgb[i] = static_cast<unsigned char>(srgb * 255.0f + 0.5f);
+				}
+			}
+		};
+
+		const ConversionTables& getConversionTables()
+		{
+			static const ConversionTables tables;
+			return tables;
+		}
+
+		bool hasAVX()
+		{
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			// The OS has to save the YMM registers too, not only the CPU support them
+			const bool osSavesYMM = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+			return osSavesYMM && (info[2] & (1 << 28));
+#else
+			return __builtin_cpu_supports("avx");
+#endif
+		}
+
+		const bool HAS_AVX = hasAVX();
+
+		// Texels are widened to four float channels, missing channels are 0 and missing alpha is 1
+		void decodeRow(const unsigned char* source, int width, int numChannels, Encoding encoding, float* destination)
+		{
+			const ConversionTables& tables = getConversionTables();
+			const float* channelTables[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				channelTables[c] = tables._toLinear[c < 3 ? encoding : ENCODING_LINEAR];
+			}
+			for (int x = 0; x < width; ++x, source += numChannels, destination += 4)
+			{
+				destination[0] = destination[1] = destination[2] = 0.0f;
+				destination[3] = 1.0f;
+				for (int c = 0; c < numChannels; ++c)
+				{
+					destination[c] = channelTables[c][source[c]];
+				}
+			}
+		}
+
+		void encodeRow(const float* source, int width, int numChannels, Encoding encoding, unsigned char* destination)
+		{
+			const unsigned char* linearToSrgb = getConversionTables()._linearToSrgb;
+			const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+			// Normals are stored as n * 0.5 + 0.5, sRGB goes through the lookup table and the rest straight to 8 bits
+			const __m128 scale = encoding == ENCODING_NORMAL ? _mm_setr_ps(0.5f, 0.5f, 0.5f, 1.0f) : one;
+			const __m128 bias = encoding == ENCODING_NORMAL ? _mm_setr_ps(0.5f, 0.5f, 0.5f, 0.0f) : zero;
+			const __m128 range = encoding == ENCODING_SRGB ? _mm_setr_ps(LINEAR_TO_SRGB_SIZE - 1, LINEAR_TO_SRGB_SIZE - 1, LINEAR_TO_SRGB_SIZE - 1, 255.0f)
+				: _mm_set1_ps(255.0f);
+			for (int x = 0; x < width; ++x, source += 4, destination += numChannels)
+			{
+				__m128 texel = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source), scale), bias);
+				texel = _mm_min_ps(_mm_max_ps(texel, zero), one);
+				alignas(16) int32_t values[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_cvtps_epi32(_mm_mul_ps(texel, range)));
+				for (int c = 0; c < numChannels; ++c)
+				{
+					destination[c] = static_cast<unsigned char>(c < 3 && encoding == ENCODING_SRGB ? linearToSrgb[values[c]] : values[c]);
+				}
+			}
+		}
+
+		void renormalizeRow(float* texels, int width)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				float* normal = texels + x * 4;
+				const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				if (length > 0.0f)
+				{
+					normal[0] /= length;
+					normal[1] /= length;
+					normal[2] /= length;
+				}
+			}
+		}
+
+		// Two output texels per iteration, returns how many were written
+		TARGET_AVX int filterRowAVX(const float* row0, const float* row1, int numPairs, float* destination)
+		{
+			const __m256 quarter = _mm256_set1_ps(0.25f);
+			int x = 0;
+			for (; x + 1 < numPairs; x += 2)
+			{
+				const __m256 left = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+				const __m256 right = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8));
+				const __m256 even = _mm256_permute2f128_ps(left, right, 0x20), odd = _mm256_permute2f128_ps(left, right, 0x31);
+				_mm256_storeu_ps(destination + x * 4, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+			}
+			return x;
+		}
+
+		void filterRow(const float* row0, const float* row1, int width, float* destination, int mipWidth)
+		{
+			// Pairs that lie fully inside the row, only a width of 1 has to be clamped
+			const int numPairs = width / 2;
+			int x = HAS_AVX ? filterRowAVX(row0, row1, numPairs, destination) : 0;
+			const __m128 quarter = _mm_set1_ps(0.25f);
+			for (; x < numPairs; ++x)
+			{
+				const __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+				const __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+				_mm_storeu_ps(destination + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+			}
+			for (; x < mipWidth; ++x)
+			{
+				const int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+				for (int c = 0; c < 4; ++c)
+				{
+					destination[x * 4 + c] = (row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c]) * 0.25f;
+				}
+			}
+		}
+
+		// Runs the function over row ranges, on the calling thread alone for small levels
+		template <typename Function>
+		void forEachRows(int numRows, int width, const Function& function)
+		{
+			int numThreads = 1;
+			if (static_cast<size_t>(numRows) * width >= MIP_PARALLEL_TEXELS)
+			{
+				numThreads = std::min(std::max(static_cast<int>(std::thread::hardware_concurrency()), 1), numRows);
+			}
+			std::vector<std::thread> threads;
+			const int rowsPerThread = (numRows + numThreads - 1) / numThreads;
+			for (int begin = rowsPerThread; begin < numRows; begin += rowsPerThread)
+			{
+				threads.emplace_back(function, begin, std::min(begin + rowsPerThread, numRows));
+			}
+			function(0, std::min(rowsPerThread, numRows));
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+		}
+	}
+
+	std::vector<std::vector<unsigned char>> buildMipChain(const unsigned char* data, int width, int height, int numChannels, TextureUsage usage)
+	{
+		Encoding encoding = ENCODING_LINEAR;
+		if (numChannels >= 3)
+		{
+			encoding = usage == USAGE_COLOR ? ENCODING_SRGB : usage == USAGE_NORMAL ? ENCODING_NORMAL : ENCODING_LINEAR;
+		}
+
+		std::vector<std::vector<unsigned char>> mipmaps;
+		std::vector<float> previous, level;
+		while (width > 1 || height > 1)
+		{
+			const int mipWidth = std::max(width / 2, 1), mipHeight = std::max(height / 2, 1);
+			level.resize(static_cast<size_t>(mipWidth) * mipHeight * 4);
+			mipmaps.emplace_back(static_cast<size_t>(mipWidth) * mipHeight * numChannels);
+			unsigned char* mip = mipmaps.back().data();
+
+			forEachRows(mipHeight, mipWidth, [&](int begin, int end)
+			{
+				// The source image is decoded two rows at a time instead of widening all of it up front
+				std::vector<float> decoded(previous.empty() ? static_cast<size_t>(width) * 8 : 0);
+				for (int y = begin; y < end; ++y)
+				{
+					const int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+					const float* row0;
+					const float* row1;
+					if (previous.empty())
+					{
+						decodeRow(data + static_cast<size_t>(y0) * width * numChannels, width, numChannels, encoding, decoded.data());
+						decodeRow(data + static_cast<size_t>(y1) * width * numChannels, width, numChannels, encoding, decoded.data() + width * 4);
+						row0 = decoded.data();
+						row1 = decoded.data() + width * 4;
+					}
+					else
+					{
+						row0 = previous.data() + static_cast<size_t>(y0) * width * 4;
+						row1 = previous.data() + static_cast<size_t>(y1) * width * 4;
+					}
+
+					float* texels = level.data() + static_cast<size_t>(y) * mipWidth * 4;
+					filterRow(row0, row1, width, texels, mipWidth);
+					if (encoding == ENCODING_NORMAL)
+					{
+						renormalizeRow(texels, mipWidth);
+					}
+					encodeRow(texels, mipWidth, numChannels, encoding, mip + static_cast<size_t>(y) * mipWidth * numChannels);
+				}
+			});
+
+			previous.swap(level);
+			width = mipWidth;
+			height = mipHeight;
+		}
+		return mipmaps;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include <engine/texture_cooker.h>
+
+#include <vector>
+
+namespace phoenix
+{
+	// Builds mip levels 1 and up of an 8 bit image on the CPU, down to 1x1. Each level is a 2x2 box filter of the one
+	// above it, clamped at the edges of odd sized levels. The chain is kept in float so rounding doesn't add up across
+	// levels. Color is filtered in linear space and stored back as sRGB, normals are renormalized, and masks and alpha
+	// are averaged as they are. Rows of large levels are split across threads, and the filter runs on AVX or SSE.
+	std::vector<std::vector<unsigned char>> buildMipChain(const unsigned char*, int, int, int, TextureUsage);
+}
\ No newline at end of file
@@ -1,14 +1,46 @@
 #include <engine/model.h>
-#include <engine/utils.h>
+#include <engine/gl_state.h>
+#include <engine/mesh_optimizer.h>
+#include <engine/mesh_simplifier.h>
+#include <engine/meshlet_builder.h>
+#include <engine/texture_loader.h>
+#include <engine/render_stats.h>
+#include <engine/staging_ring.h>
+#include <engine/strings.h>
+#include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
+#include <algorithm>
 #include <iostream>
+#include <map>
 
 namespace phoenix
 {
-	Model::Model(const std::string& pFile)
+	Model::Model(const std::string& pFile, VertexFormat vertexFormat) : _vertexFormat(vertexFormat)
 	{
+		ImportData data;
+		import(pFile, data);
+		resolveTextures(data);
+		for (const auto& entry : data._entries)
+		{
+			addMesh(entry);
+		}
+		_resident = true;
+	}
+
+	Model::Model(VertexFormat vertexFormat) : _vertexFormat(vertexFormat) {}
+
+	void Model::import(const std::string& pFile, ImportData& data)
+	{
+		_directory = pFile.substr(0, pFile.find_last_of("/"));
+
+		// Warm start, upload straight from the cooked file and skip Assimp altogether
+		if (loadFromCache(pFile, data))
+		{
+			return;
+		}
+
 		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(pFile, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
 
@@ -18,47 +50,223 @@ namespace phoenix
 			return;
 		}
 
-		_directory = pFile.substr(0, pFile.find_last_of("/"));
+		std::vector<MeshData>& meshes = data._meshes;
+		processNode(scene, scene->mRootNode, meshes);
+		// Only paid on cold starts, the optimized buffers are what ends up in the cache
+		VertexCacheStats before, after;
+		std::vector<size_t> numTrianglesPerLod;
+		size_t numMeshlets = 0;
+		for (auto& mesh : meshes)
+		{
+			VertexCacheStats meshBefore, meshAfter;
+			optimizeMesh(mesh, meshBefore, meshAfter);
+			before += meshBefore;
+
+			generateLods(mesh);
+			buildMeshlets(mesh);
+			numMeshlets += mesh._meshlets.size();
+			// Meshlets reorder LOD 0 once more
+			after += analyzeVertexCache(mesh._indices.data(), mesh._lods[0]._numIndices, mesh._vertices.size());
+			numTrianglesPerLod.resize(std::max(numTrianglesPerLod.size(), mesh._lods.size()), 0);
+			for (size_t i = 0; i < mesh._lods.size(); ++i)
+			{
+				numTrianglesPerLod[i] += mesh._lods[i]._numIndices / 3;
+			}
+		}
+		std::cout << "Optimized " << pFile << ": " << before._numVertices << " -> " << after._numVertices << " vertices, ACMR "
+			<< before.getACMR() << " -> " << after.getACMR() << ", ATVR " << before.getATVR() << " -> " << after.getATVR() << "\n";
+		std::cout << "LOD triangle counts:";
+		for (auto numTriangles : numTrianglesPerLod)
+		{
+			std::cout << " " << numTriangles;
+		}
+		std::cout << ", " << numMeshlets << " meshlets\n";
+		MeshCache::write(pFile, meshes);
 
-		processNode(scene, scene->mRootNode);
+		for (const auto& mesh : meshes)
+		{
+			data._entries.push_back(MeshCache::Entry{ mesh._vertices.data(), mesh._indices.data(), static_cast<unsigned int>(mesh._vertices.size()),
+				static_cast<unsigned int>(mesh._indices.size()), mesh._textures, mesh._lods, mesh._meshlets });
+		}
+	}
+
+	void Model::addMesh(const MeshCache::Entry& entry)
+	{
+		_meshes.push_back(new Mesh(entry._vertices, entry._numVertices, entry._indices, entry._numIndices, entry._textures, _vertexFormat, entry._lods, entry._meshlets,
+			&GeometryArena::getInstance(_vertexFormat)));
+		_batches.clear();
 	}
 
-	void Model::render()
+	void Model::render(SubmissionMode mode)
 	{
+		if (_vertexFormat == PACKED)
+		{
+			std::cerr << PACKED_RENDER_ERROR;
+			return;
+		}
+		if (mode == MULTI_DRAW_INDIRECT)
+		{
+			renderIndirect(nullptr);
+			return;
+		}
 		for (size_t i = 0; i < _meshes.size(); ++i)
 		{
 			_meshes[i]->render();
 		}
 	}
 
-	void Model::render(const Shader& shader)
+	void Model::render(const Shader& shader, SubmissionMode mode)
 	{
+		if (_vertexFormat == PACKED)
+		{
+			std::cerr << PACKED_RENDER_ERROR;
+			return;
+		}
+		if (mode == MULTI_DRAW_INDIRECT)
+		{
+			renderIndirect(&shader);
+			return;
+		}
 		for (size_t i = 0; i < _meshes.size(); ++i)
 		{
 			_meshes[i]->render(shader);
 		}
 	}
 
-	void Model::processNode(const aiScene* scene, const aiNode* node)
+	void Model::renderIndirect(const Shader* shader)
+	{
+		if (_meshes.empty())
+		{
+			return;
+		}
+		// Meshes sharing a texture set go into the same multi-draw, found once and kept in first use order
+		if (_batches.empty())
+		{
+			std::map<std::vector<unsigned int>, size_t> batchIndices;
+			for (auto mesh : _meshes)
+			{
+				std::vector<unsigned int> key;
+				for (const auto& texture : mesh->getTextures())
+				{
+					key.push_back(texture._ID);
+					key.push_back(texture._textureType);
+				}
+				auto it = batchIndices.emplace(key, _batches.size()).first;
+				if (it->second == _batches.size())
+				{
+					_batches.emplace_back();
+				}
+				_batches[it->second].push_back(mesh);
+			}
+		}
+
+		// Without a shader textures don't matter and everything goes out in one call
+		_drawCommands.clear();
+		std::vector<size_t> batchOffsets;
+		for (const auto& batch : _batches)
+		{
+			if (shader || batchOffsets.empty())
+			{
+				batchOffsets.push_back(_drawCommands.size());
+			}
+			for (auto mesh : batch)
+			{
+				mesh->getDrawCommands(_drawCommands);
+			}
+		}
+		batchOffsets.push_back(_drawCommands.size());
+		if (_drawCommands.empty())
+		{
+			return;
+		}
+
+		StagingRing& ring = StagingRing::getInstance();
+		const size_t offset = ring.stage(_drawCommands.data(), _drawCommands.size() * sizeof(DrawElementsIndirectCommand));
+		if (offset == SIZE_MAX)
+		{
+			return;
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.getBuffer());
+		RenderStats& stats = RenderStats::getInstance();
+		GLState::getInstance().bindVertexArray(GeometryArena::getInstance(_vertexFormat).getVAO());
+		for (size_t i = 0; i + 1 < batchOffsets.size(); ++i)
+		{
+			const size_t numCommands = batchOffsets[i + 1] - batchOffsets[i];
+			if (numCommands == 0)
+			{
+				continue;
+			}
+			if (shader)
+			{
+				_batches[i][0]->bindTextures(*shader);
+			}
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(offset + batchOffsets[i] * sizeof(DrawElementsIndirectCommand)), numCommands, 0);
+			++stats._numDrawCalls;
+			stats._numDrawCommands += numCommands;
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	void Model::setLod(unsigned int lod)
+	{
+		for (auto mesh : _meshes)
+		{
+			mesh->setLod(lod);
+		}
+	}
+
+	void Model::selectLod(const glm::mat4& world, const glm::mat4& view, const glm::mat4& projection, float viewportHeight, LodHint hint)
+	{
+		for (auto mesh : _meshes)
+		{
+			mesh->selectLod(mesh->getScreenSize(world, view, projection, viewportHeight), hint);
+		}
+	}
+
+	unsigned int Model::cull(const glm::mat4& world, const glm::mat4& viewProjection, const glm::vec3& viewPos, bool cullBackfaces)
+	{
+		unsigned int numVisible = 0;
+		for (auto mesh : _meshes)
+		{
+			numVisible += mesh->cull(world, viewProjection, viewPos, cullBackfaces);
+		}
+		return numVisible;
+	}
+
+	bool Model::loadFromCache(const std::string& pFile, ImportData& data)
+	{
+		data._cache.reset(new MeshCache(pFile));
+		if (!data._cache->isValid())
+		{
+			data._cache.reset();
+			return false;
+		}
+		data._entries = data._cache->_entries;
+		return true;
+	}
+
+	void Model::processNode(const aiScene* scene, const aiNode* node, std::vector<MeshData>& meshes)
 	{
 		for (size_t i = 0; i < node->mNumMeshes; ++i)
 		{
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			_meshes.push_back(processMesh(scene, mesh));
+			meshes.emplace_back(processMesh(scene, mesh));
 		}
 		// Recurse
 		for (size_t i = 0; i < node->mNumChildren; ++i)
 		{
-			processNode(scene, node->mChildren[i]);
+			processNode(scene, node->mChildren[i], meshes);
 		}
 	}
 
-	Mesh* Model::processMesh(const aiScene* scene, const aiMesh* mesh)
+	MeshData Model::processMesh(const aiScene* scene, const aiMesh* mesh)
 	{
-		std::vector<Vertex> vertices;
-		std::vector<unsigned int> indices;
-		std::vector<Texture> textures;
+		MeshData data;
+		std::vector<Vertex>& vertices = data._vertices;
+		std::vector<unsigned int>& indices = data._indices;
+		std::vector<Texture>& textures = data._textures;
 
+		vertices.reserve(mesh->mNumVertices);
 		for (size_t i = 0; i < mesh->mNumVertices; ++i)
 		{
 			Vertex vertex;
@@ -101,6 +309,7 @@ namespace phoenix
 			vertices.push_back(vertex);
 		}
 
+		indices.reserve(mesh->mNumFaces * 3);
 		for (size_t i = 0; i < mesh->mNumFaces; ++i)
 		{
 			aiFace face = mesh->mFaces[i];
@@ -112,43 +321,43 @@ namespace phoenix
 
 		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-		std::vector<Texture> diffuseTextures = loadTextures(material, aiTextureType_DIFFUSE, DIFFUSE);
-		textures.insert(textures.end(), diffuseTextures.begin(), diffuseTextures.end());
-		std::vector<Texture> specularTextures = loadTextures(material, aiTextureType_SPECULAR, SPECULAR);
-		textures.insert(textures.end(), specularTextures.begin(), specularTextures.end());
-		std::vector<Texture> ambientTextures = loadTextures(material, aiTextureType_AMBIENT, AMBIENT);
-		textures.insert(textures.end(), ambientTextures.begin(), ambientTextures.end());
-		std::vector<Texture> bumpTextures = loadTextures(material, aiTextureType_HEIGHT, HEIGHT);
-		textures.insert(textures.end(), bumpTextures.begin(), bumpTextures.end());
-		std::vector<Texture> opacityTextures = loadTextures(material, aiTextureType_OPACITY, OPACITY);
-		textures.insert(textures.end(), opacityTextures.begin(), opacityTextures.end());
-
-		return new Mesh(vertices, indices, textures);
+		loadTextures(material, aiTextureType_DIFFUSE, DIFFUSE, textures);
+		loadTextures(material, aiTextureType_SPECULAR, SPECULAR, textures);
+		loadTextures(material, aiTextureType_AMBIENT, AMBIENT, textures);
+		loadTextures(material, aiTextureType_HEIGHT, HEIGHT, textures);
+		loadTextures(material, aiTextureType_OPACITY, OPACITY, textures);
+
+		return data;
 	}
 
-	std::vector<Texture> Model::loadTextures(const aiMaterial* material, aiTextureType assimpTextureType, TextureType textureType)
+	void Model::loadTextures(const aiMaterial* material, aiTextureType assimpTextureType, TextureType textureType, std::vector<Texture>& textures)
 	{
-		std::vector<Texture> textures;
 		for (size_t i = 0; i < material->GetTextureCount(assimpTextureType); ++i)
 		{
 			aiString path;
 			material->GetTexture(assimpTextureType, i, &path);
-			bool cached = false;
-			for (size_t j = 0; j < _cache.size(); ++j)
-			{
-				if (!std::strcmp(_cache[j]._key.data(), path.C_Str()))
-				{
-					textures.emplace_back(_cache[j]);
-					cached = true;
-					break;
-				}
-			}
-			if (!cached)
+			// The texture ID is filled in by resolveTextures once every mesh has been processed
+			textures.emplace_back(Texture{ 0, textureType, path.C_Str() });
+		}
+	}
+
+	void Model::resolveTextures(ImportData& data)
+	{
+		TextureLoader loader;
+		enqueueTextures(data, loader);
+		loader.finish();
+	}
+
+	void Model::enqueueTextures(ImportData& data, TextureLoader& loader)
+	{
+		// Every texture slot takes its own registry reference, which its mesh gives back on destruction.
+		// Repeated files are only decoded once and the rest decode in parallel. Bump maps are cooked as normal maps.
+		for (auto& entry : data._entries)
+		{
+			for (auto& texture : entry._textures)
 			{
-				_cache.emplace_back(Texture{ Utils::loadTexture((_directory + "/" + std::string(path.C_Str())).c_str()), textureType, path.C_Str() });
-				textures.emplace_back(_cache.back());
+				loader.enqueue(_directory + "/" + texture._key, &texture._ID, texture._textureType == HEIGHT ? USAGE_NORMAL : USAGE_COLOR);
 			}
 		}
-		return textures;
 	}
 }
\ No newline at end of file
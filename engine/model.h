@@ -2,25 +2,77 @@
 #include <assimp/scene.h>
 
 #include <engine/mesh.h>
+#include <engine/mesh_cache.h>
+#include <engine/texture_loader.h>
+
+#include <memory>
 
 namespace phoenix
 {
+	enum SubmissionMode
+	{
+		DIRECT, // A VAO bind and a draw per mesh
+		MULTI_DRAW_INDIRECT // One arena VAO bind and a multi-draw per texture set
+	};
+
 	class Model
 	{
 	public:
 		std::vector<Mesh*> _meshes;
 
-		Model(const std::string&);
+		// Loads synchronously, see ModelLoader for streaming
+		Model(const std::string&, VertexFormat = UNPACKED);
+
+		// Every mesh has been uploaded. Models still streaming in draw the meshes resident so far.
+		inline bool isResident() const
+		{
+			return _resident;
+		}
 
-		void render();
-		void render(const Shader&);
+		// Both reject packed models, every mesh of those needs its own world matrix, see Mesh::_dequantization
+		void render(SubmissionMode = DIRECT);
+		void render(const Shader&, SubmissionMode = DIRECT);
+		inline VertexFormat getVertexFormat() const
+		{
+			return _vertexFormat;
+		}
+
+		// Forces every mesh to the given LOD, clamped to the meshes' chains
+		void setLod(unsigned int);
+		// Selects the LOD of every mesh from its projected size, see Mesh::selectLod
+		void selectLod(const glm::mat4&, const glm::mat4&, const glm::mat4&, float, LodHint = LOD_MAIN);
+		// Meshlet culling for the next render call, see Mesh::cull. Returns the number of visible meshlets.
+		unsigned int cull(const glm::mat4&, const glm::mat4&, const glm::vec3&, bool = true);
 
 	private:
+		friend class ModelLoader;
+
+		// CPU side result of an import, views into either the mapped cache or the freshly processed meshes
+		struct ImportData
+		{
+			std::unique_ptr<MeshCache> _cache;
+			std::vector<MeshData> _meshes;
+			std::vector<MeshCache::Entry> _entries;
+		};
+
 		std::string _directory;
-		std::vector<Texture> _cache;
+		VertexFormat _vertexFormat;
+		bool _resident = false;
+		std::vector<std::vector<Mesh*>> _batches; // Meshes grouped by texture set
+		std::vector<DrawElementsIndirectCommand> _drawCommands;
+
+		void renderIndirect(const Shader*);
+
+		Model(VertexFormat);
 
-		void processNode(const aiScene*, const aiNode*);
-		Mesh* processMesh(const aiScene*, const aiMesh*);
-		std::vector<Texture> loadTextures(const aiMaterial*, aiTextureType, TextureType);
+		// Touches no GL state, so that it can run on a loader thread
+		void import(const std::string&, ImportData&);
+		void addMesh(const MeshCache::Entry&);
+		bool loadFromCache(const std::string&, ImportData&);
+		void processNode(const aiScene*, const aiNode*, std::vector<MeshData>&);
+		MeshData processMesh(const aiScene*, const aiMesh*);
+		void loadTextures(const aiMaterial*, aiTextureType, TextureType, std::vector<Texture>&);
+		void resolveTextures(ImportData&);
+		void enqueueTextures(ImportData&, TextureLoader&);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include <engine/model_loader.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace phoenix
+{
+	ModelLoader::ModelLoader(size_t uploadBudget, unsigned int numThreads) : _uploadBudget(uploadBudget)
+	{
+		numThreads = std::max(numThreads, 1u);
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			_workers.emplace_back(&ModelLoader::work, this);
+		}
+	}
+
+	Model* ModelLoader::load(const std::string& filename, VertexFormat vertexFormat, const std::function<void(Model&)>& onResident)
+	{
+		Model* model = new Model(vertexFormat);
+		std::lock_guard<std::mutex> lock(_mutex);
+		_loads.emplace_back();
+		Load& load = _loads.back();
+		load._model = model;
+		load._filename = filename;
+		load._onResident = onResident;
+		_jobs.push_back(&load);
+		_jobQueued.notify_one();
+		return model;
+	}
+
+	void ModelLoader::update()
+	{
+		{
+			// Imported loads are left alone by the workers from here on
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (auto& load : _loads)
+			{
+				if (load._imported && !load._texturesQueued)
+				{
+					load._model->enqueueTextures(load._data, _textureLoader);
+					load._texturesQueued = _texturesPending = true;
+				}
+			}
+		}
+
+		// Waits for decoding in the background rather than in finish
+		if (_texturesPending && _textureLoader.isReady())
+		{
+			_textureLoader.finish();
+			for (auto& load : _loads)
+			{
+				load._texturesResolved = load._texturesQueued;
+			}
+			_texturesPending = false;
+		}
+
+		size_t budget = _uploadBudget;
+		bool uploaded = false;
+		for (auto it = _loads.begin(); it != _loads.end();)
+		{
+			Load& load = *it;
+			if (!load._texturesResolved)
+			{
+				++it;
+				continue;
+			}
+
+			const auto& entries = load._data._entries;
+			const size_t vertexSize = getVertexSize(load._model->_vertexFormat);
+			while (load._numUploaded < entries.size())
+			{
+				const auto& entry = entries[load._numUploaded];
+				const size_t size = entry._numVertices * vertexSize + entry._numIndices * sizeof(unsigned int);
+				if (uploaded && size > budget)
+				{
+					return;
+				}
+				load._model->addMesh(entry);
+				budget -= std::min(size, budget);
+				uploaded = true;
+				++load._numUploaded;
+			}
+
+			load._model->_resident = true;
+			std::cout << "Model " << load._filename << " resident, imported in " << load._importTime << " ms\n";
+			if (load._onResident && !load._model->_meshes.empty())
+			{
+				load._onResident(*load._model);
+			}
+			it = _loads.erase(it);
+		}
+	}
+
+	ModelLoader::~ModelLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_jobQueued.notify_all();
+		for (auto& worker : _workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ModelLoader::work()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true)
+		{
+			_jobQueued.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+			if (_stopping)
+			{
+				return;
+			}
+			Load& load = *_jobs.front();
+			_jobs.pop_front();
+			lock.unlock();
+
+			auto importStart = std::chrono::high_resolution_clock::now();
+			load._model->import(load._filename, load._data);
+			load._importTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - importStart).count();
+
+			lock.lock();
+			load._imported = true;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include <engine/model.h>
+#include <engine/common.h>
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace phoenix
+{
+	// Streams models in without stalling the frame. Importing, optimization and cache reads run on worker threads,
+	// textures decode on the texture loader's pool, and the GL thread uploads meshes within a byte budget per frame.
+	// Models have to outlive their load.
+	class ModelLoader
+	{
+	public:
+		ModelLoader(size_t = MODEL_UPLOAD_BUDGET, unsigned int = std::thread::hardware_concurrency());
+
+		// Returns an empty model right away, update adds its meshes as they get uploaded. The callback runs on the
+		// GL thread once the model is resident, unless the import failed.
+		Model* load(const std::string&, VertexFormat = UNPACKED, const std::function<void(Model&)>& = nullptr);
+		// Does the GL side of loading on the calling thread, meant to be called once per frame. At least one mesh is
+		// uploaded per call, even when it exceeds the budget on its own.
+		void update();
+
+		inline bool isIdle() const
+		{
+			return _loads.empty();
+		}
+
+		~ModelLoader();
+
+	private:
+		struct Load
+		{
+			Model* _model;
+			std::string _filename;
+			std::function<void(Model&)> _onResident;
+			Model::ImportData _data;
+			bool _imported = false, _texturesQueued = false, _texturesResolved = false;
+			size_t _numUploaded = 0;
+			double _importTime = 0.0;
+		};
+
+		size_t _uploadBudget;
+		bool _stopping = false, _texturesPending = false;
+		std::list<Load> _loads; // List so that references held by workers survive further loads
+		std::deque<Load*> _jobs;
+		std::vector<std::thread> _workers;
+		std::mutex _mutex;
+		std::condition_variable _jobQueued;
+		TextureLoader _textureLoader;
+
+		void work();
+
+		ModelLoader(ModelLoader const&) = delete;
+		void operator=(ModelLoader const&) = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include <engine/render_graph.h>
+#include <engine/framebuffer.h>
+#include <engine/gl_state.h>
+#include <engine/strings.h>
+#include <engine/common.h>
+#include <algorithm>
+#include <iostream>
+
+namespace phoenix
+{
+	namespace
+	{
+		size_t getSize(const RenderGraph::TextureDesc& desc)
+		{
+			return static_cast<size_t>(desc._width) * desc._height * Framebuffer::getTexelSize(desc._internalFormat);
+		}
+
+		bool matches(const RenderGraph::TextureDesc& a, const RenderGraph::TextureDesc& b)
+		{
+			return a._width == b._width && a._height == b._height && a._internalFormat == b._internalFormat && a._clampToBorder == b._clampToBorder;
+		}
+	}
+
+	RenderGraph::Resource RenderGraph::createTexture(const std::string& name, const TextureDesc& desc)
+	{
+		_textures.push_back(VirtualTexture{ name, desc, SIZE_MAX, 0, SIZE_MAX });
+		return _textures.size() - 1;
+	}
+
+	void RenderGraph::addPass(const std::string& name, const std::vector<Resource>& reads, const std::vector<Resource>& writes, const std::function<void(const RenderGraph&)>& execute)
+	{
+		_passes.push_back(Pass{ name, reads, writes, execute, false });
+	}
+
+	void RenderGraph::compile()
+	{
+		// Walks back from the passes that always run, a pass is needed once a later one that runs reads its writes
+		std::vector<bool> needed(_textures.size(), false);
+		_numCulled = 0;
+		for (size_t i = _passes.size(); i-- > 0;)
+		{
+			Pass& pass = _passes[i];
+			pass._culled = !pass._writes.empty() && std::none_of(pass._writes.begin(), pass._writes.end(), [&needed](Resource resource) { return needed[resource]; });
+			if (pass._culled)
+			{
+				++_numCulled;
+				continue;
+			}
+			// Overwritten, so what earlier passes wrote only matters to the passes in between
+			for (Resource resource : pass._writes)
+			{
+				needed[resource] = false;
+			}
+			for (Resource resource : pass._reads)
+			{
+				needed[resource] = true;
+			}
+		}
+
+		for (size_t i = 0; i < _passes.size(); ++i)
+		{
+			if (_passes[i]._culled)
+			{
+				continue;
+			}
+			for (const auto* resources : { &_passes[i]._reads, &_passes[i]._writes })
+			{
+				for (Resource resource : *resources)
+				{
+					VirtualTexture& texture = _textures[resource];
+					texture._firstUse = std::min(texture._firstUse, i);
+					texture._lastUse = std::max(texture._lastUse, i);
+				}
+			}
+		}
+
+		// Textures take the first matching one of the pool that is free by the time they come alive
+		std::vector<Resource> order;
+		_declaredBytes = 0;
+		for (Resource resource = 0; resource < _textures.size(); ++resource)
+		{
+			_declaredBytes += getSize(_textures[resource]._desc);
+			if (_textures[resource]._firstUse != SIZE_MAX)
+			{
+				order.push_back(resource);
+			}
+		}
+		std::stable_sort(order.begin(), order.end(), [this](Resource a, Resource b)
+		{
+			return _textures[a]._firstUse < _textures[b]._firstUse;
+		});
+		for (auto& physical : _pool)
+		{
+			physical._availableFrom = 0;
+		}
+		_unaliasedBytes = 0;
+		for (Resource resource : order)
+		{
+			VirtualTexture& texture = _textures[resource];
+			texture._physical = getPhysicalTexture(texture._desc, texture._firstUse);
+			_pool[texture._physical]._availableFrom = texture._lastUse + 1;
+			_unaliasedBytes += getSize(texture._desc);
+		}
+
+		std::vector<bool> used(_pool.size(), false);
+		for (Resource resource : order)
+		{
+			used[_textures[resource]._physical] = true;
+		}
+		_numPhysical = _aliasedBytes = 0;
+		for (size_t i = 0; i < _pool.size(); ++i)
+		{
+			if (used[i])
+			{
+				++_numPhysical;
+				_aliasedBytes += getSize(_pool[i]._desc);
+			}
+		}
+	}
+
+	void RenderGraph::execute()
+	{
+		GLState& state = GLState::getInstance();
+		for (const Pass& pass : _passes)
+		{
+			if (pass._culled)
+			{
+				continue;
+			}
+			if (pass._writes.empty())
+			{
+				state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+			}
+			else
+			{
+				state.bindFramebuffer(GL_FRAMEBUFFER, getFramebuffer(pass._writes));
+				const TextureDesc& desc = _textures[pass._writes[0]]._desc;
+				state.viewport(0, 0, desc._width, desc._height);
+			}
+			pass._execute(*this);
+		}
+		state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void RenderGraph::reset()
+	{
+		_textures.clear();
+		_passes.clear();
+	}
+
+	unsigned int RenderGraph::getTexture(Resource resource) const
+	{
+		const size_t physical = _textures[resource]._physical;
+		return physical == SIZE_MAX ? 0 : _pool[physical]._textureID;
+	}
+
+	void RenderGraph::printStats() const
+	{
+		size_t pooledBytes = 0;
+		for (const auto& physical : _pool)
+		{
+			pooledBytes += getSize(physical._desc);
+		}
+		const double MB = 1024.0 * 1024.0;
+		std::cout << "Render graph: " << _passes.size() << " passes (" << _numCulled << " culled), " << _textures.size() << " textures, "
+			<< _declaredBytes / MB << " MB declared, " << _unaliasedBytes / MB << " MB used without aliasing, " << _aliasedBytes / MB << " MB aliased into "
+			<< _numPhysical << " textures, " << pooledBytes / MB << " MB pooled\n";
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		GLState& state = GLState::getInstance();
+		for (const auto& framebuffer : _framebuffers)
+		{
+			state.deleteFramebuffers(1, &framebuffer.second);
+		}
+		for (const auto& physical : _pool)
+		{
+			state.deleteTextures(1, &physical._textureID);
+		}
+	}
+
+	size_t RenderGraph::getPhysicalTexture(const TextureDesc& desc, size_t firstUse)
+	{
+		for (size_t i = 0; i < _pool.size(); ++i)
+		{
+			if (_pool[i]._availableFrom <= firstUse && matches(_pool[i]._desc, desc))
+			{
+				return i;
+			}
+		}
+
+		PhysicalTexture physical{ desc, 0, 0 };
+		glGenTextures(1, &physical._textureID);
+		GLState::getInstance().bindTexture(GL_TEXTURE_2D, physical._textureID);
+		glTexStorage2D(GL_TEXTURE_2D, 1, desc._internalFormat, desc._width, desc._height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		if (desc._clampToBorder)
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, BORDER_COLOR);
+		}
+		else
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		}
+		_pool.push_back(physical);
+		return _pool.size() - 1;
+	}
+
+	unsigned int RenderGraph::getFramebuffer(const std::vector<Resource>& writes)
+	{
+		std::vector<unsigned int> attachments;
+		for (Resource resource : writes)
+		{
+			attachments.push_back(getTexture(resource));
+		}
+		auto it = _framebuffers.find(attachments);
+		if (it != _framebuffers.end())
+		{
+			return it->second;
+		}
+
+		unsigned int FBO;
+		glGenFramebuffers(1, &FBO);
+		GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, FBO);
+		std::vector<GLenum> drawBuffers;
+		for (size_t i = 0; i < writes.size(); ++i)
+		{
+			const GLenum internalFormat = _textures[writes[i]]._desc._internalFormat;
+			if (Framebuffer::isDepthFormat(internalFormat))
+			{
+				const bool hasStencil = internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8;
+				glFramebufferTexture2D(GL_FRAMEBUFFER, hasStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, attachments[i], 0);
+			}
+			else
+			{
+				const GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(drawBuffers.size());
+				glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, attachments[i], 0);
+				drawBuffers.push_back(attachment);
+			}
+		}
+		if (drawBuffers.empty())
+		{
+			glDrawBuffer(GL_NONE);
+		}
+		else
+		{
+			glDrawBuffers(static_cast<int>(drawBuffers.size()), drawBuffers.data());
+		}
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cerr << FRAMEBUFFER_INIT_ERROR;
+		}
+		_framebuffers.emplace(attachments, FBO);
+		return FBO;
+	}
+}
\ No newline at end of file
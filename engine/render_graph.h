@@ -0,0 +1,85 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace phoenix
+{
+	// Passes of a frame together with the textures they read and write, declared anew every frame. Compiling culls
+	// the passes whose writes nothing that runs reads, and gives each texture the lifetime between the first and last
+	// pass that runs and uses it. Textures whose lifetimes don't overlap and whose descriptions match share one GL
+	// texture from a pool that persists across frames, so a chain of intermediate targets only costs as much memory
+	// as is alive at once. A pass overwrites its writes, which make up its framebuffer in the order given.
+	class RenderGraph
+	{
+	public:
+		typedef size_t Resource;
+
+		// Nearest filtered, and repeating unless clamped to a border of BORDER_COLOR. Depth formats become the depth
+		// attachment of the passes writing them.
+		struct TextureDesc
+		{
+			unsigned int _width, _height;
+			GLenum _internalFormat;
+			bool _clampToBorder;
+		};
+
+		RenderGraph() {}
+
+		// Only gets memory if a pass that runs uses it
+		Resource createTexture(const std::string&, const TextureDesc&);
+		// Passes without writes draw to the default framebuffer and always run. The viewport is set to the size of
+		// the writes, if there are any, before the function is called.
+		void addPass(const std::string&, const std::vector<Resource>&, const std::vector<Resource>&, const std::function<void(const RenderGraph&)>&);
+		void compile();
+		void execute();
+		// Drops the passes and textures of the frame, the pool and its framebuffers are kept
+		void reset();
+
+		// The GL texture a resource got, 0 if no pass that runs uses it. Meant for the functions of the passes.
+		unsigned int getTexture(Resource) const;
+		// Memory of the compiled frame, as declared, as allocated per texture without aliasing and as aliased
+		void printStats() const;
+
+		~RenderGraph();
+
+	private:
+		struct VirtualTexture
+		{
+			std::string _name;
+			TextureDesc _desc;
+			size_t _firstUse, _lastUse, _physical;
+		};
+
+		struct Pass
+		{
+			std::string _name;
+			std::vector<Resource> _reads, _writes;
+			std::function<void(const RenderGraph&)> _execute;
+			bool _culled;
+		};
+
+		struct PhysicalTexture
+		{
+			TextureDesc _desc;
+			unsigned int _textureID;
+			size_t _availableFrom; // First pass of the frame being compiled that may use it
+		};
+
+		std::vector<VirtualTexture> _textures;
+		std::vector<Pass> _passes;
+		std::vector<PhysicalTexture> _pool;
+		std::map<std::vector<unsigned int>, unsigned int> _framebuffers; // By attachments
+		size_t _numCulled = 0, _numPhysical = 0, _declaredBytes = 0, _unaliasedBytes = 0, _aliasedBytes = 0;
+
+		RenderGraph(RenderGraph const&) = delete;
+		void operator=(RenderGraph const&) = delete;
+
+		size_t getPhysicalTexture(const TextureDesc&, size_t);
+		unsigned int getFramebuffer(const std::vector<Resource>&);
+	};
+}
\ No newline at end of file
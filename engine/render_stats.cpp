@@ -0,0 +1,24 @@
+#include <engine/render_stats.h>
+#include <iostream>
+
+namespace phoenix
+{
+	RenderStats& RenderStats::getInstance()
+	{
+		static RenderStats instance;
+		return instance;
+	}
+
+	void RenderStats::reset()
+	{
+		_numDrawCalls = _numDrawCommands = _numVAOBinds = _numTextureBinds = _numUploadBytes = _numUploadStalls = _numStateChanges = _numFilteredStateChanges = 0;
+	}
+
+	void RenderStats::print() const
+	{
+		// A multi-draw counts as a single call issuing several commands
+		std::cout << _numDrawCalls << " draw calls (" << _numDrawCommands << " draws), " << _numVAOBinds << " VAO binds, " << _numTextureBinds << " texture binds, "
+			<< _numUploadBytes / 1024.0 << " KB uploaded with " << _numUploadStalls << " stalls, "
+			<< _numStateChanges << " state changes (" << _numFilteredStateChanges << " redundant ones filtered)\n";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+namespace phoenix
+{
+	// CPU side submission counters, to be reset once per frame by whoever wants to read them
+	class RenderStats
+	{
+	public:
+		size_t _numDrawCalls = 0, _numDrawCommands = 0, _numVAOBinds = 0, _numTextureBinds = 0, _numUploadBytes = 0, _numUploadStalls = 0;
+		size_t _numStateChanges = 0, _numFilteredStateChanges = 0; // GL state calls issued, and dropped because they changed nothing
+
+		static RenderStats& getInstance();
+
+		void reset();
+		void print() const;
+
+	private:
+		RenderStats() {}
+		RenderStats(RenderStats const&) = delete;
+		void operator=(RenderStats const&) = delete;
+	};
+}
\ No newline at end of file
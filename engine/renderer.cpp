@@ -1,4 +1,6 @@
 #include <engine/renderer.h>
+#include <engine/gl_state.h>
+#include <engine/job_pool.h>
 #include <engine/material_store.h>
 #include <engine/strings.h>
 #include <engine/common.h>
@@ -7,9 +9,29 @@
 
 namespace phoenix
 {
+	namespace
+	{
+		// std140 layouts of the blocks in common/camera_block.glsl and voxel_cone_tracing/object_block.glsl
+		struct CameraBlock
+		{
+			glm::mat4 _VP;
+			glm::vec3 _viewPos;
+			float _padding;
+		};
+
+		struct ObjectBlock
+		{
+			glm::mat4 _worldMatrix;
+			glm::vec4 _normalMatrix[3]; // Every column of a mat3 is padded to a vec4
+			Material::Block _material;
+		};
+	}
+
 	Renderer::Renderer()
 	{
-		glEnable(GL_MULTISAMPLE);
+		GLState::getInstance().enable(GL_MULTISAMPLE);
+		_uniformBuffer = new UniformBuffer();
+		_drawBucket = new DrawBucket();
 		_renderShader = MaterialStore::getInstance().getMaterial("render");
 		initVoxelization();
 		initVoxelVisualization();
@@ -17,6 +39,7 @@ namespace phoenix
 
 	void Renderer::render(VoxelConeTracingScene* scene, RenderMode renderMode)
 	{
+		_uniformBuffer->reset();
 		voxelize(scene);
 
 		switch (renderMode)
@@ -32,24 +55,25 @@ namespace phoenix
 
 	void Renderer::renderScene(VoxelConeTracingScene* scene)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLState& state = GLState::getInstance();
+		state.bindFramebuffer(GL_FRAMEBUFFER, 0);
 		_renderShader->use();
 
-		glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+		state.viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
-		glCullFace(GL_BACK);
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		state.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		state.enable(GL_DEPTH_TEST);
+		state.enable(GL_CULL_FACE);
+		state.cullFace(GL_BACK);
+		state.enable(GL_BLEND);
+		state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		setCameraUniforms(*_renderShader, scene->_camera);
-		scene->_pointLight->setUniforms(*_renderShader);
+		bindCameraBlock(scene->_camera);
+		_uniformBuffer->bind<PointLight::Block>(LIGHT_BLOCK_BINDING, _uniformBuffer->push(scene->_pointLight->getBlock()));
 
-		renderMeshes(scene->_meshes, *_renderShader);
+		renderMeshes(scene->_meshes, *_renderShader, scene->_camera->getViewMatrix(), getProjection(scene->_camera), SCREEN_HEIGHT);
 	}
 
 	void Renderer::initVoxelization()
@@ -61,77 +85,82 @@ namespace phoenix
 
 	void Renderer::voxelize(VoxelConeTracingScene* scene)
 	{
+		GLState& state = GLState::getInstance();
 		std::array<float, 4> clearColor{ { 0.0f, 0.0f, 0.0f, 0.0f } };
 		_voxelTexture->clear(clearColor);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		state.bindFramebuffer(GL_FRAMEBUFFER, 0);
 		_voxelizeShader->use();
 
-		glViewport(0, 0, _voxelTextureRes, _voxelTextureRes);
+		state.viewport(0, 0, _voxelTextureRes, _voxelTextureRes);
 
-		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-		glDisable(GL_CULL_FACE);
-		glDisable(GL_DEPTH_TEST);
-		glDisable(GL_BLEND);
+		state.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		state.disable(GL_CULL_FACE);
+		state.disable(GL_DEPTH_TEST);
+		state.disable(GL_BLEND);
 
 		_voxelTexture->bind(*_voxelizeShader, phoenix::G_TEXTURE_3D, 0);
 		glBindImageTexture(0, _voxelTexture->_textureID, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8);
 
-		scene->_pointLight->setUniforms(*_voxelizeShader);
+		_uniformBuffer->bind<PointLight::Block>(LIGHT_BLOCK_BINDING, _uniformBuffer->push(scene->_pointLight->getBlock()));
 
-		renderMeshes(scene->_meshes, *_voxelizeShader);
+		// The voxel grid spans [-1, 1] in world space, so an identity projection yields sizes in voxels
+		renderMeshes(scene->_meshes, *_voxelizeShader, glm::mat4(1.0f), glm::mat4(1.0f), static_cast<float>(_voxelTextureRes), LOD_VOXELIZATION);
 		glGenerateMipmap(GL_TEXTURE_3D);
 
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		state.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 	}
 
 	void Renderer::initVoxelVisualization()
 	{
 		_worldPositionOutputShader = MaterialStore::getInstance().getMaterial("world_position_output");
 		_visualizeVoxelsShader = MaterialStore::getInstance().getMaterial("visualize_voxels");
-		_backfaceBuffer = new Framebuffer(SCREEN_HEIGHT, SCREEN_WIDTH);
-		_frontfaceBuffer = new Framebuffer(SCREEN_HEIGHT, SCREEN_WIDTH);
+		_cubeWorldMatrix = _worldPositionOutputShader->getUniform(G_WORLD_MATRIX);
+		// World positions, both are read at once so they can't share a framebuffer
+		const Framebuffer::Desc desc{ SCREEN_HEIGHT, SCREEN_WIDTH, { { GL_RGB16F } }, { GL_DEPTH_COMPONENT24 }, true };
+		_backfaceBuffer = new Framebuffer(desc);
+		_frontfaceBuffer = new Framebuffer(desc);
 		_cubeModel = new Model("../Resources/Objects/cube.obj");
 		_quadMesh = Utils::createQuad();
 	}
 
 	void Renderer::renderVoxelVisualization(VoxelConeTracingScene* scene)
 	{
+		GLState& state = GLState::getInstance();
 		// Render a cube that will have each pixel store the world positions of its front
 		// and back face. This cube is representative of our 3D voxel texture, and we will use
 		// our positions to calculate corresponding pixel colors using ray marching.
 		_worldPositionOutputShader->use();
-		setCameraUniforms(*_worldPositionOutputShader, scene->_camera);
+		bindCameraBlock(scene->_camera);
+		_uniformBuffer->upload();
 
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glEnable(GL_CULL_FACE);
-		glEnable(GL_DEPTH_TEST);
+		state.enable(GL_CULL_FACE);
+		state.enable(GL_DEPTH_TEST);
 
-		glCullFace(GL_FRONT);
-		glBindFramebuffer(GL_FRAMEBUFFER, _backfaceBuffer->_FBO);
-		glViewport(0, 0, _backfaceBuffer->_width, _backfaceBuffer->_height);
+		state.cullFace(GL_FRONT);
+		state.bindFramebuffer(GL_FRAMEBUFFER, _backfaceBuffer->_FBO);
+		state.viewport(0, 0, _backfaceBuffer->_width, _backfaceBuffer->_height);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glm::mat4 world = glm::mat4(1.0f);
 		world = glm::translate(world, _cubeModel->_meshes.back()->_translation);
 		world = glm::rotate(world, _cubeModel->_meshes.back()->_rotation, _cubeModel->_meshes.back()->_rotationAxis);
 		world = glm::scale(world, _cubeModel->_meshes.back()->_scale);
-		_worldPositionOutputShader->setMat4(G_WORLD_MATRIX, world);
+		_worldPositionOutputShader->setMat4(_cubeWorldMatrix, world * _cubeModel->_meshes.back()->_dequantization);
 		_cubeModel->render();
 
-		glCullFace(GL_BACK);
-		glBindFramebuffer(GL_FRAMEBUFFER, _frontfaceBuffer->_FBO);
-		glViewport(0, 0, _frontfaceBuffer->_width, _frontfaceBuffer->_height);
+		state.cullFace(GL_BACK);
+		state.bindFramebuffer(GL_FRAMEBUFFER, _frontfaceBuffer->_FBO);
+		state.viewport(0, 0, _frontfaceBuffer->_width, _frontfaceBuffer->_height);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		_cubeModel->render();
 
 		// Splat the 3D texture onto our screen
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		state.bindFramebuffer(GL_FRAMEBUFFER, 0);
 		_visualizeVoxelsShader->use();
-		setCameraUniforms(*_visualizeVoxelsShader, scene->_camera);
 
-		glDisable(GL_DEPTH_TEST);
-		glEnable(GL_CULL_FACE);
+		state.disable(GL_DEPTH_TEST);
+		state.enable(GL_CULL_FACE);
 
 		// Ray march from the front to the back face world positions and accumulate/sample colors
 		// from our voxel texture along the way to get an accurate picture/projection of the voxelized
@@ -140,13 +169,15 @@ namespace phoenix
 		_frontfaceBuffer->bindTexture(*_visualizeVoxelsShader, "gFrontfaceTexture", 1);
 		_voxelTexture->bind(*_visualizeVoxelsShader, phoenix::G_TEXTURE_3D, 2);
 
-		glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+		state.viewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		_quadMesh->render();
 	}
 
 	Renderer::~Renderer()
 	{
+		delete _uniformBuffer;
+		delete _drawBucket;
 		if (_voxelTexture)
 		{
 			delete _voxelTexture;
@@ -169,29 +200,78 @@ namespace phoenix
 		}
 	}
 
-	void Renderer::setCameraUniforms(const Shader& shader, Camera* camera)
+	glm::mat4 Renderer::getProjection(const Camera* camera) const
 	{
-		shader.setMat4(G_VP, glm::perspective(glm::radians(camera->_FOV), static_cast<float>(SCREEN_WIDTH) / SCREEN_HEIGHT, PERSPECTIVE_NEAR_PLANE, PERSPECTIVE_FAR_PLANE) * camera->getViewMatrix());
-		shader.setVec3(G_VIEW_POS, camera->_position);
+		return glm::perspective(glm::radians(camera->_FOV), static_cast<float>(SCREEN_WIDTH) / SCREEN_HEIGHT, PERSPECTIVE_NEAR_PLANE, PERSPECTIVE_FAR_PLANE);
 	}
 
-	void Renderer::renderMeshes(const std::vector<Mesh*>& meshes, const Shader& shader) const
+	void Renderer::bindCameraBlock(Camera* camera)
 	{
-		for (auto& mesh : meshes)
+		const CameraBlock block{ getProjection(camera) * camera->getViewMatrix(), camera->_position, 0.0f };
+		_uniformBuffer->bind<CameraBlock>(CAMERA_BLOCK_BINDING, _uniformBuffer->push(block));
+	}
+
+	void Renderer::renderMeshes(const std::vector<Mesh*>& meshes, const Shader& shader, const glm::mat4& view, const glm::mat4& projection, float viewportHeight, LodHint hint)
+	{
+		const glm::vec3 viewPos = glm::vec3(glm::inverse(view)[3]);
+		// Passes are told apart by their LOD hint
+		const unsigned int pass = static_cast<unsigned int>(hint);
+		const unsigned int program = _drawBucket->getProgramId(&shader);
+		const size_t numLists = (meshes.size() + RECORDING_CHUNK_SIZE - 1) / RECORDING_CHUNK_SIZE;
+		if (_commandLists.size() < numLists)
 		{
-			glm::mat4 world = glm::mat4(1.0f);
-			world = glm::translate(world, mesh->_translation);
-			world = glm::rotate(world, mesh->_rotation, mesh->_rotationAxis);
-			world = glm::scale(world, mesh->_scale);
-			shader.setMat4(G_WORLD_MATRIX, world);
-			shader.setMat3(G_NORMAL_MATRIX, glm::mat3(glm::transpose(glm::inverse(world))));
-
-			if (mesh->_material)
+			_commandLists.resize(numLists, CommandList(_uniformBuffer->getAlignment()));
+		}
+		// Every mesh is in a single chunk, so the LOD and culling results it keeps are only written by one job
+		JobPool::getInstance().parallelFor(meshes.size(), RECORDING_CHUNK_SIZE, [&](size_t begin, size_t end)
+		{
+			CommandList& commandList = _commandLists[begin / RECORDING_CHUNK_SIZE];
+			for (size_t i = begin; i < end; ++i)
 			{
-				mesh->_material->setUniforms(shader);
+				recordMesh(commandList, meshes[i], view, projection, viewPos, viewportHeight, pass, program, hint);
 			}
+		});
 
-			mesh->render();
+		for (size_t i = 0; i < numLists; ++i)
+		{
+			_commandLists[i].replay(*_uniformBuffer, *_drawBucket);
+			_commandLists[i].clear();
+		}
+		_uniformBuffer->upload();
+
+		_drawBucket->sort();
+		_drawBucket->submit(*_uniformBuffer, OBJECT_BLOCK_BINDING, sizeof(ObjectBlock));
+		_drawBucket->clear();
+	}
+
+	void Renderer::recordMesh(CommandList& commandList, Mesh* mesh, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos, float viewportHeight,
+		unsigned int pass, unsigned int program, LodHint hint)
+	{
+		static const Material::Block DEFAULT_MATERIAL = Material().getBlock();
+		glm::mat4 world = glm::mat4(1.0f);
+		world = glm::translate(world, mesh->_translation);
+		world = glm::rotate(world, mesh->_rotation, mesh->_rotationAxis);
+		world = glm::scale(world, mesh->_scale);
+
+		ObjectBlock block;
+		block._worldMatrix = world * mesh->_dequantization;
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world)));
+		for (int column = 0; column < 3; ++column)
+		{
+			block._normalMatrix[column] = glm::vec4(normalMatrix[column], 0.0f);
+		}
+		block._material = mesh->_material ? mesh->_material->getBlock() : DEFAULT_MATERIAL;
+		const size_t offset = commandList.pushBlock(block);
+
+		// Only the next render call consumes the LOD and culling result, and every mesh is drawn once per bucket
+		mesh->selectLod(mesh->getScreenSize(world, view, projection, viewportHeight), hint);
+		if (hint == LOD_MAIN)
+		{
+			// The main pass culls back faces, so meshlets facing away from the camera can be skipped as a whole
+			mesh->cull(world, projection * view, viewPos);
 		}
+		const float depth = -(view * world * glm::vec4(mesh->getBoundingCenter(), 1.0f)).z;
+		const uint64_t key = DrawBucket::makeKey(pass, program, DrawBucket::getMaterialId(mesh->_material), _drawBucket->getTextureSetId(mesh->getTextures()), depth);
+		commandList.draw(key, mesh, offset);
 	}
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include <engine/framebuffer.h>
 #include <engine/model.h>
 #include <engine/voxel_cone_tracing_scene.h>
+#include <engine/uniform_buffer.h>
+#include <engine/command_list.h>
+#include <engine/common.h>
 
 namespace phoenix
 {
@@ -22,14 +25,20 @@ namespace phoenix
 		~Renderer();
 
 	private:
+		// Camera, light and per mesh blocks of the current frame
+		UniformBuffer* _uniformBuffer;
+		// Draws of the pass being rendered, recorded into one list per chunk of meshes and sorted before they are submitted
+		DrawBucket* _drawBucket;
+		std::vector<CommandList> _commandLists;
 		Shader* _renderShader;
 		// Voxelization variables
 		Shader* _voxelizeShader;
 		Texture3D* _voxelTexture;
-		int _voxelTextureRes = 64;
+		int _voxelTextureRes = VOXEL_GRID_RES;
 		// Voxel render mode variables
 		Shader* _worldPositionOutputShader;
 		Shader* _visualizeVoxelsShader;
+		Shader::Uniform _cubeWorldMatrix;
 		Framebuffer* _backfaceBuffer;
 		Framebuffer* _frontfaceBuffer;
 		Model* _cubeModel;
@@ -46,7 +55,13 @@ namespace phoenix
 		void initVoxelVisualization();
 		void renderVoxelVisualization(VoxelConeTracingScene*);
 
-		void setCameraUniforms(const Shader&, Camera*);
-		void renderMeshes(const std::vector<Mesh*>&, const Shader&) const;
+		glm::mat4 getProjection(const Camera*) const;
+		void bindCameraBlock(Camera*);
+		// Selects every mesh's LOD from its size in the viewport of the given view and projection. Chunks of meshes are
+		// recorded on the job pool, only their replay and the submission in the order of the draw bucket touch GL. The
+		// per mesh blocks and everything pushed before them are uploaded in one go ahead of the first draw.
+		void renderMeshes(const std::vector<Mesh*>&, const Shader&, const glm::mat4&, const glm::mat4&, float, LodHint = LOD_MAIN);
+		// Builds the mesh's block and draw on whichever thread records its chunk
+		void recordMesh(CommandList&, Mesh*, const glm::mat4&, const glm::mat4&, const glm::vec3&, float, unsigned int, unsigned int, LodHint);
 	};
 }
\ No newline at end of file
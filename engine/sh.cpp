@@ -3,6 +3,7 @@
 
 #include <engine/sh.h>
 #include <engine/common.h>
+#include <engine/gl_state.h>
 
 namespace phoenix
 {
@@ -82,7 +83,7 @@ namespace phoenix
 		glm::vec3 L;
 
 		float* img = new float[3 * resolution * resolution];
-		glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+		GLState::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, texture);
 		for (size_t s = 0; s < NUM_CUBEMAP_FACES; ++s)
 		{
 			glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + s, 0, GL_RGB, GL_FLOAT, img);
@@ -1,174 +1,518 @@
 #include <engine/shader.h>
 #include <engine/strings.h>
+#include <engine/asset_archive.h>
+#include <engine/mapped_file.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <sstream>
 #include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// GL_KHR_parallel_shader_compile is not part of the loaded core profile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint);
 
 namespace phoenix
 {
-	Shader::Shader(const char* cShaderFilename)
+	namespace
 	{
-		std::string cShaderStr;
-		std::ifstream cShaderFileStream;
-		cShaderFileStream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		const char MAGIC[4] = { 'P', 'X', 'S', 'B' };
+		// Bump whenever the layout changes
+		const uint32_t VERSION = 1;
+		const char* const CACHE_DIRECTORY = "../Resources/ShaderCache";
 
-		try
+		struct Header
 		{
-			cShaderFileStream.open(cShaderFilename);
+			char _magic[4];
+			uint32_t _version;
+			uint64_t _hash;
+			uint32_t _format;
+			uint32_t _size;
+		};
+
+		std::string getCachePath(uint64_t hash)
+		{
+			char name[32];
+			std::snprintf(name, sizeof(name), "/%016llx.pxsb", static_cast<unsigned long long>(hash));
+			return CACHE_DIRECTORY + std::string(name);
+		}
+
+		uint64_t hashString(const GLubyte* string, uint64_t hash)
+		{
+			const char* characters = reinterpret_cast<const char*>(string);
+			return characters ? AssetArchive::getHash(string, std::strlen(characters) + 1, hash) : hash;
+		}
 
-			std::stringstream cShaderStrStream;
-			cShaderStrStream << cShaderFileStream.rdbuf();
+		struct SourceFile
+		{
+			std::string _code;
+			uint64_t _size = 0;
+			int64_t _modified = 0;
+			bool _archived = false;
+		};
+
+		struct Dependency
+		{
+			std::string _filename;
+			uint64_t _size;
+			int64_t _modified;
+			bool _archived;
+		};
+
+		// A stage's source with every #include resolved. Each file has its own source string number in the #line
+		// directives, which is its index here.
+		struct ExpandedSource
+		{
+			std::string _code;
+			std::vector<Dependency> _dependencies;
+		};
 
-			cShaderFileStream.close();
+		struct PendingShader
+		{
+			unsigned int _shader;
+			const char* _name;
+			std::vector<std::string> _filenames;
+		};
 
-			cShaderStr = cShaderStrStream.str();
+		struct PendingProgram
+		{
+			std::vector<PendingShader> _shaders;
+			std::string _filenames, _cachePath;
+			uint64_t _hash;
+			std::shared_ptr<std::unordered_map<std::string, int>> _uniforms;
+			std::chrono::high_resolution_clock::time_point _submitted;
+		};
+
+		std::unordered_map<unsigned int, PendingProgram> pendingPrograms;
+		// Shared files are read once for every program that includes them, and expanded sources once per stage file
+		std::unordered_map<std::string, SourceFile> sourceFiles;
+		std::unordered_map<std::string, ExpandedSource> expandedSources;
+
+		// Archived files can't change, loose ones are checked against their size and modification time
+		bool isCurrent(const std::string& filename, uint64_t size, int64_t modified, bool archived)
+		{
+			uint64_t currentSize;
+			int64_t currentModified;
+			return archived || (MappedFile::getFileInfo(filename, currentSize, currentModified) && currentSize == size && currentModified == modified);
 		}
-		catch (std::ifstream::failure e)
+
+		const SourceFile* readSource(const std::string& filename)
 		{
-			std::cerr << FILE_STREAM_OPEN_ERROR;
+			auto cached = sourceFiles.find(filename);
+			if (cached != sourceFiles.end() && isCurrent(filename, cached->second._size, cached->second._modified, cached->second._archived))
+			{
+				return &cached->second;
+			}
+			MappedFile file(filename);
+			if (!file.isOpen())
+			{
+				return nullptr;
+			}
+			SourceFile& source = sourceFiles[filename];
+			source._code.assign(reinterpret_cast<const char*>(file.data()), file.size());
+			source._archived = file.isArchived();
+			if (!source._archived)
+			{
+				MappedFile::getFileInfo(filename, source._size, source._modified);
+			}
+			return &source;
 		}
 
-		const char* cShaderCode = cShaderStr.c_str();
+		// Parses a line like C does, #include "file" with the path relative to the including file
+		bool parseInclude(const std::string& code, size_t begin, size_t end, std::string& path)
+		{
+			static const char INCLUDE_DIRECTIVE[] = "#include";
+			const size_t directive = code.find_first_not_of(" \t", begin);
+			if (directive >= end || code.compare(directive, sizeof(INCLUDE_DIRECTIVE) - 1, INCLUDE_DIRECTIVE))
+			{
+				return false;
+			}
+			const size_t open = code.find('"', directive);
+			const size_t close = open < end ? code.find('"', open + 1) : std::string::npos;
+			if (close >= end)
+			{
+				return false;
+			}
+			path = code.substr(open + 1, close - open - 1);
+			return true;
+		}
 
-		unsigned int cShader;
+		bool expandSource(const std::string& filename, ExpandedSource& expanded)
+		{
+			const SourceFile* source = readSource(filename);
+			expanded._dependencies.push_back(Dependency{ filename, source ? source->_size : 0, source ? source->_modified : 0, source && source->_archived });
+			if (!source)
+			{
+				std::cerr << FILE_STREAM_OPEN_ERROR << filename << "\n";
+				return false;
+			}
 
-		cShader = glCreateShader(GL_COMPUTE_SHADER);
-		glShaderSource(cShader, 1, &cShaderCode, nullptr);
-		glCompileShader(cShader);
-		checkCompileErrors(cShader, "compute");
+			const std::string& code = source->_code;
+			const std::string index = std::to_string(expanded._dependencies.size() - 1);
+			const std::string directory = filename.substr(0, filename.find_last_of('/') + 1);
+			size_t begin = 0;
+			for (int line = 1; begin < code.size(); ++line)
+			{
+				size_t end = code.find('\n', begin);
+				end = end == std::string::npos ? code.size() : end + 1;
+				std::string path;
+				if (!parseInclude(code, begin, end, path))
+				{
+					expanded._code.append(code, begin, end - begin);
+				}
+				else
+				{
+					// Every file is only pulled in once per stage, as if it had include guards
+					path = AssetArchive::normalizePath(directory + path);
+					if (std::none_of(expanded._dependencies.begin(), expanded._dependencies.end(), [&path](const Dependency& dependency) { return dependency._filename == path; }))
+					{
+						expanded._code += "#line 1 " + std::to_string(expanded._dependencies.size()) + "\n";
+						if (!expandSource(path, expanded))
+						{
+							return false;
+						}
+						if (expanded._code.back() != '\n')
+						{
+							expanded._code += '\n';
+						}
+						expanded._code += "#line " + std::to_string(line + 1) + " " + index;
+					}
+					expanded._code += "\n";
+				}
+				begin = end;
+			}
+			return true;
+		}
 
-		_program = glCreateProgram();
-		glAttachShader(_program, cShader);
-		glLinkProgram(_program);
-		checkCompileErrors(_program, "program");
+		// Expanded again only when the file or anything it includes has changed since
+		const ExpandedSource& getSource(const char* filename)
+		{
+			const std::string path = AssetArchive::normalizePath(filename);
+			ExpandedSource& expanded = expandedSources[path];
+			if (!expanded._dependencies.empty() && std::all_of(expanded._dependencies.begin(), expanded._dependencies.end(), [](const Dependency& dependency)
+			{
+				return isCurrent(dependency._filename, dependency._size, dependency._modified, dependency._archived);
+			}))
+			{
+				return expanded;
+			}
+			expanded = ExpandedSource();
+			if (!expandSource(path, expanded))
+			{
+				expanded._code.clear();
+			}
+			return expanded;
+		}
 
-		glDeleteShader(cShader);
+		// Looked up on the first build, which lets the driver compile on as many threads as it likes
+		bool hasParallelCompile()
+		{
+			static const bool supported = []()
+			{
+				int numExtensions;
+				glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+				for (int i = 0; i < numExtensions; ++i)
+				{
+					const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+					if (!std::strcmp(extension, "GL_KHR_parallel_shader_compile") || !std::strcmp(extension, "GL_ARB_parallel_shader_compile"))
+					{
+						auto maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+						if (!maxShaderCompilerThreads)
+						{
+							maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+						}
+						if (maxShaderCompilerThreads)
+						{
+							maxShaderCompilerThreads(0xFFFFFFFF);
+						}
+						return true;
+					}
+				}
+				return false;
+			}();
+			return supported;
+		}
 	}
 
-	Shader::Shader(const char* vShaderFilename, const char* fShaderFilename)
+	size_t Shader::_numPending = 0;
+
+	Shader::Shader(const char* cShaderFilename, const Defines& defines)
 	{
-		std::string vShaderStr;
-		std::string fShaderStr;
-		std::ifstream vShaderFileStream;
-		std::ifstream fShaderFileStream;
-		vShaderFileStream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-		fShaderFileStream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		build({ { GL_COMPUTE_SHADER, cShaderFilename, "compute" } }, defines);
+	}
 
-		try
-		{
-			vShaderFileStream.open(vShaderFilename);
-			fShaderFileStream.open(fShaderFilename);
+	Shader::Shader(const char* vShaderFilename, const char* fShaderFilename, const Defines& defines)
+	{
+		build({ { GL_VERTEX_SHADER, vShaderFilename, "vertex" }, { GL_FRAGMENT_SHADER, fShaderFilename, "fragment" } }, defines);
+	}
 
-			std::stringstream vShaderStrStream, fShaderStrStream;
-			vShaderStrStream << vShaderFileStream.rdbuf();
-			fShaderStrStream << fShaderFileStream.rdbuf();
+	Shader::Shader(const char* vShaderFilename, const char* gShaderFilename, const char* fShaderFilename, const Defines& defines)
+	{
+		build({ { GL_VERTEX_SHADER, vShaderFilename, "vertex" }, { GL_GEOMETRY_SHADER, gShaderFilename, "geometry" },
+			{ GL_FRAGMENT_SHADER, fShaderFilename, "fragment" } }, defines);
+	}
 
-			vShaderFileStream.close();
-			fShaderFileStream.close();
+	void Shader::build(std::initializer_list<Stage> stages, const Defines& defines)
+	{
+		auto buildStart = std::chrono::high_resolution_clock::now();
 
-			vShaderStr = vShaderStrStream.str();
-			fShaderStr = fShaderStrStream.str();
+		// Binaries only load on the driver that produced them, so it is part of the key along with every stage
+		uint64_t hash = AssetArchive::getHash(nullptr, 0);
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			hash = hashString(glGetString(name), hash);
 		}
-		catch (std::ifstream::failure e)
+		std::string definitions, variant;
+		for (const auto& define : defines)
 		{
-			std::cerr << FILE_STREAM_OPEN_ERROR;
+			definitions += "#define " + define.first + " " + define.second + "\n";
+			variant += (variant.empty() ? " [" : ", ") + define.first + "=" + define.second;
 		}
-
-		const char* vShaderCode = vShaderStr.c_str();
-		const char* fShaderCode = fShaderStr.c_str();
-
-		unsigned int vShader, fShader;
-
-		vShader = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vShader, 1, &vShaderCode, nullptr);
-		glCompileShader(vShader);
-		checkCompileErrors(vShader, "vertex");
-
-		fShader = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fShader, 1, &fShaderCode, nullptr);
-		glCompileShader(fShader);
-		checkCompileErrors(fShader, "fragment");
+		hash = AssetArchive::getHash(reinterpret_cast<const unsigned char*>(definitions.data()), definitions.size(), hash);
+		// Hashing the expanded sources misses the cache for exactly the programs that include a changed file
+		std::vector<const ExpandedSource*> sources;
+		std::string filenames;
+		for (const auto& stage : stages)
+		{
+			sources.push_back(&getSource(stage._filename));
+			hash = AssetArchive::getHash(reinterpret_cast<const unsigned char*>(&stage._type), sizeof(stage._type), hash);
+			hash = AssetArchive::getHash(reinterpret_cast<const unsigned char*>(sources.back()->_code.data()), sources.back()->_code.size(), hash);
+			filenames += (filenames.empty() ? "" : ", ") + std::string(stage._filename);
+		}
+		filenames += variant.empty() ? "" : variant + "]";
+		const std::string cachePath = getCachePath(hash);
 
 		_program = glCreateProgram();
-		glAttachShader(_program, vShader);
-		glAttachShader(_program, fShader);
-		glLinkProgram(_program);
-		checkCompileErrors(_program, "program");
+		_uniforms = std::make_shared<std::unordered_map<std::string, int>>();
+		if (loadBinary(_program, cachePath, hash))
+		{
+			reflectUniforms(_program, *_uniforms);
+			std::cout << "Loaded " << filenames << " from the program cache in "
+				<< std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count() << " ms\n";
+			return;
+		}
 
-		glDeleteShader(vShader);
-		glDeleteShader(fShader);
+		// Any status query would wait for the driver, so those are left to finish
+		hasParallelCompile();
+		PendingProgram& pending = pendingPrograms[_program];
+		auto source = sources.begin();
+		for (const auto& stage : stages)
+		{
+			std::vector<std::string> sourceFilenames;
+			for (const auto& dependency : (*source)->_dependencies)
+			{
+				sourceFilenames.push_back(dependency._filename);
+			}
+			pending._shaders.push_back(PendingShader{ compileShader(stage._type, (*source++)->_code, definitions), stage._name, sourceFilenames });
+			glAttachShader(_program, pending._shaders.back()._shader);
+		}
+		glProgramParameteri(_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(_program);
+		pending._filenames = filenames;
+		pending._cachePath = cachePath;
+		pending._hash = hash;
+		pending._uniforms = _uniforms;
+		pending._submitted = buildStart;
+		++_numPending;
 	}
 
-	Shader::Shader(const char* vShaderFilename, const char* gShaderFilename, const char* fShaderFilename)
+	Shader::Uniform Shader::getUniform(const std::string& name) const
 	{
-		std::string vShaderStr;
-		std::string gShaderStr;
-		std::string fShaderStr;
-		std::ifstream vShaderFileStream;
-		std::ifstream gShaderFileStream;
-		std::ifstream fShaderFileStream;
-		vShaderFileStream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-		gShaderFileStream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-		fShaderFileStream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-		try
+		if (_numPending)
 		{
-			vShaderFileStream.open(vShaderFilename);
-			gShaderFileStream.open(gShaderFilename);
-			fShaderFileStream.open(fShaderFilename);
-
-			std::stringstream vShaderStrStream, gShaderStrStream, fShaderStrStream;
-			vShaderStrStream << vShaderFileStream.rdbuf();
-			gShaderStrStream << gShaderFileStream.rdbuf();
-			fShaderStrStream << fShaderFileStream.rdbuf();
+			finish(_program);
+		}
+		auto uniform = _uniforms->find(name);
+		return Uniform{ uniform != _uniforms->end() ? uniform->second : -1 };
+	}
 
-			vShaderFileStream.close();
-			gShaderFileStream.close();
-			fShaderFileStream.close();
+	bool Shader::isReady() const
+	{
+		if (!pendingPrograms.count(_program) || !hasParallelCompile())
+		{
+			return true;
+		}
+		int complete;
+		glGetProgramiv(_program, GL_COMPLETION_STATUS_KHR, &complete);
+		return complete != 0;
+	}
 
-			vShaderStr = vShaderStrStream.str();
-			gShaderStr = gShaderStrStream.str();
-			fShaderStr = fShaderStrStream.str();
+	bool Shader::pollPending()
+	{
+		// Without the extension there is no telling, so everything is finished at once
+		std::vector<unsigned int> complete;
+		for (const auto& pending : pendingPrograms)
+		{
+			int status = 1;
+			if (hasParallelCompile())
+			{
+				glGetProgramiv(pending.first, GL_COMPLETION_STATUS_KHR, &status);
+			}
+			if (status)
+			{
+				complete.push_back(pending.first);
+			}
 		}
-		catch (std::ifstream::failure e)
+		for (unsigned int program : complete)
 		{
-			std::cerr << FILE_STREAM_OPEN_ERROR;
+			finish(program);
 		}
+		return pendingPrograms.empty();
+	}
 
-		const char* vShaderCode = vShaderStr.c_str();
-		const char* gShaderCode = gShaderStr.c_str();
-		const char* fShaderCode = fShaderStr.c_str();
-
-		unsigned int vShader, gShader, fShader;
+	void Shader::finishPending()
+	{
+		while (!pendingPrograms.empty())
+		{
+			finish(pendingPrograms.begin()->first);
+		}
+	}
 
-		vShader = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vShader, 1, &vShaderCode, nullptr);
-		glCompileShader(vShader);
-		checkCompileErrors(vShader, "vertex");
+	void Shader::finish(unsigned int program)
+	{
+		auto pending = pendingPrograms.find(program);
+		if (pending == pendingPrograms.end())
+		{
+			return;
+		}
+		for (const auto& shader : pending->second._shaders)
+		{
+			if (!checkCompileErrors(shader._shader, shader._name) && shader._filenames.size() > 1)
+			{
+				// Errors name files by their source string number
+				for (size_t i = 0; i < shader._filenames.size(); ++i)
+				{
+					std::cerr << i << ": " << shader._filenames[i] << "\n";
+				}
+			}
+		}
+		const bool linked = checkCompileErrors(program, "program");
+		for (const auto& shader : pending->second._shaders)
+		{
+			glDetachShader(program, shader._shader);
+			glDeleteShader(shader._shader);
+		}
+		std::cout << "Compiled " << pending->second._filenames << ", ready after "
+			<< std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - pending->second._submitted).count() << " ms\n";
+		if (linked)
+		{
+			reflectUniforms(program, *pending->second._uniforms);
+			saveBinary(program, pending->second._cachePath, pending->second._hash);
+		}
+		pendingPrograms.erase(pending);
+		--_numPending;
+	}
 
-		gShader = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(gShader, 1, &gShaderCode, nullptr);
-		glCompileShader(gShader);
-		checkCompileErrors(gShader, "geometry");
+	bool Shader::loadBinary(unsigned int program, const std::string& cachePath, uint64_t hash)
+	{
+		MappedFile file(cachePath);
+		if (!file.isOpen() || file.size() < sizeof(Header))
+		{
+			return false;
+		}
+		const Header* header = reinterpret_cast<const Header*>(file.data());
+		if (std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) || header->_version != VERSION || header->_hash != hash
+			|| file.size() < sizeof(Header) + header->_size)
+		{
+			return false;
+		}
+		// Drivers may still reject a binary after an update that kept the version string, which fails the link and
+		// has the program compiled from source instead
+		glProgramBinary(program, header->_format, file.data() + sizeof(Header), header->_size);
+		int success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		return success != 0;
+	}
 
-		fShader = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fShader, 1, &fShaderCode, nullptr);
-		glCompileShader(fShader);
-		checkCompileErrors(fShader, "fragment");
+	void Shader::saveBinary(unsigned int program, const std::string& cachePath, uint64_t hash)
+	{
+		int numFormats, size;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+		if (numFormats == 0 || size <= 0)
+		{
+			return;
+		}
+		Header header;
+		std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+		header._version = VERSION;
+		header._hash = hash;
+		std::vector<char> binary(size);
+		GLenum format;
+		glGetProgramBinary(program, size, &size, &format, binary.data());
+		header._format = format;
+		header._size = static_cast<uint32_t>(size);
+
+#ifdef _WIN32
+		_mkdir(CACHE_DIRECTORY);
+#else
+		mkdir(CACHE_DIRECTORY, 0755);
+#endif
+		std::ofstream stream(cachePath, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			std::cerr << "Could not write program binary " << cachePath << "!\n";
+			return;
+		}
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		stream.write(binary.data(), size);
+	}
 
-		_program = glCreateProgram();
-		glAttachShader(_program, vShader);
-		glAttachShader(_program, gShader);
-		glAttachShader(_program, fShader);
-		glLinkProgram(_program);
-		checkCompileErrors(_program, "program");
+	unsigned int Shader::compileShader(GLenum type, const std::string& source, const std::string& definitions)
+	{
+		const char* code = source.c_str();
+		const int length = static_cast<int>(source.size());
 
-		glDeleteShader(vShader);
-		glDeleteShader(gShader);
-		glDeleteShader(fShader);
+		// Defines have to follow #version, or lead the source without one, and #line keeps the line numbers in errors
+		// true to the file
+		unsigned int shader = glCreateShader(type);
+		if (!definitions.empty())
+		{
+			static const char VERSION_DIRECTIVE[] = "#version";
+			const char* version = std::search(code, code + length, VERSION_DIRECTIVE, VERSION_DIRECTIVE + sizeof(VERSION_DIRECTIVE) - 1);
+			const char* versionEnd = code;
+			std::string injected;
+			if (version != code + length)
+			{
+				versionEnd = std::find(version, code + length, '\n');
+				if (versionEnd == code + length)
+				{
+					// #version is the last line
+					injected = "\n";
+				}
+				else
+				{
+					++versionEnd;
+				}
+			}
+			const int numLines = static_cast<int>(std::count(code, versionEnd, '\n'));
+			injected += definitions + "#line " + std::to_string(numLines + 1) + "\n";
+			const char* sources[3] = { code, injected.c_str(), versionEnd };
+			const int lengths[3] = { static_cast<int>(versionEnd - code), static_cast<int>(injected.size()), static_cast<int>(code + length - versionEnd) };
+			glShaderSource(shader, 3, sources, lengths);
+		}
+		else
+		{
+			glShaderSource(shader, 1, &code, &length);
+		}
+		glCompileShader(shader);
+		return shader;
 	}
 
-	void Shader::checkCompileErrors(unsigned int shaderID, const std::string shaderType)
+	bool Shader::checkCompileErrors(unsigned int shaderID, const std::string shaderType)
 	{
 		int success;
 		char log[_MSG_LEN];
@@ -191,5 +535,59 @@ namespace phoenix
 				std::cerr << "Error linking shaders!\n" << log << "\n";
 			}
 		}
+		return success != 0;
+	}
+
+	void Shader::reflectUniforms(unsigned int program, std::unordered_map<std::string, int>& uniforms)
+	{
+		int numUniforms, maxNameLength;
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+		std::vector<char> name(maxNameLength + 1);
+		const GLenum properties[2] = { GL_LOCATION, GL_ARRAY_SIZE };
+		for (int i = 0; i < numUniforms; ++i)
+		{
+			int values[2];
+			glGetProgramResourceiv(program, GL_UNIFORM, i, 2, properties, 2, nullptr, values);
+			// Members of uniform blocks have no location, they are set through their buffer
+			if (values[0] < 0)
+			{
+				continue;
+			}
+			int length;
+			glGetProgramResourceName(program, GL_UNIFORM, i, static_cast<int>(name.size()), &length, name.data());
+			const std::string uniformName(name.data(), length);
+			uniforms[uniformName] = values[0];
+
+			// Only the first element of an array is reported, so every element gets an entry of its own
+			static const std::string FIRST_ELEMENT = "[0]";
+			if (uniformName.size() > FIRST_ELEMENT.size() && !uniformName.compare(uniformName.size() - FIRST_ELEMENT.size(), FIRST_ELEMENT.size(), FIRST_ELEMENT))
+			{
+				const std::string arrayName = uniformName.substr(0, uniformName.size() - FIRST_ELEMENT.size());
+				uniforms[arrayName] = values[0];
+				for (int element = 1; element < values[1]; ++element)
+				{
+					uniforms[arrayName + "[" + std::to_string(element) + "]"] = values[0] + element;
+				}
+			}
+		}
+	}
+
+	ShaderVariants::ShaderVariants(const char* cShaderFilename) : _filenames{ cShaderFilename }
+	{
+	}
+
+	ShaderVariants::ShaderVariants(const char* vShaderFilename, const char* fShaderFilename) : _filenames{ vShaderFilename, fShaderFilename }
+	{
+	}
+
+	Shader& ShaderVariants::get(const Shader::Defines& defines)
+	{
+		std::unique_ptr<Shader>& variant = _variants[defines];
+		if (!variant)
+		{
+			variant.reset(_filenames.size() == 1 ? new Shader(_filenames[0].c_str(), defines) : new Shader(_filenames[0].c_str(), _filenames[1].c_str(), defines));
+		}
+		return *variant;
 	}
 }
\ No newline at end of file
@@ -1,84 +1,213 @@
 #pragma once
+#include <engine/gl_state.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <initializer_list>
+#include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace phoenix
 {
+	// Program linked from GLSL files. Linked programs are kept in an on-disk cache of driver program binaries, keyed
+	// by a hash of their sources and the driver, and are only compiled again when that cache misses. Compiling and
+	// linking is only submitted by the constructors, on the driver's own threads with GL_KHR_parallel_shader_compile,
+	// so build every program before loading assets. A program is checked for errors and cached once the driver
+	// reports it complete through pollPending, or at the latest on its first use. Defines specialize the program,
+	// so constants and modes compile into their own variant instead of being read from uniforms. Sources may pull in
+	// shared files with #include "path", relative to the including file, which are read once and kept expanded.
 	class Shader
 	{
 	public:
+		// Names and values, injected right after #version (or up front without one) as #define lines in this order
+		typedef std::vector<std::pair<std::string, std::string>> Defines;
+
+		// Location of a uniform, resolved once from the table reflected at link time. -1 if the program doesn't use it,
+		// which every setter ignores.
+		struct Uniform
+		{
+			int _location;
+
+			// Element of an array of basic types, whose locations are consecutive
+			inline Uniform operator[](int index) const
+			{
+				return Uniform{ _location < 0 ? -1 : _location + index };
+			}
+		};
+
 		unsigned int _program;
 
-		Shader(const char*);
-		Shader(const char*, const char*);
-		Shader(const char*, const char*, const char*);
+		Shader(const char*, const Defines& = Defines());
+		Shader(const char*, const char*, const Defines& = Defines());
+		Shader(const char*, const char*, const char*, const Defines& = Defines());
 
 		inline void use() const
 		{
-			glUseProgram(_program);
+			if (_numPending)
+			{
+				finish(_program);
+			}
+			GLState::getInstance().useProgram(_program);
 		}
+		// Looks the name up in the reflected table without asking the driver, finishing the program first if needed.
+		// Arrays of basic types are found by their name with or without [0].
+		Uniform getUniform(const std::string&) const;
+		// Whether the driver is done with the program, which never blocks
+		bool isReady() const;
+		// Finishes every program the driver is done with and returns true once none are left
+		static bool pollPending();
+		// Waits for every program still being compiled
+		static void finishPending();
 
 		inline void setBool(const std::string& name, bool v0) const
 		{
-			glUniform1i(glGetUniformLocation(_program, name.c_str()), static_cast<int>(v0));
+			glUniform1i(getUniform(name)._location, static_cast<int>(v0));
 		}
 		inline void setInt(const std::string& name, int v0) const
 		{
-			glUniform1i(glGetUniformLocation(_program, name.c_str()), v0);
+			glUniform1i(getUniform(name)._location, v0);
 		}
 		inline void setFloat(const std::string& name, float v0) const
 		{
-			glUniform1f(glGetUniformLocation(_program, name.c_str()), v0);
+			glUniform1f(getUniform(name)._location, v0);
 		}
 		inline void setVec2(const std::string& name, const glm::vec2& value) const
 		{
-			glUniform2fv(glGetUniformLocation(_program, name.c_str()), 1, &value[0]);
+			glUniform2fv(getUniform(name)._location, 1, &value[0]);
 		}
 		inline void setVec2(const std::string& name, float v0, float v1) const
 		{
-			glUniform2f(glGetUniformLocation(_program, name.c_str()), v0, v1);
+			glUniform2f(getUniform(name)._location, v0, v1);
 		}
 		inline void setIVec2(const std::string& name, const glm::ivec2& value) const
 		{
-			glUniform2iv(glGetUniformLocation(_program, name.c_str()), 1, &value[0]);
+			glUniform2iv(getUniform(name)._location, 1, &value[0]);
 		}
 		inline void setIVec2(const std::string& name, int v0, int v1) const
 		{
-			glUniform2i(glGetUniformLocation(_program, name.c_str()), v0, v1);
+			glUniform2i(getUniform(name)._location, v0, v1);
 		}
 		inline void setVec3(const std::string& name, const glm::vec3& value) const
 		{
-			glUniform3fv(glGetUniformLocation(_program, name.c_str()), 1, &value[0]);
+			glUniform3fv(getUniform(name)._location, 1, &value[0]);
 		}
 		inline void setVec3(const std::string& name, float v0, float v1, float v2) const
 		{
-			glUniform3f(glGetUniformLocation(_program, name.c_str()), v0, v1, v2);
+			glUniform3f(getUniform(name)._location, v0, v1, v2);
 		}
 		inline void setVec4(const std::string& name, const glm::vec4& value) const
 		{
-			glUniform4fv(glGetUniformLocation(_program, name.c_str()), 1, &value[0]);
+			glUniform4fv(getUniform(name)._location, 1, &value[0]);
 		}
 		inline void setVec4(const std::string& name, float v0, float v1, float v2, float v3) const
 		{
-			glUniform4f(glGetUniformLocation(_program, name.c_str()), v0, v1, v2, v3);
+			glUniform4f(getUniform(name)._location, v0, v1, v2, v3);
 		}
 		inline void setMat2(const std::string& name, const glm::mat2& value) const
 		{
-			glUniformMatrix2fv(glGetUniformLocation(_program, name.c_str()), 1, GL_FALSE, &value[0][0]);
+			glUniformMatrix2fv(getUniform(name)._location, 1, GL_FALSE, &value[0][0]);
 		}
 		inline void setMat3(const std::string& name, const glm::mat3& value) const
 		{
-			glUniformMatrix3fv(glGetUniformLocation(_program, name.c_str()), 1, GL_FALSE, &value[0][0]);
+			glUniformMatrix3fv(getUniform(name)._location, 1, GL_FALSE, &value[0][0]);
 		}
 		inline void setMat4(const std::string& name, const glm::mat4& value) const
 		{
-			glUniformMatrix4fv(glGetUniformLocation(_program, name.c_str()), 1, GL_FALSE, &value[0][0]);
+			glUniformMatrix4fv(getUniform(name)._location, 1, GL_FALSE, &value[0][0]);
+		}
+		inline void setBool(Uniform uniform, bool v0) const
+		{
+			glUniform1i(uniform._location, static_cast<int>(v0));
+		}
+		inline void setInt(Uniform uniform, int v0) const
+		{
+			glUniform1i(uniform._location, v0);
+		}
+		inline void setFloat(Uniform uniform, float v0) const
+		{
+			glUniform1f(uniform._location, v0);
+		}
+		inline void setVec2(Uniform uniform, const glm::vec2& value) const
+		{
+			glUniform2fv(uniform._location, 1, &value[0]);
+		}
+		inline void setVec2(Uniform uniform, float v0, float v1) const
+		{
+			glUniform2f(uniform._location, v0, v1);
+		}
+		inline void setIVec2(Uniform uniform, const glm::ivec2& value) const
+		{
+			glUniform2iv(uniform._location, 1, &value[0]);
+		}
+		inline void setIVec2(Uniform uniform, int v0, int v1) const
+		{
+			glUniform2i(uniform._location, v0, v1);
+		}
+		inline void setVec3(Uniform uniform, const glm::vec3& value) const
+		{
+			glUniform3fv(uniform._location, 1, &value[0]);
+		}
+		inline void setVec3(Uniform uniform, float v0, float v1, float v2) const
+		{
+			glUniform3f(uniform._location, v0, v1, v2);
+		}
+		inline void setVec4(Uniform uniform, const glm::vec4& value) const
+		{
+			glUniform4fv(uniform._location, 1, &value[0]);
+		}
+		inline void setVec4(Uniform uniform, float v0, float v1, float v2, float v3) const
+		{
+			glUniform4f(uniform._location, v0, v1, v2, v3);
+		}
+		inline void setMat2(Uniform uniform, const glm::mat2& value) const
+		{
+			glUniformMatrix2fv(uniform._location, 1, GL_FALSE, &value[0][0]);
+		}
+		inline void setMat3(Uniform uniform, const glm::mat3& value) const
+		{
+			glUniformMatrix3fv(uniform._location, 1, GL_FALSE, &value[0][0]);
+		}
+		inline void setMat4(Uniform uniform, const glm::mat4& value) const
+		{
+			glUniformMatrix4fv(uniform._location, 1, GL_FALSE, &value[0][0]);
 		}
 
 	private:
 		static const unsigned int _MSG_LEN = 1024;
 
-		void checkCompileErrors(unsigned int, const std::string);
+		struct Stage
+		{
+			GLenum _type;
+			const char* _filename;
+			const char* _name;
+		};
+
+		static size_t _numPending;
+		std::shared_ptr<std::unordered_map<std::string, int>> _uniforms;
+
+		void build(std::initializer_list<Stage>, const Defines&);
+		static void finish(unsigned int);
+		static bool loadBinary(unsigned int, const std::string&, uint64_t);
+		static void saveBinary(unsigned int, const std::string&, uint64_t);
+		static unsigned int compileShader(GLenum, const std::string&, const std::string&);
+		static bool checkCompileErrors(unsigned int, const std::string);
+		static void reflectUniforms(unsigned int, std::unordered_map<std::string, int>&);
+	};
+	// Variants of one program, each built the first time its defines are asked for. Ask for every variant that will be
+	// needed up front, so they all compile in parallel rather than stalling a frame later on.
+	class ShaderVariants
+	{
+	public:
+		ShaderVariants(const char*);
+		ShaderVariants(const char*, const char*);
+
+		Shader& get(const Shader::Defines&);
+
+	private:
+		std::vector<std::string> _filenames;
+		std::map<Shader::Defines, std::unique_ptr<Shader>> _variants;
 	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <engine/shadow_common.h>
+#include <engine/gl_state.h>
 #include <engine/strings.h>
 #include <engine/common.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -96,34 +97,46 @@ namespace phoenix
 
 	void ShadowCommon::changeColorTexture(unsigned int texture)
 	{
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture);
+		GLState::getInstance().activeTexture(GL_TEXTURE0);
+		GLState::getInstance().bindTexture(GL_TEXTURE_2D, texture);
 	}
 
-	void ShadowCommon::renderObject(const Utils* utils, const Shader& shader, Model& object, glm::vec3 translation, float rotation, glm::vec3 scale)
+	void ShadowCommon::renderObject(const Utils* utils, const Shader& shader, Model& object, glm::vec3 translation, float rotation, glm::vec3 scale, LodHint hint)
 	{
 		shader.use();
 		glm::mat4 world = glm::mat4(1.0f);
 		world = glm::translate(world, translation);
 		world = glm::scale(world, scale);
 		world = glm::rotate(world, glm::radians(rotation), UP);
+		shader.setMat3(G_NORMAL_MATRIX, glm::transpose(glm::inverse(glm::mat3(world))));
+		object.selectLod(world, utils->_view, utils->_projection, SCREEN_HEIGHT, hint);
+		if (object.getVertexFormat() == PACKED)
+		{
+			// Every packed mesh is quantized to its own bounds
+			for (auto mesh : object._meshes)
+			{
+				shader.setMat4(G_WVP, utils->_projection * utils->_view * world * mesh->_dequantization);
+				shader.setMat4(G_WORLD_MATRIX, world * mesh->_dequantization);
+				mesh->render();
+			}
+			return;
+		}
 		shader.setMat4(G_WVP, utils->_projection * utils->_view * world);
 		shader.setMat4(G_WORLD_MATRIX, world);
-		shader.setMat3(G_NORMAL_MATRIX, glm::transpose(glm::inverse(glm::mat3(world))));
 		object.render();
 	}
 
-	void ShadowCommon::renderScene(Utils* utils, const Shader& shader, Model& object)
+	void ShadowCommon::renderScene(Utils* utils, const Shader& shader, Model& object, LodHint hint)
 	{
 		utils->renderPlane(shader);
 		changeColorTexture(_objectTexture);
-		renderObject(utils, shader, object, glm::vec3(1.0f, 0.2f, 2.0f), 180.0f);
-		renderObject(utils, shader, object, glm::vec3(1.0f, 0.2f, -3.0f), 180.0f);
+		renderObject(utils, shader, object, glm::vec3(1.0f, 0.2f, 2.0f), 180.0f, OBJ_SCALE, hint);
+		renderObject(utils, shader, object, glm::vec3(1.0f, 0.2f, -3.0f), 180.0f, OBJ_SCALE, hint);
 		changeColorTexture(_altObjTexture);
-		renderObject(utils, shader, object, glm::vec3(1.0f, 0.2f, -8.0f), 180.0f);
-		renderObject(utils, shader, object, glm::vec3(-0.8f, 0.8f, 2.3f), 90.0f);
+		renderObject(utils, shader, object, glm::vec3(1.0f, 0.2f, -8.0f), 180.0f, OBJ_SCALE, hint);
+		renderObject(utils, shader, object, glm::vec3(-0.8f, 0.8f, 2.3f), 90.0f, OBJ_SCALE, hint);
 		changeColorTexture(_objectTexture);
-		renderObject(utils, shader, object, glm::vec3(-3.5f, 1.8f, 2.0f), 0.0f);
+		renderObject(utils, shader, object, glm::vec3(-3.5f, 1.8f, 2.0f), 0.0f, OBJ_SCALE, hint);
 	}
 
 	void ShadowCommon::setUniforms(const Shader& shader, const Camera* camera)
@@ -136,6 +149,7 @@ namespace phoenix
 
 	void ShadowCommon::renderDebugLines(const Shader& shader, Utils* utils)
 	{
+		GLState& state = GLState::getInstance();
 		shader.use();
 		glm::mat4 world = glm::mat4(1.0f);
 		world = glm::translate(world, _lightPos);
@@ -197,10 +211,10 @@ namespace phoenix
 			glBindBuffer(GL_ARRAY_BUFFER, _debugLinesVBO);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-			glBindVertexArray(_debugLinesVAO);
+			state.bindVertexArray(_debugLinesVAO);
 			glEnableVertexAttribArray(0);
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-			glBindVertexArray(0);
+			state.bindVertexArray(0);
 		}
 		else
 		{
@@ -208,11 +222,10 @@ namespace phoenix
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 		}
 
-		glBindVertexArray(_debugLinesVAO);
+		state.bindVertexArray(_debugLinesVAO);
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 		glDrawArrays(GL_LINES, 0, 24);
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glBindVertexArray(0);
 	}
 
 	void ShadowCommon::setLightSpaceVP(const Shader& shader, const glm::vec3& lightPos, const glm::vec3& lightDirection)
@@ -39,8 +39,9 @@ namespace phoenix
 		void processInput(GLFWwindow*, Camera*, bool);
 		// Assumes that the color texture is always bound to unit 0
 		void changeColorTexture(unsigned int);
-		void renderObject(const Utils*, const Shader&, Model&, glm::vec3, float, glm::vec3 = OBJ_SCALE);
-		void renderScene(Utils*, const Shader&, Model&);
+		// The LOD is picked from the object's size on the camera's screen, shadow passes pass LOD_SHADOW
+		void renderObject(const Utils*, const Shader&, Model&, glm::vec3, float, glm::vec3 = OBJ_SCALE, LodHint = LOD_MAIN);
+		void renderScene(Utils*, const Shader&, Model&, LodHint = LOD_MAIN);
 		void setUniforms(const Shader&, const Camera*);
 		void renderDebugLines(const Shader&, Utils*);
 		void setLightSpaceVP(const Shader&, const glm::vec3&, const glm::vec3&);
@@ -0,0 +1,141 @@
+#include <engine/staging_ring.h>
+#include <engine/render_stats.h>
+#include <glad/glad.h>
+#include <cstring>
+#include <iostream>
+
+namespace phoenix
+{
+	StagingRing& StagingRing::getInstance()
+	{
+		static StagingRing instance;
+		return instance;
+	}
+
+	StagingRing::StagingRing()
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &_buffer);
+		glBindBuffer(GL_COPY_READ_BUFFER, _buffer);
+		glBufferStorage(GL_COPY_READ_BUFFER, STAGING_RING_SIZE, nullptr, flags);
+		_data = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, STAGING_RING_SIZE, flags));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		if (!_data)
+		{
+			std::cerr << "Failed to map the staging ring, uploads go through the driver\n";
+		}
+	}
+
+	size_t StagingRing::stage(const void* data, size_t size, size_t alignment)
+	{
+		if (!_data || size > STAGING_RING_SIZE)
+		{
+			return SIZE_MAX;
+		}
+		// Whatever was staged before has been consumed by now, so it can be fenced off in chunks
+		if (_unfenced >= STAGING_RING_SIZE / STAGING_RING_FENCES)
+		{
+			fence();
+		}
+
+		size_t offset, required;
+		while (true)
+		{
+			offset = (_head + alignment - 1) / alignment * alignment;
+			if (offset + size > STAGING_RING_SIZE)
+			{
+				offset = 0; // The tail end is skipped
+			}
+			required = (offset >= _head ? offset - _head : STAGING_RING_SIZE - _head) + size;
+			if (STAGING_RING_SIZE - _used >= required)
+			{
+				break;
+			}
+			if (_used == 0)
+			{
+				_head = 0;
+				continue;
+			}
+			fence();
+			retire();
+		}
+
+		std::memcpy(_data + offset, data, size);
+		_head = offset + size;
+		_used += required;
+		_unfenced += required;
+		RenderStats::getInstance()._numUploadBytes += size;
+		return offset;
+	}
+
+	void StagingRing::upload(unsigned int buffer, size_t offset, const void* data, size_t size)
+	{
+		const size_t source = stage(data, size);
+		if (source == SIZE_MAX)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			return;
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, _buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source, offset, size);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	void StagingRing::uploadTexture(unsigned int target, int level, int internalFormat, int width, int height, unsigned int format, unsigned int type, const void* data,
+		size_t size)
+	{
+		const size_t source = stage(data, size);
+		if (source == SIZE_MAX)
+		{
+			glTexImage2D(target, level, internalFormat, width, height, 0, format, type, data);
+			return;
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+		glTexImage2D(target, level, internalFormat, width, height, 0, format, type, (void*)source);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	void StagingRing::uploadCompressedTexture(unsigned int target, int level, unsigned int internalFormat, int width, int height, const void* data, size_t size)
+	{
+		const size_t source = stage(data, size);
+		if (source == SIZE_MAX)
+		{
+			glCompressedTexImage2D(target, level, internalFormat, width, height, 0, size, data);
+			return;
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+		glCompressedTexImage2D(target, level, internalFormat, width, height, 0, size, (void*)source);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	void StagingRing::fence()
+	{
+		if (_unfenced == 0)
+		{
+			return;
+		}
+		_fences.push_back(Fence{ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), _unfenced });
+		_unfenced = 0;
+	}
+
+	void StagingRing::retire()
+	{
+		GLsync sync = static_cast<GLsync>(_fences.front()._sync);
+		GLenum status = glClientWaitSync(sync, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			++RenderStats::getInstance()._numUploadStalls;
+			do
+			{
+				status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // Nanoseconds
+			} while (status == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(sync);
+		_used -= _fences.front()._size;
+		_fences.pop_front();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <engine/common.h>
+
+#include <cstddef>
+#include <deque>
+
+namespace phoenix
+{
+	// Persistently mapped, coherent upload buffer shared by every CPU to GPU transfer. Data is written once into the
+	// ring and then copied on the GPU into buffers, or sourced by texture uploads as a pixel unpack buffer. Space is
+	// reclaimed through fences, so writes only stall when the GPU still reads the range about to be overwritten.
+	// A staged range has to be consumed by GL commands issued before the next stage call.
+	class StagingRing
+	{
+	public:
+		static StagingRing& getInstance();
+
+		// Copies the data into the ring and returns its offset, or SIZE_MAX if it can never fit
+		size_t stage(const void*, size_t, size_t = STAGING_ALIGNMENT);
+		// Staged copy into a buffer object at the given byte offset
+		void upload(unsigned int, size_t, const void*, size_t);
+		// Staged glTexImage2D, the unpack alignment is left to the caller
+		void uploadTexture(unsigned int, int, int, int, int, unsigned int, unsigned int, const void*, size_t);
+		// Staged glCompressedTexImage2D
+		void uploadCompressedTexture(unsigned int, int, unsigned int, int, int, const void*, size_t);
+		// Marks everything staged so far as in flight, meant to be called once per frame
+		void fence();
+
+		inline unsigned int getBuffer() const
+		{
+			return _buffer;
+		}
+
+	private:
+		struct Fence
+		{
+			void* _sync;
+			size_t _size; // Bytes written before the fence, padding included
+		};
+
+		unsigned int _buffer = 0;
+		unsigned char* _data = nullptr;
+		size_t _head = 0, _used = 0, _unfenced = 0;
+		std::deque<Fence> _fences;
+
+		StagingRing();
+		StagingRing(StagingRing const&) = delete;
+		void operator=(StagingRing const&) = delete;
+
+		void retire();
+	};
+}
\ No newline at end of file
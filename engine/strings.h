@@ -38,10 +38,12 @@ namespace phoenix
 	static const std::string G_STRETCH_MAP = "gStretchMap";
 	static const std::string G_PREVIOUS_FRAME_MAP = "gPreviousFrameMap";
 	static const std::string G_DIR = "gDir";
+	static const std::string G_FEEDBACK_ID = "gFeedbackID";
 
 	// Error messages
 	static const std::string GLFW_CREATE_WINDOW_ERROR = "Failed to create GLFW window!\n";
 	static const std::string GLAD_LOAD_GL_LOADER_ERROR = "Failed to initialize GLAD!\n";
 	static const std::string FILE_STREAM_OPEN_ERROR = "Exception opening/reading/closing file!\n";
 	static const std::string FRAMEBUFFER_INIT_ERROR = "Failed to initialize the framebuffer!\n";
+	static const std::string PACKED_RENDER_ERROR = "Packed meshes need their dequantization folded into the world matrix and have to be drawn one by one!\n";
 }
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include <engine/texture_cooker.h>
+#include <engine/gl_state.h>
+#include <engine/mip_builder.h>
+#include <engine/staging_ring.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// S3TC is not part of core GL, but supported by every desktop driver
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace phoenix
+{
+	namespace
+	{
+		const char MAGIC[4] = { 'P', 'X', 'T', 'C' };
+		// Bump whenever the layout, the encoders or the mip filter change
+		const uint32_t VERSION = 2;
+		const uint64_t BLOB_ALIGNMENT = 16;
+
+		struct Header
+		{
+			char _magic[4];
+			uint32_t _version;
+			uint64_t _sourceSize;
+			int64_t _sourceTimestamp;
+			uint32_t _usage;
+			uint32_t _format;
+			uint32_t _numLevels;
+		};
+
+		struct LevelRecord
+		{
+			uint64_t _offset, _size;
+			uint32_t _width, _height;
+		};
+
+		uint64_t align(uint64_t offset)
+		{
+			return (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+		}
+
+		unsigned int getBlockSize(unsigned int format)
+		{
+			return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+		}
+
+		unsigned int chooseFormat(TextureUsage usage, const unsigned char* data, int width, int height, int numChannels)
+		{
+			if (usage == USAGE_MASK || numChannels == 1)
+			{
+				return GL_COMPRESSED_RED_RGTC1;
+			}
+			if (usage == USAGE_NORMAL || numChannels == 2)
+			{
+				return GL_COMPRESSED_RG_RGTC2;
+			}
+			if (numChannels == 4)
+			{
+				const size_t numTexels = static_cast<size_t>(width) * height;
+				for (size_t i = 0; i < numTexels; ++i)
+				{
+					if (data[i * 4 + 3] != 255)
+					{
+						return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+					}
+				}
+			}
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		}
+
+		uint16_t packRGB565(const float* color)
+		{
+			const int r = static_cast<int>(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+			const int g = static_cast<int>(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+			const int b = static_cast<int>(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+			return static_cast<uint16_t>(r << 11 | g << 5 | b);
+		}
+
+		void unpackRGB565(uint16_t packed, int* color)
+		{
+			const int r = packed >> 11 & 31, g = packed >> 5 & 63, b = packed & 31;
+			color[0] = r << 3 | r >> 2;
+			color[1] = g << 2 | g >> 4;
+			color[2] = b << 3 | b >> 2;
+		}
+
+		// BC1 color block. The endpoints bound the texels along the principal axis of their distribution.
+		void encodeColorBlock(const unsigned char texels[16][4], unsigned char* block)
+		{
+			float mean[3] = {};
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					mean[c] += texels[i][c] / 16.0f;
+				}
+			}
+			float covariance[6] = {};
+			for (int i = 0; i < 16; ++i)
+			{
+				const float d[3] = { texels[i][0] - mean[0], texels[i][1] - mean[1], texels[i][2] - mean[2] };
+				covariance[0] += d[0] * d[0];
+				covariance[1] += d[0] * d[1];
+				covariance[2] += d[0] * d[2];
+				covariance[3] += d[1] * d[1];
+				covariance[4] += d[1] * d[2];
+				covariance[5] += d[2] * d[2];
+			}
+			float axis[3] = { 1.0f, 1.0f, 1.0f };
+			for (int iteration = 0; iteration < 8; ++iteration)
+			{
+				const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+				const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+				const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+				const float length = std::max(std::max(std::abs(x), std::abs(y)), std::abs(z));
+				if (length == 0.0f)
+				{
+					break;
+				}
+				axis[0] = x / length;
+				axis[1] = y / length;
+				axis[2] = z / length;
+			}
+			const float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+			float minT = 0.0f, maxT = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				const float t = ((texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2]) / lengthSquared;
+				minT = std::min(minT, t);
+				maxT = std::max(maxT, t);
+			}
+			const float maxColor[3] = { mean[0] + axis[0] * maxT, mean[1] + axis[1] * maxT, mean[2] + axis[2] * maxT };
+			const float minColor[3] = { mean[0] + axis[0] * minT, mean[1] + axis[1] * minT, mean[2] + axis[2] * minT };
+			uint16_t color0 = packRGB565(maxColor), color1 = packRGB565(minColor);
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+			}
+
+			// Four color mode needs color0 > color1, equal endpoints just use index 0 everywhere
+			uint32_t indices = 0;
+			if (color0 != color1)
+			{
+				int palette[4][3];
+				unpackRGB565(color0, palette[0]);
+				unpackRGB565(color1, palette[1]);
+				for (int c = 0; c < 3; ++c)
+				{
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+				for (int i = 0; i < 16; ++i)
+				{
+					int best = 0, bestDistance = INT32_MAX;
+					for (int j = 0; j < 4; ++j)
+					{
+						int distance = 0;
+						for (int c = 0; c < 3; ++c)
+						{
+							distance += (texels[i][c] - palette[j][c]) * (texels[i][c] - palette[j][c]);
+						}
+						if (distance < bestDistance)
+						{
+							best = j;
+							bestDistance = distance;
+						}
+					}
+					indices |= static_cast<uint32_t>(best) << (2 * i);
+				}
+			}
+			block[0] = color0 & 0xFF;
+			block[1] = color0 >> 8;
+			block[2] = color1 & 0xFF;
+			block[3] = color1 >> 8;
+			std::memcpy(block + 4, &indices, sizeof(indices));
+		}
+
+		// BC4 block of one channel, also the alpha half of BC3 and both halves of BC5. Eight value mode throughout.
+		void encodeChannelBlock(const unsigned char texels[16][4], int channel, unsigned char* block)
+		{
+			int minValue = 255, maxValue = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				minValue = std::min(minValue, static_cast<int>(texels[i][channel]));
+				maxValue = std::max(maxValue, static_cast<int>(texels[i][channel]));
+			}
+			uint64_t indices = 0;
+			if (maxValue != minValue)
+			{
+				// Palette index 0 is the maximum, 1 the minimum and 2 to 7 interpolate between them
+				static const int ORDER[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+				for (int i = 0; i < 16; ++i)
+				{
+					const int step = ((texels[i][channel] - minValue) * 14 + (maxValue - minValue)) / (2 * (maxValue - minValue));
+					indices |= static_cast<uint64_t>(ORDER[step]) << (3 * i);
+				}
+			}
+			block[0] = static_cast<unsigned char>(maxValue);
+			block[1] = static_cast<unsigned char>(minValue);
+			for (int i = 0; i < 6; ++i)
+			{
+				block[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+			}
+		}
+
+		std::vector<unsigned char> compressLevel(unsigned int format, const unsigned char* data, int width, int height, int numChannels)
+		{
+			const int numBlocksX = (width + 3) / 4, numBlocksY = (height + 3) / 4;
+			const unsigned int blockSize = getBlockSize(format);
+			std::vector<unsigned char> compressed(static_cast<size_t>(numBlocksX) * numBlocksY * blockSize);
+			unsigned char* block = compressed.data();
+			for (int blockY = 0; blockY < numBlocksY; ++blockY)
+			{
+				for (int blockX = 0; blockX < numBlocksX; ++blockX)
+				{
+					// Gathered as RGBA, texels past the edge repeat the last row and column
+					unsigned char texels[16][4];
+					for (int i = 0; i < 16; ++i)
+					{
+						const int x = std::min(blockX * 4 + i % 4, width - 1), y = std::min(blockY * 4 + i / 4, height - 1);
+						const unsigned char* texel = data + (static_cast<size_t>(y) * width + x) * numChannels;
+						for (int c = 0; c < 4; ++c)
+						{
+							texels[i][c] = c < numChannels ? texel[c] : (c == 3 ? 255 : texel[0]);
+						}
+					}
+
+					switch (format)
+					{
+					case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+						encodeColorBlock(texels, block);
+						break;
+					case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+						encodeChannelBlock(texels, 3, block);
+						encodeColorBlock(texels, block + 8);
+						break;
+					case GL_COMPRESSED_RED_RGTC1:
+						encodeChannelBlock(texels, 0, block);
+						break;
+					case GL_COMPRESSED_RG_RGTC2:
+						encodeChannelBlock(texels, 0, block);
+						encodeChannelBlock(texels, 1, block + 8);
+						break;
+					}
+					block += blockSize;
+				}
+			}
+			return compressed;
+		}
+	}
+
+	std::string CookedTexture::getCachePath(const std::string& sourceFilename)
+	{
+		return sourceFilename + ".pxtc";
+	}
+
+	CookedTexture::CookedTexture(const std::string& sourceFilename, TextureUsage usage) : _file(getCachePath(sourceFilename))
+	{
+		if (!_file.isOpen() || _file.size() < sizeof(Header))
+		{
+			return;
+		}
+
+		const unsigned char* data = _file.data();
+		const Header* header = reinterpret_cast<const Header*>(data);
+		// Archived copies were checked against their source when packed, and the source need not ship with them
+		uint64_t sourceSize = header->_sourceSize;
+		int64_t sourceTimestamp = header->_sourceTimestamp;
+		if (!_file.isArchived() && !MappedFile::getFileInfo(sourceFilename, sourceSize, sourceTimestamp))
+		{
+			return;
+		}
+		if (std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) || header->_version != VERSION || header->_usage != static_cast<uint32_t>(usage)
+			|| header->_sourceSize != sourceSize || header->_sourceTimestamp != sourceTimestamp
+			|| _file.size() < sizeof(Header) + header->_numLevels * sizeof(LevelRecord))
+		{
+			return;
+		}
+
+		const LevelRecord* records = reinterpret_cast<const LevelRecord*>(data + sizeof(Header));
+		for (size_t i = 0; i < header->_numLevels; ++i)
+		{
+			if (records[i]._offset + records[i]._size > _file.size())
+			{
+				std::cerr << "Corrupt cooked texture for " << sourceFilename << "!\n";
+				_levels.clear();
+				return;
+			}
+			_levels.emplace_back(Level{ data + records[i]._offset, static_cast<size_t>(records[i]._size), static_cast<int>(records[i]._width),
+				static_cast<int>(records[i]._height) });
+		}
+		_format = header->_format;
+		_valid = !_levels.empty();
+	}
+
+	size_t CookedTexture::getSize() const
+	{
+		size_t size = 0;
+		for (const auto& level : _levels)
+		{
+			size += level._size;
+		}
+		return size;
+	}
+
+	unsigned int CookedTexture::upload() const
+	{
+		unsigned int textureID;
+		glGenTextures(1, &textureID);
+		GLState::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+		for (size_t i = 0; i < _levels.size(); ++i)
+		{
+			StagingRing::getInstance().uploadCompressedTexture(GL_TEXTURE_2D, i, _format, _levels[i]._width, _levels[i]._height, _levels[i]._data, _levels[i]._size);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, _levels.size() - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		return textureID;
+	}
+
+	bool CookedTexture::cook(const std::string& sourceFilename, TextureUsage usage, const unsigned char* data, int width, int height, int numChannels)
+	{
+		if (usage == USAGE_DATA)
+		{
+			return false;
+		}
+		// Zeroed so that the padding bytes written out with it are too
+		Header header = {};
+		std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+		header._version = VERSION;
+		if (!MappedFile::getFileInfo(sourceFilename, header._sourceSize, header._sourceTimestamp))
+		{
+			return false;
+		}
+		header._usage = static_cast<uint32_t>(usage);
+		header._format = chooseFormat(usage, data, width, height, numChannels);
+
+		const std::vector<std::vector<unsigned char>> mipmaps = buildMipChain(data, width, height, numChannels, usage);
+		std::vector<std::vector<unsigned char>> levels;
+		std::vector<LevelRecord> records;
+		const unsigned char* source = data;
+		for (size_t i = 0; i <= mipmaps.size(); ++i)
+		{
+			levels.emplace_back(compressLevel(header._format, source, width, height, numChannels));
+			records.emplace_back(LevelRecord{ 0, levels.back().size(), static_cast<uint32_t>(width), static_cast<uint32_t>(height) });
+			if (i < mipmaps.size())
+			{
+				source = mipmaps[i].data();
+				width = std::max(width / 2, 1);
+				height = std::max(height / 2, 1);
+			}
+		}
+		header._numLevels = static_cast<uint32_t>(levels.size());
+
+		uint64_t offset = sizeof(Header) + records.size() * sizeof(LevelRecord);
+		for (auto& record : records)
+		{
+			offset = align(offset);
+			record._offset = offset;
+			offset += record._size;
+		}
+
+		const std::string cachePath = getCachePath(sourceFilename);
+		std::ofstream stream(cachePath, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			std::cerr << "Could not write cooked texture " << cachePath << "!\n";
+			return false;
+		}
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		stream.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(LevelRecord));
+		const char padding[BLOB_ALIGNMENT] = {};
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			stream.write(padding, records[i]._offset - static_cast<uint64_t>(stream.tellp()));
+			stream.write(reinterpret_cast<const char*>(levels[i].data()), levels[i].size());
+		}
+		return static_cast<bool>(stream);
+	}
+}
\ No newline at end of file
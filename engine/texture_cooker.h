@@ -0,0 +1,52 @@
+#pragma once
+#include <engine/mapped_file.h>
+
+#include <string>
+#include <vector>
+
+namespace phoenix
+{
+	// What the texels mean, which decides the block compression format they are cooked to
+	enum TextureUsage
+	{
+		USAGE_COLOR, // BC1, or BC3 with alpha. One and two channel images go to BC4 and BC5.
+		USAGE_NORMAL, // BC5, tangent space X and Y only so Z has to be rebuilt in the shader
+		USAGE_MASK, // BC4 from the first channel, for metallic, roughness, AO and the like
+		USAGE_DATA // Never cooked and uploaded as is, for lookup tables that block compression would distort
+	};
+
+	// Block-compressed copy of an image with every mip level precomputed. The file is a header followed by a level
+	// table and the compressed levels, which are uploaded straight from the mapped pages.
+	class CookedTexture
+	{
+	public:
+		struct Level
+		{
+			const unsigned char* _data;
+			size_t _size;
+			int _width, _height;
+		};
+
+		unsigned int _format = 0; // GL compressed internal format
+		std::vector<Level> _levels;
+
+		// Maps the cooked file for the given source, if one exists for this usage and is still up to date
+		CookedTexture(const std::string&, TextureUsage);
+
+		inline bool isValid() const
+		{
+			return _valid;
+		}
+		size_t getSize() const;
+		// Creates the GL texture from every level, on the GL thread
+		unsigned int upload() const;
+
+		static std::string getCachePath(const std::string&);
+		// Compresses the decoded source image and its mip chain and writes the cooked file. Fails for USAGE_DATA.
+		static bool cook(const std::string&, TextureUsage, const unsigned char*, int, int, int);
+
+	private:
+		MappedFile _file;
+		bool _valid = false;
+	};
+}
\ No newline at end of file
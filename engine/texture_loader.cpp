@@ -0,0 +1,267 @@
+#include <engine/texture_loader.h>
+#include <engine/gl_state.h>
+#include <engine/texture_registry.h>
+#include <engine/staging_ring.h>
+#include <engine/mip_builder.h>
+#include <engine/texture_streamer.h>
+#include <engine/stb_image.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace phoenix
+{
+	namespace
+	{
+		double getElapsedMilliseconds(const std::chrono::high_resolution_clock::time_point& start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+	}
+
+	TextureLoader::TextureLoader(bool generateMipmaps, unsigned int numThreads) : _generateMipmaps(generateMipmaps)
+	{
+		numThreads = std::max(numThreads, 1u);
+		for (size_t i = 0; i < numThreads; ++i)
+		{
+			_workers.emplace_back(&TextureLoader::work, this);
+		}
+	}
+
+	size_t TextureLoader::enqueue(const std::string& filename, unsigned int* target, TextureUsage usage)
+	{
+		const uint64_t key = TextureRegistry::getKey(filename, _generateMipmaps, usage);
+		auto batchIt = _batchKeys.find(key);
+		const unsigned int textureID = batchIt == _batchKeys.end() ? TextureRegistry::getInstance().acquire(key) : 0;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_images.emplace_back();
+		Image& image = _images.back();
+		image._filename = filename;
+		image._key = key;
+		image._usage = usage;
+		image._target = target;
+		if (batchIt != _batchKeys.end())
+		{
+			image._original = batchIt->second;
+			image._ready = true;
+		}
+		else if (textureID)
+		{
+			image._textureID = textureID;
+			image._ready = true;
+		}
+		else
+		{
+			_batchKeys.emplace(key, _images.size() - 1);
+			_jobs.push_back(_images.size() - 1);
+			_jobQueued.notify_one();
+		}
+		return _images.size() - 1;
+	}
+
+	std::vector<unsigned int> TextureLoader::finish()
+	{
+		auto batchStart = std::chrono::high_resolution_clock::now();
+		double totalDecodeTime = 0.0, totalUploadTime = 0.0;
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		const size_t numImages = _images.size();
+		std::vector<unsigned int> textureIDs(numImages);
+		for (size_t i = 0; i < numImages; ++i)
+		{
+			// Upload in submission order, overlapping with the decoding of later images
+			_jobDone.wait(lock, [this, i] { return _images[i]._ready; });
+			Image& image = _images[i];
+			lock.unlock();
+
+			if (image._original != SIZE_MAX)
+			{
+				// The original has been uploaded by now, so this is a registry hit unless it failed to load
+				const unsigned int textureID = TextureRegistry::getInstance().acquire(image._key);
+				textureIDs[i] = textureID ? textureID : -1;
+			}
+			else if (image._textureID)
+			{
+				textureIDs[i] = image._textureID;
+			}
+			else
+			{
+				const bool cooked = image._cooked != nullptr;
+				auto uploadStart = std::chrono::high_resolution_clock::now();
+				textureIDs[i] = upload(image);
+				double uploadTime = getElapsedMilliseconds(uploadStart);
+				if (image._data || cooked)
+				{
+					std::cout << "Texture " << image._filename << (cooked ? ": mapped" : ": decoded") << " in " << image._decodeTime << " ms, uploaded in " << uploadTime << " ms\n";
+				}
+				totalDecodeTime += image._decodeTime;
+				totalUploadTime += uploadTime;
+
+				stbi_image_free(image._data);
+				image._data = nullptr;
+				image._mipmaps.clear();
+				image._cooked.reset();
+			}
+			if (image._target)
+			{
+				*image._target = textureIDs[i];
+			}
+
+			lock.lock();
+		}
+		_images.clear();
+		_batchKeys.clear();
+		lock.unlock();
+
+		if (numImages)
+		{
+			std::cout << "Loaded " << numImages << " textures in " << getElapsedMilliseconds(batchStart) << " ms (" << totalDecodeTime << " ms decoding across "
+				<< _workers.size() << " threads, " << totalUploadTime << " ms uploading)\n";
+			TextureRegistry::getInstance().printStats();
+		}
+		return textureIDs;
+	}
+
+	bool TextureLoader::isReady()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return std::all_of(_images.begin(), _images.end(), [](const Image& image) { return image._ready; });
+	}
+
+	TextureLoader::~TextureLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_jobQueued.notify_all();
+		for (auto& worker : _workers)
+		{
+			worker.join();
+		}
+		for (auto& image : _images)
+		{
+			stbi_image_free(image._data);
+		}
+	}
+
+	void TextureLoader::work()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true)
+		{
+			_jobQueued.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+			if (_stopping)
+			{
+				return;
+			}
+			Image& image = _images[_jobs.front()];
+			_jobs.pop_front();
+			lock.unlock();
+
+			auto decodeStart = std::chrono::high_resolution_clock::now();
+			image._cooked.reset(new CookedTexture(image._filename, image._usage));
+			if (!image._cooked->isValid())
+			{
+				// Cold start, cook the source and map the result. Only if that fails is the image uploaded as is.
+				image._cooked.reset();
+				image._data = stbi_load(image._filename.c_str(), &image._width, &image._height, &image._numChannels, 0);
+				if (image._data && CookedTexture::cook(image._filename, image._usage, image._data, image._width, image._height, image._numChannels))
+				{
+					image._cooked.reset(new CookedTexture(image._filename, image._usage));
+				}
+				if (image._cooked && image._cooked->isValid())
+				{
+					stbi_image_free(image._data);
+					image._data = nullptr;
+				}
+				else
+				{
+					image._cooked.reset();
+					if (image._data && _generateMipmaps)
+					{
+						image._mipmaps = buildMipChain(image._data, image._width, image._height, image._numChannels, image._usage);
+					}
+				}
+			}
+			image._decodeTime = getElapsedMilliseconds(decodeStart);
+
+			lock.lock();
+			image._ready = true;
+			_jobDone.notify_all();
+		}
+	}
+
+	unsigned int TextureLoader::upload(Image& image)
+	{
+		unsigned int textureID = -1;
+		TextureStreamer& streamer = TextureStreamer::getInstance();
+		if (image._cooked && streamer.isEnabled())
+		{
+			// Only the mip tail is uploaded for now. The streamer owns the mapping from here on and keeps the size up to date.
+			textureID = streamer.add(std::move(image._cooked));
+			TextureRegistry::getInstance().insert(image._key, textureID, streamer.getResidentBytes(textureID));
+			return textureID;
+		}
+		if (image._cooked)
+		{
+			textureID = image._cooked->upload();
+			TextureRegistry::getInstance().insert(image._key, textureID, image._cooked->getSize());
+			return textureID;
+		}
+		if (!image._data)
+		{
+			std::cout << "Failed to load file: " << image._filename << "\n";
+			return textureID;
+		}
+		size_t bytes = static_cast<size_t>(image._width) * image._height * image._numChannels;
+
+		GLenum format = GL_RGBA;
+		if (image._numChannels == 1)
+		{
+			format = GL_RED;
+		}
+		else if (image._numChannels == 2)
+		{
+			format = GL_RG;
+		}
+		else if (image._numChannels == 3)
+		{
+			format = GL_RGB;
+		}
+
+		glGenTextures(1, &textureID);
+		GLState::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		StagingRing& ring = StagingRing::getInstance();
+		ring.uploadTexture(GL_TEXTURE_2D, 0, format, image._width, image._height, format, GL_UNSIGNED_BYTE, image._data, bytes);
+		if (image._mipmaps.empty())
+		{
+			glGenerateMipmap(GL_TEXTURE_2D);
+			bytes = bytes * 4 / 3;
+		}
+		else
+		{
+			int width = image._width, height = image._height;
+			for (size_t i = 0; i < image._mipmaps.size(); ++i)
+			{
+				width = std::max(width / 2, 1);
+				height = std::max(height / 2, 1);
+				ring.uploadTexture(GL_TEXTURE_2D, i + 1, format, width, height, format, GL_UNSIGNED_BYTE, image._mipmaps[i].data(), image._mipmaps[i].size());
+				bytes += image._mipmaps[i].size();
+			}
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image._mipmaps.size());
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		TextureRegistry::getInstance().insert(image._key, textureID, bytes);
+		return textureID;
+	}
+}
\ No newline at end of file
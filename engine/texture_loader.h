@@ -0,0 +1,67 @@
+#pragma once
+#include <engine/texture_cooker.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace phoenix
+{
+	// Two stage texture loading pipeline. Image decompression (and optional mip generation) runs on a pool
+	// of worker threads, while the GL thread drains the decoded images in submission order and uploads them.
+	// Images are block-compressed and cooked next to their source on first load, later loads map the cooked
+	// file instead. Textures already resident in the TextureRegistry are never decoded again, and every
+	// returned ID holds a registry reference.
+	class TextureLoader
+	{
+	public:
+		TextureLoader(bool = false, unsigned int = std::thread::hardware_concurrency());
+
+		// Queues a file for decoding and returns its position in the batch. If given, the texture ID is also
+		// written to the pointer once the batch finishes.
+		size_t enqueue(const std::string&, unsigned int* = nullptr, TextureUsage = USAGE_COLOR);
+		// Uploads every queued texture on the calling (GL) thread and returns the texture IDs in submission order
+		std::vector<unsigned int> finish();
+		// Every queued image has been decoded, so that finish would only upload
+		bool isReady();
+
+		~TextureLoader();
+
+	private:
+		struct Image
+		{
+			std::string _filename;
+			uint64_t _key = 0;
+			TextureUsage _usage = USAGE_COLOR;
+			std::unique_ptr<CookedTexture> _cooked; // Uncompressed fallback when null
+			unsigned int* _target = nullptr;
+			unsigned int _textureID = 0; // Set up front on registry hits
+			size_t _original = SIZE_MAX; // Earlier image of this batch with the same key
+			int _width = 0, _height = 0, _numChannels = 0;
+			unsigned char* _data = nullptr;
+			std::vector<std::vector<unsigned char>> _mipmaps; // Levels 1 and up when generated on the CPU
+			double _decodeTime = 0.0;
+			bool _ready = false;
+		};
+
+		bool _generateMipmaps, _stopping = false;
+		std::deque<Image> _images; // Deque so that references held by workers survive further enqueues
+		std::deque<size_t> _jobs;
+		std::unordered_map<uint64_t, size_t> _batchKeys;
+		std::vector<std::thread> _workers;
+		std::mutex _mutex;
+		std::condition_variable _jobQueued, _jobDone;
+
+		void work();
+		static unsigned int upload(Image&);
+
+		TextureLoader(TextureLoader const&) = delete;
+		void operator=(TextureLoader const&) = delete;
+	};
+}
\ No newline at end of file
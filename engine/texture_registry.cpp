@@ -0,0 +1,109 @@
+#include <engine/texture_registry.h>
+#include <engine/gl_state.h>
+#include <engine/texture_streamer.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+
+namespace phoenix
+{
+	namespace
+	{
+		std::string getCanonicalPath(const std::string& filename)
+		{
+#ifdef _WIN32
+			char buffer[_MAX_PATH];
+			std::string path = _fullpath(buffer, filename.c_str(), _MAX_PATH) ? buffer : filename;
+			// Paths are case insensitive on Windows
+			std::replace(path.begin(), path.end(), '\\', '/');
+			std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+			return path;
+#else
+			char buffer[PATH_MAX];
+			return realpath(filename.c_str(), buffer) ? buffer : filename;
+#endif
+		}
+	}
+
+	TextureRegistry& TextureRegistry::getInstance()
+	{
+		static TextureRegistry instance;
+		return instance;
+	}
+
+	uint64_t TextureRegistry::getKey(const std::string& filename, bool generateMipmapsOnCPU, unsigned int usage)
+	{
+		// 64-bit FNV-1a over the canonical path followed by the load parameters
+		uint64_t hash = 14695981039346656037ull;
+		for (unsigned char c : getCanonicalPath(filename))
+		{
+			hash = (hash ^ c) * 1099511628211ull;
+		}
+		hash = (hash ^ static_cast<unsigned char>(generateMipmapsOnCPU)) * 1099511628211ull;
+		hash = (hash ^ static_cast<unsigned char>(usage)) * 1099511628211ull;
+		return hash;
+	}
+
+	unsigned int TextureRegistry::acquire(uint64_t key)
+	{
+		auto it = _entries.find(key);
+		if (it == _entries.end())
+		{
+			++_stats._misses;
+			return 0;
+		}
+		++_stats._hits;
+		++it->second._refCount;
+		return it->second._textureID;
+	}
+
+	void TextureRegistry::insert(uint64_t key, unsigned int textureID, size_t bytes)
+	{
+		_entries[key] = Entry{ textureID, 1, bytes };
+		_keys[textureID] = key;
+		_stats._bytesResident += bytes;
+	}
+
+	void TextureRegistry::resize(unsigned int textureID, size_t bytes)
+	{
+		auto keyIt = _keys.find(textureID);
+		if (keyIt == _keys.end())
+		{
+			return;
+		}
+
+		Entry& entry = _entries.at(keyIt->second);
+		_stats._bytesResident = _stats._bytesResident - entry._bytes + bytes;
+		entry._bytes = bytes;
+	}
+
+	void TextureRegistry::release(unsigned int textureID)
+	{
+		auto keyIt = _keys.find(textureID);
+		if (keyIt == _keys.end())
+		{
+			// Not a texture we loaded, e.g. a render target
+			return;
+		}
+
+		auto it = _entries.find(keyIt->second);
+		if (--it->second._refCount == 0)
+		{
+			TextureStreamer::getInstance().remove(textureID);
+			GLState::getInstance().deleteTextures(1, &textureID);
+			_stats._bytesResident -= it->second._bytes;
+			++_stats._evictions;
+			_entries.erase(it);
+			_keys.erase(keyIt);
+		}
+	}
+
+	void TextureRegistry::printStats() const
+	{
+		std::cout << "Texture registry: " << _entries.size() << " textures, " << _stats._hits << " hits, " << _stats._misses << " misses, "
+			<< _stats._evictions << " evictions, " << _stats._bytesResident / (1024.0 * 1024.0) << " MB resident\n";
+	}
+}
\ No newline at end of file
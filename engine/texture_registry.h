@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace phoenix
+{
+	// Engine-wide store of every texture loaded from disk, keyed by a hash of the canonical path and the load
+	// parameters. Handles are reference counted and the GL texture is deleted once its last user releases it.
+	// Only to be used from the GL thread.
+	class TextureRegistry
+	{
+	public:
+		struct Stats
+		{
+			size_t _hits = 0, _misses = 0, _evictions = 0, _bytesResident = 0;
+		};
+
+		static TextureRegistry& getInstance();
+		static uint64_t getKey(const std::string&, bool = false, unsigned int = 0);
+
+		// Returns the texture ID and takes a reference if the texture is resident, 0 otherwise
+		unsigned int acquire(uint64_t);
+		// Registers a freshly uploaded texture, the caller holds the first reference
+		void insert(uint64_t, unsigned int, size_t);
+		// Updates the size of a texture whose levels get streamed in and out, ignores textures not loaded through here
+		void resize(unsigned int, size_t);
+		void release(unsigned int);
+
+		inline const Stats& getStats() const
+		{
+			return _stats;
+		}
+		inline size_t getNumTextures() const
+		{
+			return _entries.size();
+		}
+		void printStats() const;
+
+	private:
+		struct Entry
+		{
+			unsigned int _textureID, _refCount;
+			size_t _bytes;
+		};
+
+		std::unordered_map<uint64_t, Entry> _entries;
+		std::unordered_map<unsigned int, uint64_t> _keys; // Reverse lookup for releases
+		Stats _stats;
+
+		TextureRegistry() {}
+		TextureRegistry(TextureRegistry const&) = delete;
+		void operator=(TextureRegistry const&) = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,388 @@
+#include <engine/texture_streamer.h>
+#include <engine/gl_state.h>
+#include <engine/staging_ring.h>
+#include <engine/strings.h>
+#include <engine/texture_registry.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace phoenix
+{
+	TextureStreamer& TextureStreamer::getInstance()
+	{
+		static TextureStreamer instance;
+		return instance;
+	}
+
+	void TextureStreamer::setBudget(size_t budget)
+	{
+		_budget = budget;
+	}
+
+	size_t TextureStreamer::getResidentSize(const StreamedTexture& texture, int mip)
+	{
+		size_t size = 0;
+		for (size_t i = mip; i < texture._cooked->_levels.size(); ++i)
+		{
+			size += texture._cooked->_levels[i]._size;
+		}
+		return size;
+	}
+
+	void TextureStreamer::uploadLevels(unsigned int textureID, const StreamedTexture& texture, int mip)
+	{
+		// Respecifying from level 0 lets the driver release the dropped levels, which a base level would not
+		const auto& levels = texture._cooked->_levels;
+		StagingRing& ring = StagingRing::getInstance();
+		GLState::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+		for (size_t i = mip; i < levels.size(); ++i)
+		{
+			ring.uploadCompressedTexture(GL_TEXTURE_2D, i - mip, texture._cooked->_format, levels[i]._width, levels[i]._height, levels[i]._data, levels[i]._size);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1 - mip);
+		GLState::getInstance().bindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	unsigned int TextureStreamer::add(std::unique_ptr<CookedTexture> cooked)
+	{
+		StreamedTexture texture;
+		const auto& levels = cooked->_levels;
+		texture._tailMip = 0;
+		while (texture._tailMip + 1 < static_cast<int>(levels.size())
+			&& static_cast<unsigned int>(std::max(levels[texture._tailMip]._width, levels[texture._tailMip]._height)) > TEXTURE_STREAMING_TAIL)
+		{
+			++texture._tailMip;
+		}
+		texture._residentMip = texture._targetMip = texture._tailMip;
+		texture._requestedMip = static_cast<float>(texture._tailMip);
+		texture._cooked = std::move(cooked);
+
+		unsigned int textureID;
+		glGenTextures(1, &textureID);
+		GLState::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		uploadLevels(textureID, texture, texture._residentMip);
+
+		++_stats._numTextures;
+		_stats._residentBytes += getResidentSize(texture, texture._residentMip);
+		_stats._fullBytes += texture._cooked->getSize();
+		_textures.emplace(textureID, std::move(texture));
+		return textureID;
+	}
+
+	void TextureStreamer::remove(unsigned int textureID)
+	{
+		auto it = _textures.find(textureID);
+		if (it == _textures.end())
+		{
+			return;
+		}
+		--_stats._numTextures;
+		_stats._residentBytes -= getResidentSize(it->second, it->second._residentMip);
+		_stats._fullBytes -= it->second._cooked->getSize();
+		_textures.erase(it);
+	}
+
+	size_t TextureStreamer::getResidentBytes(unsigned int textureID) const
+	{
+		auto it = _textures.find(textureID);
+		return it == _textures.end() ? 0 : getResidentSize(it->second, it->second._residentMip);
+	}
+
+	void TextureStreamer::resizeFeedback(unsigned int width, unsigned int height)
+	{
+		GLState& state = GLState::getInstance();
+		// Readbacks of the old size are of no use anymore
+		for (auto& readback : _readbacks)
+		{
+			glDeleteSync(static_cast<GLsync>(readback._sync));
+			_freeBuffers.push_back(readback._buffer);
+		}
+		_readbacks.clear();
+		if (!_freeBuffers.empty())
+		{
+			glDeleteBuffers(_freeBuffers.size(), _freeBuffers.data());
+			_freeBuffers.clear();
+		}
+		if (_FBO)
+		{
+			state.deleteFramebuffers(1, &_FBO);
+			state.deleteTextures(1, &_feedbackTexture);
+			glDeleteRenderbuffers(1, &_depthBuffer);
+		}
+		_feedbackWidth = width;
+		_feedbackHeight = height;
+
+		glGenFramebuffers(1, &_FBO);
+		state.bindFramebuffer(GL_FRAMEBUFFER, _FBO);
+		glGenTextures(1, &_feedbackTexture);
+		state.bindTexture(GL_TEXTURE_2D, _feedbackTexture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG32UI, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		state.bindTexture(GL_TEXTURE_2D, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _feedbackTexture, 0);
+		glGenRenderbuffers(1, &_depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, _depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cerr << FRAMEBUFFER_INIT_ERROR;
+		}
+	}
+
+	const Shader& TextureStreamer::beginFeedback(unsigned int screenWidth, unsigned int screenHeight)
+	{
+		if (!_feedbackShader)
+		{
+			_feedbackShader.reset(new Shader("../Resources/Shaders/texture_streaming/feedback.vs", "../Resources/Shaders/texture_streaming/feedback.fs"));
+		}
+		const unsigned int width = std::max(screenWidth / TEXTURE_FEEDBACK_SCALE, 1u), height = std::max(screenHeight / TEXTURE_FEEDBACK_SCALE, 1u);
+		if (width != _feedbackWidth || height != _feedbackHeight)
+		{
+			resizeFeedback(width, height);
+		}
+		_screenWidth = screenWidth;
+		_screenHeight = screenHeight;
+
+		GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, _FBO);
+		GLState::getInstance().viewport(0, 0, width, height);
+		const unsigned int nothing[4] = {};
+		glClearBufferuiv(GL_COLOR, 0, nothing);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		_feedbackShader->use();
+		return *_feedbackShader;
+	}
+
+	void TextureStreamer::renderFeedback(Mesh& mesh)
+	{
+		auto it = _meshIDs.find(&mesh);
+		if (it == _meshIDs.end())
+		{
+			_meshTextures.emplace_back();
+			it = _meshIDs.emplace(&mesh, _meshTextures.size()).first;
+		}
+		// Refreshed on every draw in case a mesh got allocated where a deleted one used to be
+		auto& textureIDs = _meshTextures[it->second - 1];
+		textureIDs.clear();
+		for (const auto& texture : mesh.getTextures())
+		{
+			textureIDs.push_back(texture._ID);
+		}
+		_feedbackShader->setInt(G_FEEDBACK_ID, it->second);
+		mesh.render();
+	}
+
+	void TextureStreamer::renderFeedback(Model& model)
+	{
+		for (auto mesh : model._meshes)
+		{
+			renderFeedback(*mesh);
+		}
+	}
+
+	void TextureStreamer::endFeedback()
+	{
+		// Skips the readback while the GPU is behind, rather than adding latency
+		if (_readbacks.size() < TEXTURE_FEEDBACK_LATENCY)
+		{
+			unsigned int buffer;
+			if (_freeBuffers.empty())
+			{
+				glGenBuffers(1, &buffer);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+				glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<size_t>(_feedbackWidth) * _feedbackHeight * 2 * sizeof(unsigned int), nullptr, GL_STREAM_READ);
+			}
+			else
+			{
+				buffer = _freeBuffers.back();
+				_freeBuffers.pop_back();
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+			}
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			glReadPixels(0, 0, _feedbackWidth, _feedbackHeight, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			_readbacks.push_back(Readback{ buffer, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+		}
+		GLState::getInstance().bindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLState::getInstance().viewport(0, 0, _screenWidth, _screenHeight);
+	}
+
+	void TextureStreamer::analyze(const unsigned int* feedback)
+	{
+		// Smallest footprint per mesh, in log2 of UV units per feedback pixel
+		std::vector<float> footprints(_meshTextures.size(), std::numeric_limits<float>::infinity());
+		const size_t numPixels = static_cast<size_t>(_feedbackWidth) * _feedbackHeight;
+		for (size_t i = 0; i < numPixels; ++i)
+		{
+			const unsigned int meshID = feedback[i * 2];
+			if (meshID == 0 || meshID > footprints.size())
+			{
+				continue;
+			}
+			float footprint;
+			std::memcpy(&footprint, &feedback[i * 2 + 1], sizeof(float));
+			footprints[meshID - 1] = std::min(footprints[meshID - 1], footprint);
+		}
+
+		for (auto& entry : _textures)
+		{
+			entry.second._visible = false;
+		}
+		// Feedback pixels cover TEXTURE_FEEDBACK_SCALE screen pixels on a side, which the footprint is scaled back by
+		const float feedbackBias = std::log2(static_cast<float>(TEXTURE_FEEDBACK_SCALE));
+		for (size_t i = 0; i < footprints.size(); ++i)
+		{
+			if (footprints[i] == std::numeric_limits<float>::infinity())
+			{
+				continue;
+			}
+			for (unsigned int textureID : _meshTextures[i])
+			{
+				auto it = _textures.find(textureID);
+				if (it == _textures.end())
+				{
+					continue;
+				}
+				StreamedTexture& texture = it->second;
+				const CookedTexture::Level& level = texture._cooked->_levels[0];
+				const float mip = footprints[i] - feedbackBias + std::log2(static_cast<float>(std::max(level._width, level._height)));
+				texture._requestedMip = texture._visible ? std::min(texture._requestedMip, mip) : mip;
+				texture._visible = true;
+			}
+		}
+	}
+
+	void TextureStreamer::fitBudget()
+	{
+		// Visible textures get what they asked for, the rest keep what they have until the room is needed
+		std::vector<StreamedTexture*> textures;
+		size_t total = 0;
+		for (auto& entry : _textures)
+		{
+			StreamedTexture& texture = entry.second;
+			if (texture._visible)
+			{
+				const float mip = std::min(std::max(texture._requestedMip, 0.0f), static_cast<float>(texture._tailMip));
+				texture._targetMip = static_cast<int>(std::floor(mip));
+			}
+			else
+			{
+				texture._targetMip = texture._residentMip;
+			}
+			total += getResidentSize(texture, texture._targetMip);
+			textures.push_back(&texture);
+		}
+		_stats._requestedBytes = total;
+
+		// Coarsens the largest finest level first, out of view textures before visible ones
+		while (_budget && total > _budget)
+		{
+			StreamedTexture* coarsest = nullptr;
+			size_t coarsestSize = 0;
+			for (auto texturePointer : textures)
+			{
+				StreamedTexture& texture = *texturePointer;
+				if (texture._targetMip >= texture._tailMip)
+				{
+					continue;
+				}
+				const size_t size = texture._cooked->_levels[texture._targetMip]._size;
+				if (!coarsest || (coarsest->_visible && !texture._visible) || (coarsest->_visible == texture._visible && size > coarsestSize))
+				{
+					coarsest = &texture;
+					coarsestSize = size;
+				}
+			}
+			if (!coarsest)
+			{
+				// Mip tails alone exceed the budget
+				break;
+			}
+			total -= coarsestSize;
+			++coarsest->_targetMip;
+		}
+	}
+
+	void TextureStreamer::update()
+	{
+		if (!_readbacks.empty())
+		{
+			const Readback& readback = _readbacks.front();
+			GLsync sync = static_cast<GLsync>(readback._sync);
+			const GLenum status = glClientWaitSync(sync, 0, 0);
+			if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			{
+				glDeleteSync(sync);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, readback._buffer);
+				const size_t size = static_cast<size_t>(_feedbackWidth) * _feedbackHeight * 2 * sizeof(unsigned int);
+				const void* feedback = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+				if (feedback)
+				{
+					analyze(static_cast<const unsigned int*>(feedback));
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				_freeBuffers.push_back(readback._buffer);
+				_readbacks.erase(_readbacks.begin());
+			}
+		}
+		fitBudget();
+
+		// Drops first so that the memory is free before finer levels come in
+		std::vector<std::pair<int, unsigned int>> streamIns;
+		for (auto& entry : _textures)
+		{
+			StreamedTexture& texture = entry.second;
+			if (texture._targetMip > texture._residentMip)
+			{
+				_stats._residentBytes -= getResidentSize(texture, texture._residentMip) - getResidentSize(texture, texture._targetMip);
+				uploadLevels(entry.first, texture, texture._targetMip);
+				texture._residentMip = texture._targetMip;
+				TextureRegistry::getInstance().resize(entry.first, getResidentSize(texture, texture._residentMip));
+				++_stats._numDropped;
+			}
+			else if (texture._targetMip < texture._residentMip)
+			{
+				streamIns.emplace_back(texture._residentMip - texture._targetMip, entry.first);
+			}
+		}
+
+		// Textures the furthest from what they need go first, at least one per frame
+		std::sort(streamIns.begin(), streamIns.end(), [](const std::pair<int, unsigned int>& a, const std::pair<int, unsigned int>& b) { return a.first > b.first; });
+		size_t uploadBudget = TEXTURE_STREAMING_UPLOAD_BUDGET;
+		bool uploaded = false;
+		for (const auto& streamIn : streamIns)
+		{
+			StreamedTexture& texture = _textures.at(streamIn.second);
+			const size_t size = getResidentSize(texture, texture._targetMip);
+			if (uploaded && size > uploadBudget)
+			{
+				break;
+			}
+			_stats._residentBytes += size - getResidentSize(texture, texture._residentMip);
+			uploadLevels(streamIn.second, texture, texture._targetMip);
+			texture._residentMip = texture._targetMip;
+			TextureRegistry::getInstance().resize(streamIn.second, size);
+			++_stats._numStreamedIn;
+			uploadBudget -= std::min(size, uploadBudget);
+			uploaded = true;
+		}
+	}
+
+	void TextureStreamer::printStats() const
+	{
+		std::cout << "Texture streamer: " << _stats._numTextures << " textures, " << _stats._residentBytes / (1024.0 * 1024.0) << "/" << _budget / (1024.0 * 1024.0)
+			<< " MB resident, " << _stats._requestedBytes / (1024.0 * 1024.0) << " MB requested, " << _stats._fullBytes / (1024.0 * 1024.0) << " MB at full resolution, "
+			<< _stats._numStreamedIn << " streamed in, " << _stats._numDropped << " dropped\n";
+	}
+}
\ No newline at end of file
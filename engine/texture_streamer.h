@@ -0,0 +1,97 @@
+#pragma once
+#include <engine/texture_cooker.h>
+#include <engine/model.h>
+#include <engine/shader.h>
+#include <engine/common.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace phoenix
+{
+	// Keeps only the mip levels of cooked textures that were recently sampled resident, within a memory budget. A low
+	// resolution feedback pass writes which mesh covers each pixel and how large its texture footprint is. The result
+	// is read back a few frames later, turned into the finest level each texture needs, and textures get their finer
+	// levels streamed in from the mapped cooked files or dropped again. Level 0 of the GL texture is always the finest
+	// resident level, so texture IDs stay valid throughout. Only textures loaded while a budget is set are streamed.
+	// Only to be used from the GL thread.
+	class TextureStreamer
+	{
+	public:
+		struct Stats
+		{
+			size_t _numTextures = 0, _residentBytes = 0, _requestedBytes = 0, _fullBytes = 0, _numStreamedIn = 0, _numDropped = 0;
+		};
+
+		static TextureStreamer& getInstance();
+
+		// Bytes all streamed textures may take up together. 0 lifts the cap and stops streaming textures loaded from then on.
+		void setBudget(size_t);
+		inline size_t getBudget() const
+		{
+			return _budget;
+		}
+		inline bool isEnabled() const
+		{
+			return _budget > 0;
+		}
+
+		// Takes over a cooked texture and uploads its mip tail, returns the texture ID
+		unsigned int add(std::unique_ptr<CookedTexture>);
+		// Forgets about the texture, the caller deletes it
+		void remove(unsigned int);
+		// Bytes of the texture's currently resident levels, 0 for textures that aren't streamed
+		size_t getResidentBytes(unsigned int) const;
+
+		// Binds the feedback target, a fraction of the given screen size, and returns the feedback shader. Set its gWVP like
+		// in the main pass, draw through renderFeedback and finish with endFeedback, which restores the default framebuffer.
+		const Shader& beginFeedback(unsigned int, unsigned int);
+		void renderFeedback(Mesh&);
+		void renderFeedback(Model&);
+		void endFeedback();
+		// Analyzes the oldest finished feedback readback and streams levels in or out, meant to be called once per frame
+		void update();
+
+		inline const Stats& getStats() const
+		{
+			return _stats;
+		}
+		void printStats() const;
+
+	private:
+		struct StreamedTexture
+		{
+			std::unique_ptr<CookedTexture> _cooked;
+			int _residentMip, _targetMip, _tailMip;
+			float _requestedMip; // Finest level the last feedback asked for, fractional
+			bool _visible = false; // Seen in the last feedback
+		};
+
+		struct Readback
+		{
+			unsigned int _buffer;
+			void* _sync;
+		};
+
+		size_t _budget = 0;
+		std::unordered_map<unsigned int, StreamedTexture> _textures;
+		std::unordered_map<const Mesh*, unsigned int> _meshIDs;
+		std::vector<std::vector<unsigned int>> _meshTextures; // Indexed by feedback ID - 1
+		std::unique_ptr<Shader> _feedbackShader;
+		unsigned int _FBO = 0, _feedbackTexture = 0, _depthBuffer = 0, _feedbackWidth = 0, _feedbackHeight = 0, _screenWidth = 0, _screenHeight = 0;
+		std::vector<Readback> _readbacks; // Oldest first
+		std::vector<unsigned int> _freeBuffers;
+		Stats _stats;
+
+		void resizeFeedback(unsigned int, unsigned int);
+		void analyze(const unsigned int*);
+		void fitBudget();
+		static size_t getResidentSize(const StreamedTexture&, int);
+		static void uploadLevels(unsigned int, const StreamedTexture&, int);
+
+		TextureStreamer() {}
+		TextureStreamer(TextureStreamer const&) = delete;
+		void operator=(TextureStreamer const&) = delete;
+	};
+}
\ No newline at end of file
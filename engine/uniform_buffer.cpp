@@ -0,0 +1,64 @@
+#include <engine/uniform_buffer.h>
+#include <engine/staging_ring.h>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+
+namespace phoenix
+{
+	UniformBuffer::UniformBuffer(size_t capacity) : _capacity(capacity)
+	{
+		int alignment;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		_alignment = static_cast<size_t>(std::max(alignment, 1));
+		_data.reserve(capacity);
+
+		glGenBuffers(1, &_UBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _UBO);
+		glBufferData(GL_COPY_WRITE_BUFFER, _capacity, nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	size_t UniformBuffer::push(const void* block, size_t size)
+	{
+		const size_t offset = (_data.size() + _alignment - 1) / _alignment * _alignment;
+		_data.resize(offset + size);
+		std::memcpy(_data.data() + offset, block, size);
+		return offset;
+	}
+
+	void UniformBuffer::upload()
+	{
+		if (_data.size() > _capacity)
+		{
+			// Orphans the old storage, which the draws issued so far keep reading, so everything goes into the new one
+			_capacity = std::max(_capacity * 2, _data.size());
+			glBindBuffer(GL_COPY_WRITE_BUFFER, _UBO);
+			glBufferData(GL_COPY_WRITE_BUFFER, _capacity, nullptr, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			_uploaded = 0;
+		}
+		if (_data.size() > _uploaded)
+		{
+			// The copy is ordered after the draws reading the previous frame's blocks, so this never waits on the CPU
+			StagingRing::getInstance().upload(_UBO, _uploaded, _data.data() + _uploaded, _data.size() - _uploaded);
+			_uploaded = _data.size();
+		}
+	}
+
+	void UniformBuffer::bind(unsigned int binding, size_t offset, size_t size) const
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, _UBO, offset, size);
+	}
+
+	void UniformBuffer::reset()
+	{
+		_data.clear();
+		_uploaded = 0;
+	}
+
+	UniformBuffer::~UniformBuffer()
+	{
+		glDeleteBuffers(1, &_UBO);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <engine/common.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace phoenix
+{
+	// std140 uniform blocks shared across programs. Blocks are pushed on the CPU for a whole pass, copied into the
+	// buffer at once through the staging ring and then bound by range, so a draw only costs a range bind instead of
+	// a round of glUniform calls. Everything pushed stays valid until the next reset, which is meant once per frame.
+	class UniformBuffer
+	{
+	public:
+		UniformBuffer(size_t = UNIFORM_BUFFER_SIZE);
+
+		// Appends a block and returns its offset, aligned for binding
+		size_t push(const void*, size_t);
+		template<typename T>
+		inline size_t push(const T& block)
+		{
+			return push(&block, sizeof(T));
+		}
+		// Copies every block pushed since the last upload into the buffer, has to come before the draws that read them
+		void upload();
+		void bind(unsigned int, size_t, size_t) const;
+		template<typename T>
+		inline void bind(unsigned int binding, size_t offset) const
+		{
+			bind(binding, offset, sizeof(T));
+		}
+		void reset();
+
+		inline size_t getAlignment() const
+		{
+			return _alignment;
+		}
+
+		~UniformBuffer();
+
+	private:
+		unsigned int _UBO = 0;
+		size_t _capacity, _alignment, _uploaded = 0;
+		std::vector<unsigned char> _data;
+
+		UniformBuffer(UniformBuffer const&) = delete;
+		void operator=(UniformBuffer const&) = delete;
+	};
+}
\ No newline at end of file
@@ -1,14 +1,22 @@
 #include <engine/utils.h>
+#include <engine/gl_state.h>
 #include <engine/strings.h>
+#include <engine/texture_registry.h>
+#include <engine/staging_ring.h>
+#include <engine/mip_builder.h>
+#include <engine/texture_streamer.h>
 #include <engine/stb_image.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 namespace phoenix
 {
 	void Utils::renderPlane(const Shader& shader, const glm::vec3& translation)
 	{
+		GLState& state = GLState::getInstance();
 		shader.use();
 		glm::mat4 world = glm::mat4(1.0f);
 		world = glm::translate(world, translation);
@@ -36,29 +44,29 @@ namespace phoenix
 			glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-			glBindVertexArray(_planeVAO);
+			state.bindVertexArray(_planeVAO);
 			glEnableVertexAttribArray(0);
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 			glEnableVertexAttribArray(2);
 			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
 			glEnableVertexAttribArray(1);
 			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-			glBindVertexArray(0);
+			state.bindVertexArray(0);
 		}
 
-		glBindVertexArray(_planeVAO);
+		state.bindVertexArray(_planeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
 	}
 
 	void Utils::renderQuad(const Shader& shader, unsigned int texture)
 	{
+		GLState& state = GLState::getInstance();
 		shader.use();
 
 		if (texture)
 		{
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, texture);
+			state.activeTexture(GL_TEXTURE0);
+			state.bindTexture(GL_TEXTURE_2D, texture);
 		}
 
 		if (_quadVAO == 0)
@@ -78,21 +86,21 @@ namespace phoenix
 			glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-			glBindVertexArray(_quadVAO);
+			state.bindVertexArray(_quadVAO);
 			glEnableVertexAttribArray(0);
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
 			glEnableVertexAttribArray(1);
 			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-			glBindVertexArray(0);
+			state.bindVertexArray(0);
 		}
 
-		glBindVertexArray(_quadVAO);
+		state.bindVertexArray(_quadVAO);
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		glBindVertexArray(0);
 	}
 
 	void Utils::renderSphere()
 	{
+		GLState& state = GLState::getInstance();
 		if (_sphereVAO == 0)
 		{
 			glGenVertexArrays(1, &_sphereVAO);
@@ -164,7 +172,7 @@ namespace phoenix
 			}
 			_numIndices = indices.size();
 
-			glBindVertexArray(_sphereVAO);
+			state.bindVertexArray(_sphereVAO);
 
 			glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
 			glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
@@ -177,15 +185,16 @@ namespace phoenix
 			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
 			glEnableVertexAttribArray(2);
 			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
-			glBindVertexArray(0);
+			state.bindVertexArray(0);
 		}
 
-		glBindVertexArray(_sphereVAO);
+		state.bindVertexArray(_sphereVAO);
 		glDrawElements(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0);
 	}
 
 	void Utils::renderCube()
 	{
+		GLState& state = GLState::getInstance();
 		if (_cubeVAO == 0)
 		{
 			float vertices[] = {
@@ -240,7 +249,7 @@ namespace phoenix
 			glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
 			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-			glBindVertexArray(_cubeVAO);
+			state.bindVertexArray(_cubeVAO);
 			glEnableVertexAttribArray(0);
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 			glEnableVertexAttribArray(1);
@@ -248,12 +257,11 @@ namespace phoenix
 			glEnableVertexAttribArray(2);
 			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			glBindVertexArray(0);
+			state.bindVertexArray(0);
 		}
 
-		glBindVertexArray(_cubeVAO);
+		state.bindVertexArray(_cubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
 	}
 
 	Mesh* Utils::createQuad()
@@ -286,12 +294,42 @@ namespace phoenix
 		return new Mesh(vertices, indices);
 	}
 
-	unsigned int Utils::loadTexture(char const* filename)
+	unsigned int Utils::loadTexture(char const* filename, TextureUsage usage)
 	{
-		unsigned int textureID = -1;
+		TextureRegistry& registry = TextureRegistry::getInstance();
+		const uint64_t key = TextureRegistry::getKey(filename, false, usage);
+		unsigned int textureID = registry.acquire(key);
+		if (textureID)
+		{
+			return textureID;
+		}
+		textureID = -1;
 
+		std::unique_ptr<CookedTexture> cooked(new CookedTexture(filename, usage));
 		int width, height, n;
-		unsigned char* data = stbi_load(filename, &width, &height, &n, 0);
+		unsigned char* data = nullptr;
+		if (!cooked->isValid())
+		{
+			data = stbi_load(filename, &width, &height, &n, 0);
+			if (data && CookedTexture::cook(filename, usage, data, width, height, n))
+			{
+				cooked.reset(new CookedTexture(filename, usage));
+			}
+		}
+		if (cooked->isValid())
+		{
+			stbi_image_free(data);
+			TextureStreamer& streamer = TextureStreamer::getInstance();
+			if (streamer.isEnabled())
+			{
+				textureID = streamer.add(std::move(cooked));
+				registry.insert(key, textureID, streamer.getResidentBytes(textureID));
+				return textureID;
+			}
+			textureID = cooked->upload();
+			registry.insert(key, textureID, cooked->getSize());
+			return textureID;
+		}
 		if (data)
 		{
 			GLenum format;
@@ -313,14 +351,29 @@ namespace phoenix
 			}
 
 			glGenTextures(1, &textureID);
-			glBindTexture(GL_TEXTURE_2D, textureID);
-			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
+			GLState::getInstance().bindTexture(GL_TEXTURE_2D, textureID);
+			// Rows are tightly packed, which the pixel unpack buffer has to be told about
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			StagingRing& ring = StagingRing::getInstance();
+			size_t bytes = static_cast<size_t>(width) * height * n;
+			ring.uploadTexture(GL_TEXTURE_2D, 0, format, width, height, format, GL_UNSIGNED_BYTE, data, bytes);
+			const std::vector<std::vector<unsigned char>> mipmaps = buildMipChain(data, width, height, n, usage);
+			for (size_t i = 0; i < mipmaps.size(); ++i)
+			{
+				width = std::max(width / 2, 1);
+				height = std::max(height / 2, 1);
+				ring.uploadTexture(GL_TEXTURE_2D, i + 1, format, width, height, format, GL_UNSIGNED_BYTE, mipmaps[i].data(), mipmaps[i].size());
+				bytes += mipmaps[i].size();
+			}
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmaps.size());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+			registry.insert(key, textureID, bytes);
 		}
 		else
 		{
@@ -4,6 +4,7 @@
 
 #include <engine/mesh.h>
 #include <engine/camera.h>
+#include <engine/texture_cooker.h>
 
 namespace phoenix
 {
@@ -19,7 +20,8 @@ namespace phoenix
 		void renderSphere();
 		void renderCube();
 		static Mesh* createQuad();
-		static unsigned int loadTexture(char const*);
+		// Prefers the cooked, block-compressed copy of the file and cooks it if missing, see TextureLoader
+		static unsigned int loadTexture(char const*, TextureUsage = USAGE_COLOR);
 		virtual void processInput(GLFWwindow*, Camera*, bool = true);
 
 	private:
@@ -0,0 +1,119 @@
+#include <engine/vertex_format.h>
+#include <engine/mesh.h>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace phoenix
+{
+	namespace
+	{
+		float getAngleBetween(const glm::vec3& a, const glm::vec3& b)
+		{
+			if (glm::dot(a, a) == 0.0f || glm::dot(b, b) == 0.0f)
+			{
+				return 0.0f;
+			}
+			return glm::degrees(std::acos(glm::clamp(glm::dot(glm::normalize(a), glm::normalize(b)), -1.0f, 1.0f)));
+		}
+	}
+
+	glm::mat4 packVertices(const Vertex* vertices, unsigned int numVertices, std::vector<PackedVertex>& packedVertices, PackingError& error)
+	{
+		glm::vec3 min(0.0f), max(0.0f);
+		if (numVertices)
+		{
+			min = max = vertices[0]._position;
+		}
+		for (size_t i = 1; i < numVertices; ++i)
+		{
+			min = glm::min(min, vertices[i]._position);
+			max = glm::max(max, vertices[i]._position);
+		}
+		const glm::vec3 extent = max - min;
+		const glm::vec3 invExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f, extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+		error = PackingError();
+		double totalPositionError = 0.0;
+		packedVertices.resize(numVertices);
+		for (size_t i = 0; i < numVertices; ++i)
+		{
+			const Vertex& vertex = vertices[i];
+			PackedVertex& packedVertex = packedVertices[i];
+
+			const glm::vec3 normalizedPosition = glm::clamp((vertex._position - min) * invExtent, 0.0f, 1.0f);
+			for (int c = 0; c < 3; ++c)
+			{
+				packedVertex._position[c] = static_cast<uint16_t>(std::round(normalizedPosition[c] * 65535.0f));
+			}
+			packedVertex._padding = 0;
+			packedVertex._texCoords = glm::packHalf2x16(vertex._texCoords);
+			packedVertex._normal = glm::packSnorm3x10_1x2(glm::vec4(glm::length(vertex._normal) > 0.0f ? glm::normalize(vertex._normal) : vertex._normal, 0.0f));
+			const float bitangentSign = glm::dot(glm::cross(vertex._normal, vertex._tangent), vertex._bitangent) < 0.0f ? -1.0f : 1.0f;
+			packedVertex._tangent = glm::packSnorm3x10_1x2(glm::vec4(glm::length(vertex._tangent) > 0.0f ? glm::normalize(vertex._tangent) : vertex._tangent, bitangentSign));
+
+			// Decode exactly as the vertex fetch would and measure against the source
+			const glm::vec3 position = min + glm::vec3(packedVertex._position[0], packedVertex._position[1], packedVertex._position[2]) / 65535.0f * extent;
+			const float positionError = glm::distance(position, vertex._position);
+			totalPositionError += positionError;
+			error._maxPositionError = std::max(error._maxPositionError, positionError);
+			const glm::vec4 normal = glm::unpackSnorm3x10_1x2(packedVertex._normal);
+			error._maxNormalError = std::max(error._maxNormalError, getAngleBetween(glm::vec3(normal), vertex._normal));
+			const glm::vec4 tangent = glm::unpackSnorm3x10_1x2(packedVertex._tangent);
+			error._maxTangentError = std::max(error._maxTangentError, getAngleBetween(glm::vec3(tangent), vertex._tangent));
+			const glm::vec2 texCoords = glm::unpackHalf2x16(packedVertex._texCoords);
+			error._maxTexCoordError = std::max(error._maxTexCoordError, glm::length(texCoords - vertex._texCoords));
+			// The reconstructed bitangent only approximates non-orthogonal tangent frames
+			if (getAngleBetween(glm::cross(glm::vec3(normal), glm::vec3(tangent)) * tangent.w, vertex._bitangent) > 90.0f)
+			{
+				++error._numFlippedBitangents;
+			}
+		}
+		error._meanPositionError = numVertices ? static_cast<float>(totalPositionError / numVertices) : 0.0f;
+
+		glm::mat4 dequantization = glm::translate(glm::mat4(1.0f), min);
+		return glm::scale(dequantization, extent);
+	}
+
+	void PackingError::print(unsigned int numVertices) const
+	{
+		std::cout << "Packed " << numVertices << " vertices at " << sizeof(PackedVertex) << " bytes (was " << sizeof(Vertex) << "): position error max "
+			<< _maxPositionError << ", mean " << _meanPositionError << "; normal error max " << _maxNormalError << " deg; tangent error max "
+			<< _maxTangentError << " deg; UV error max " << _maxTexCoordError << "; " << _numFlippedBitangents << " flipped bitangents\n";
+	}
+
+	void setVertexAttributes(VertexFormat vertexFormat)
+	{
+		if (vertexFormat == PACKED)
+		{
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, _position));
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, _normal));
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, _texCoords));
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, _tangent));
+		}
+		else
+		{
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _normal));
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _texCoords));
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _tangent));
+			glEnableVertexAttribArray(4);
+			glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, _bitangent));
+		}
+	}
+
+	unsigned int getVertexSize(VertexFormat vertexFormat)
+	{
+		return vertexFormat == PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace phoenix
+{
+	struct Vertex;
+
+	enum VertexFormat
+	{
+		UNPACKED, // 56 byte float vertices
+		PACKED // 20 byte quantized vertices, see PackedVertex
+	};
+
+	// Every attribute uses a type the vertex fetch hardware decodes by itself, so shaders read the same vec2/vec3
+	// inputs for both formats. Positions are normalized to the mesh bounding box, which is undone by folding
+	// Mesh::_dequantization into the world matrix. The bitangent is not stored and is cross(N, T) * T.w.
+	struct PackedVertex
+	{
+		uint16_t _position[3]; // Unsigned normalized, relative to the mesh bounding box
+		uint16_t _padding;
+		uint32_t _texCoords; // Two half floats
+		uint32_t _normal; // Signed normalized 10:10:10:2
+		uint32_t _tangent; // Signed normalized 10:10:10:2, w holds the bitangent sign
+	};
+
+	// Quantization error of a packed mesh relative to its float source
+	struct PackingError
+	{
+		float _maxPositionError = 0.0f, _meanPositionError = 0.0f; // Object space units
+		float _maxNormalError = 0.0f, _maxTangentError = 0.0f; // Degrees
+		float _maxTexCoordError = 0.0f;
+		unsigned int _numFlippedBitangents = 0;
+
+		void print(unsigned int) const;
+	};
+
+	// Packs the vertices and returns the matrix that maps the normalized positions back to object space
+	glm::mat4 packVertices(const Vertex*, unsigned int, std::vector<PackedVertex>&, PackingError&);
+	// Describes the format to the bound VAO, sourcing from the bound GL_ARRAY_BUFFER
+	void setVertexAttributes(VertexFormat);
+	unsigned int getVertexSize(VertexFormat);
+}
\ No newline at end of file
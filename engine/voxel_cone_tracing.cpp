@@ -1,7 +1,9 @@
 #include <engine/voxel_cone_tracing.h>
+#include <engine/gl_state.h>
 #include <engine/common.h>
 #include <engine/strings.h>
 #include <engine/material_store.h>
+#include <engine/staging_ring.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 
@@ -14,7 +16,7 @@ phoenix::VoxelConeTracingScene* _scenePtr;
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	phoenix::GLState::getInstance().viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -80,7 +82,8 @@ namespace phoenix
 		_renderer = new Renderer();
 		std::cout << "Renderer initialized.\n";
 
-		_scene = new VoxelConeTracingScene();
+		_modelLoader = new ModelLoader();
+		_scene = new VoxelConeTracingScene(*_modelLoader);
 		_scenePtr = _scene;
 		std::cout << "Scene initialized.\n";
 
@@ -101,7 +104,9 @@ namespace phoenix
 
 			processInput();
 
+			_modelLoader->update();
 			_renderer->render(_scene, _renderMode);
+			StagingRing::getInstance().fence();
 
 			glfwSwapBuffers(_window);
 			glfwPollEvents();
@@ -113,6 +118,7 @@ namespace phoenix
 	VoxelConeTracing::~VoxelConeTracing()
 	{
 		delete _renderer;
+		delete _modelLoader;
 		delete _scene;
 		delete _utils;
 	}
@@ -141,7 +147,7 @@ namespace phoenix
 			_scene->_camera->processKeyPress(phoenix::RIGHT, _utils->_deltaTime);
 		}
 
-		if (_scene->_lightSphere)
+		if (_scene->_lightSphere->isResident())
 		{
 			if (glfwGetKey(_window, GLFW_KEY_I) == GLFW_PRESS)
 			{
@@ -20,6 +20,7 @@ namespace phoenix
 		GLFWwindow* _window;
 		Utils* _utils;
 		VoxelConeTracingScene* _scene;
+		ModelLoader* _modelLoader;
 		Renderer* _renderer;
 
 		void processInput();
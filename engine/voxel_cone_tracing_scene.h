@@ -3,7 +3,7 @@
 
 #include <engine/light.h>
 #include <engine/camera.h>
-#include <engine/model.h>
+#include <engine/model_loader.h>
 
 namespace phoenix
 {
@@ -14,7 +14,7 @@ namespace phoenix
 		PointLight* _pointLight;
 		Model* _lightSphere;
 
-		VoxelConeTracingScene();
+		VoxelConeTracingScene(ModelLoader&);
 		~VoxelConeTracingScene();
 	};
 }
\ No newline at end of file
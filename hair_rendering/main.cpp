@@ -4,6 +4,7 @@
 #include <engine/strings.h>
 #include <engine/common.h>
 #include <engine/framebuffer.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <time.h>
@@ -19,6 +20,7 @@ void execShadowMapPass(const phoenix::Shader&, phoenix::Model&);
 void execRenderPass(const phoenix::Shader&, const phoenix::Shader&, phoenix::Model&);
 void initPointers();
 void deletePointers();
+phoenix::Shader::Defines getHairDefines(unsigned int);
 
 // Parameters for our hair model
 const glm::vec3 TRANSLATION = glm::vec3(0.0f, -4.5f, 0.0f), SCALE = glm::vec3(0.1f);
@@ -37,6 +39,8 @@ bool calibratedCursor = false;
 
 unsigned int anglesTexture, normalMap, ambientOcclusionMap, specularMap, alphaTexture, shiftTexture, noiseTexture;
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -62,18 +66,18 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
 	shadowCommon->_floorTexture = phoenix::Utils::loadTexture("../Resources/Textures/shadow_mapping/wood.png");
 	shadowCommon->_objectTexture = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_diff_black.jpg");
-	normalMap = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_normal.png");
-	ambientOcclusionMap = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_ao.png");
-	specularMap = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_spec.jpg");
-	alphaTexture = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_op.psd");
-	shiftTexture = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_shift.png");
-	noiseTexture = phoenix::Utils::loadTexture("../Resources/Objects/hair/GlitterTexture.png");
+	normalMap = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_normal.png", phoenix::USAGE_NORMAL);
+	ambientOcclusionMap = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_ao.png", phoenix::USAGE_MASK);
+	specularMap = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_spec.jpg", phoenix::USAGE_MASK);
+	alphaTexture = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_op.psd", phoenix::USAGE_MASK);
+	shiftTexture = phoenix::Utils::loadTexture("../Resources/Objects/hair/hair_shift.png", phoenix::USAGE_MASK);
+	noiseTexture = phoenix::Utils::loadTexture("../Resources/Objects/hair/GlitterTexture.png", phoenix::USAGE_MASK);
 	// Generate volume textures and fill them with the cosines and sines of random rotation angles for PCSS
 	generateRandom3DTexture();
 
@@ -86,18 +90,28 @@ int main()
 	floorShader.setFloat(phoenix::G_SPECULAR_FACTOR, phoenix::SPECULAR_FACTOR);
 	floorShader.setFloat(phoenix::G_CALIBRATED_LIGHT_SIZE, phoenix::CALIBRATED_LIGHT_SIZE);
 	floorShader.setVec3(phoenix::G_LIGHT_COLOR, phoenix::LIGHT_COLOR);
-	phoenix::Shader hairShader("../Resources/Shaders/hair/hair.vs", "../Resources/Shaders/hair/hair.fs");
-	hairShader.use();
-	hairShader.setInt("gBaseTexture", 0);
-	hairShader.setInt(phoenix::G_NORMAL_MAP, 3);
-	hairShader.setInt(phoenix::G_AO_MAP, 4);
-	hairShader.setInt(phoenix::G_SPECULAR_MAP, 5);
-	hairShader.setInt("gAlphaTexture", 6);
-	hairShader.setInt("gShiftTexture", 7);
-	hairShader.setInt("gNoiseTexture", 8);
-	hairShader.setFloat(phoenix::G_AMBIENT_FACTOR, 0.8f);
-	hairShader.setFloat(phoenix::G_SPECULAR_FACTOR, phoenix::SPECULAR_FACTOR);
-	hairShader.setVec3(phoenix::G_LIGHT_COLOR, phoenix::LIGHT_COLOR);
+	// Each lighting term view and the Blinn-Phong look are variants of their own, all submitted before any gets set up
+	phoenix::ShaderVariants hairShaders("../Resources/Shaders/hair/hair.vs", "../Resources/Shaders/hair/hair.fs");
+	const unsigned int HAIR_MODES[] = { 0, 2, 3, 4, 5, 6, 7 };
+	for (unsigned int renderMode : HAIR_MODES)
+	{
+		hairShaders.get(getHairDefines(renderMode));
+	}
+	for (unsigned int renderMode : HAIR_MODES)
+	{
+		const phoenix::Shader& hairShader = hairShaders.get(getHairDefines(renderMode));
+		hairShader.use();
+		hairShader.setInt("gBaseTexture", 0);
+		hairShader.setInt(phoenix::G_NORMAL_MAP, 3);
+		hairShader.setInt(phoenix::G_AO_MAP, 4);
+		hairShader.setInt(phoenix::G_SPECULAR_MAP, 5);
+		hairShader.setInt("gAlphaTexture", 6);
+		hairShader.setInt("gShiftTexture", 7);
+		hairShader.setInt("gNoiseTexture", 8);
+		hairShader.setFloat(phoenix::G_AMBIENT_FACTOR, 0.8f);
+		hairShader.setFloat(phoenix::G_SPECULAR_FACTOR, phoenix::SPECULAR_FACTOR);
+		hairShader.setVec3(phoenix::G_LIGHT_COLOR, phoenix::LIGHT_COLOR);
+	}
 	phoenix::Shader shadowMapPassShader("../Resources/Shaders/hair/shadow_map_pass.vs", "../Resources/Shaders/hair/shadow_map_pass.fs");
 	phoenix::Shader renderQuadShader("../Resources/Shaders/hair/render_quad.vs", "../Resources/Shaders/hair/render_quad.fs");
 	renderQuadShader.use();
@@ -106,9 +120,6 @@ int main()
 
 	phoenix::Model hair("../Resources/Objects/hair/hair2_black_obj.obj");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, renderTargets->_FBO);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-
 	while (!glfwWindowShouldClose(window))
 	{
 		utils->_projection = glm::perspective(glm::radians(camera->_FOV), static_cast<float>(phoenix::SCREEN_WIDTH) / phoenix::SCREEN_HEIGHT, phoenix::PERSPECTIVE_NEAR_PLANE, phoenix::PERSPECTIVE_FAR_PLANE);
@@ -126,7 +137,7 @@ int main()
 		// Shadow map pass
 		execShadowMapPass(shadowMapPassShader, hair);
 
-		glViewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+		glState.viewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// Render pass
@@ -136,7 +147,7 @@ int main()
 		}
 		else
 		{
-			execRenderPass(floorShader, hairShader, hair);
+			execRenderPass(floorShader, hairShaders.get(getHairDefines(shadowCommon->_renderMode)), hair);
 			shadowCommon->renderDebugLines(debugLinesShader, utils);
 		}
 
@@ -151,7 +162,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -195,7 +206,7 @@ void generateRandom3DTexture()
 	}
 
 	glGenTextures(1, &anglesTexture);
-	glBindTexture(GL_TEXTURE_3D, anglesTexture);
+	glState.bindTexture(GL_TEXTURE_3D, anglesTexture);
 	glTexImage3D(GL_TEXTURE_3D, 0, GL_RG16F, RESOLUTION, RESOLUTION, RESOLUTION, 0, GL_RG, GL_FLOAT, &randomAngles);
 
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -211,35 +222,35 @@ void setInputs(const phoenix::Shader& shader, bool useObjTexture)
 	shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
 
 	shadowCommon->changeColorTexture(useObjTexture ? shadowCommon->_objectTexture : shadowCommon->_floorTexture);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, renderTargets->_textureID);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_3D, anglesTexture);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, normalMap);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, ambientOcclusionMap);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, specularMap);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, alphaTexture);
-	glActiveTexture(GL_TEXTURE7);
-	glBindTexture(GL_TEXTURE_2D, shiftTexture);
-	glActiveTexture(GL_TEXTURE8);
-	glBindTexture(GL_TEXTURE_2D, noiseTexture);
+	glState.activeTexture(GL_TEXTURE1);
+	glState.bindTexture(GL_TEXTURE_2D, renderTargets->_textureID);
+	glState.activeTexture(GL_TEXTURE2);
+	glState.bindTexture(GL_TEXTURE_3D, anglesTexture);
+	glState.activeTexture(GL_TEXTURE3);
+	glState.bindTexture(GL_TEXTURE_2D, normalMap);
+	glState.activeTexture(GL_TEXTURE4);
+	glState.bindTexture(GL_TEXTURE_2D, ambientOcclusionMap);
+	glState.activeTexture(GL_TEXTURE5);
+	glState.bindTexture(GL_TEXTURE_2D, specularMap);
+	glState.activeTexture(GL_TEXTURE6);
+	glState.bindTexture(GL_TEXTURE_2D, alphaTexture);
+	glState.activeTexture(GL_TEXTURE7);
+	glState.bindTexture(GL_TEXTURE_2D, shiftTexture);
+	glState.activeTexture(GL_TEXTURE8);
+	glState.bindTexture(GL_TEXTURE_2D, noiseTexture);
 }
 
 void execShadowMapPass(const phoenix::Shader& shader, phoenix::Model& object)
 {
 	shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
-	glViewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, renderTargets->_FBO);
+	glState.viewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, renderTargets->_FBO);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	utils->renderPlane(shader);
 	shadowCommon->renderObject(utils, shader, object, TRANSLATION, ROTATION, SCALE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void execRenderPass(const phoenix::Shader& floorShader, const phoenix::Shader& hairShader, phoenix::Model& object)
@@ -253,7 +264,9 @@ void execRenderPass(const phoenix::Shader& floorShader, const phoenix::Shader& h
 void initPointers()
 {
 	shadowCommon = new phoenix::ShadowCommon();
-	renderTargets = new phoenix::Framebuffer(phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT, true);
+	// Depth alone, the shadow map pass writes no color
+	renderTargets = &phoenix::Framebuffer::acquire({ phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT, {}, { GL_DEPTH_COMPONENT24, true } });
+	std::cout << "Shadow map: " << renderTargets->getMemorySize() / (1024.0 * 1024.0) << " MB\n";
 	utils = new phoenix::Utils();
 	camera = new phoenix::Camera();
 }
@@ -262,6 +275,12 @@ void deletePointers()
 {
 	delete camera;
 	delete utils;
-	delete renderTargets;
+	phoenix::Framebuffer::releaseAcquired();
 	delete shadowCommon;
+}
+
+phoenix::Shader::Defines getHairDefines(unsigned int renderMode)
+{
+	// The shadow map view doesn't draw the hair, so it shares the default variant
+	return { { "RENDER_MODE", std::to_string(renderMode == 1 ? 0 : renderMode) } };
 }
\ No newline at end of file
@@ -1,11 +1,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <engine/stb_image.h>
 #include <engine/model.h>
 #include <engine/utils.h>
 #include <engine/strings.h>
 #include <engine/common.h>
 #include <engine/sh.h>
+#include <engine/texture_loader.h>
+#include <engine/environment_map.h>
+#include <engine/gl_state.h>
 
 #include <iostream>
 
@@ -23,15 +25,15 @@ void setZBufferMemoryAttachment(int);
 void unbindFBOAndZBufferAttachment();
 
 void setupFramebuffer();
-unsigned int loadHDRTexture(char const*);
 unsigned int generateCubemapTexture(int, bool);
 void setInputTexture(const phoenix::Shader&, unsigned int, bool);
 void renderToCubemap(const phoenix::Shader&, unsigned int, int, int);
 unsigned int integrateBRDF(const phoenix::Shader&);
 void resetViewportToFramebufferSize();
+phoenix::Shader::Defines getSkyboxDefines(unsigned int);
 
 // Environment map, BRDF LUT, and spherical harmonic coefficient render target resolution
-const int RESOLUTION = 512;
+const int RESOLUTION = phoenix::ENVIRONMENT_MAP_RESOLUTION;
 const int IRRADIANCE_MAP_RES = 32, PREFILTERED_ENV_MAP_RES = 128;
 const unsigned int NUM_MIP_LEVELS = 5;
 
@@ -72,6 +74,8 @@ const std::array<glm::mat4, 6> CUBEMAP_VIEWS{ {
 	glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f))
 } };
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -98,13 +102,92 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LEQUAL);
-	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	glState.enable(GL_DEPTH_TEST);
+	glState.depthFunc(GL_LEQUAL);
+	glState.enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
 	initPointers();
 
+	// Programs compile on driver threads while the assets below load
 	phoenix::Shader renderShader("../Resources/Shaders/pbr/render.vs", "../Resources/Shaders/pbr/render.fs");
+	phoenix::Shader irradianceMapShader("../Resources/Shaders/pbr/precompute.vs", "../Resources/Shaders/pbr/irradiance_map.fs");
+	phoenix::Shader prefilterEnvMapShader("../Resources/Shaders/pbr/precompute.vs", "../Resources/Shaders/pbr/prefilter_env_map.fs");
+	phoenix::Shader integrateBRDFShader("../Resources/Shaders/pbr/integrateBRDF.vs", "../Resources/Shaders/pbr/integrateBRDF.fs");
+	// The spherical harmonics irradiance view is a skybox variant of its own
+	phoenix::ShaderVariants skyboxShaders("../Resources/Shaders/pbr/skybox.vs", "../Resources/Shaders/pbr/skybox.fs");
+	const unsigned int SKYBOX_MODES[] = { 0, 3 };
+	for (unsigned int renderMode : SKYBOX_MODES)
+	{
+		skyboxShaders.get(getSkyboxDefines(renderMode));
+	}
+
+	// PBR Textures, decoded on worker threads while the models below are imported
+	phoenix::TextureLoader textureLoader;
+	unsigned int ironAlbedoMap, ironNormalMap, ironMetallicMap, ironRoughnessMap, defaultAOMap;
+	unsigned int goldAlbedoMap, goldNormalMap, goldMetallicMap, goldRoughnessMap;
+	unsigned int woodAlbedoMap, woodNormalMap, woodMetallicMap, woodRoughnessMap, woodAOMap;
+	unsigned int plasticAlbedoMap, plasticNormalMap, plasticMetallicMap, plasticRoughnessMap, plasticAOMap;
+	unsigned int marbleAlbedoMap, marbleNormalMap, marbleMetallicMap, marbleRoughnessMap;
+	unsigned int gunAlbedoMap, gunNormalMap, gunMetallicMap, gunRoughnessMap, gunAOMap;
+	unsigned int skullAlbedoMap, skullNormalMap, skullMetallicMap, skullRoughnessMap, skullAOMap;
+	textureLoader.enqueue("../Resources/Textures/pbr/rusted_iron/rustediron2_basecolor.png", &ironAlbedoMap);
+	textureLoader.enqueue("../Resources/Textures/pbr/rusted_iron/rustediron2_normal.png", &ironNormalMap, phoenix::USAGE_NORMAL);
+	textureLoader.enqueue("../Resources/Textures/pbr/rusted_iron/rustediron2_metallic.png", &ironMetallicMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/rusted_iron/rustediron2_roughness.png", &ironRoughnessMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/ao.png", &defaultAOMap, phoenix::USAGE_MASK);
+
+	textureLoader.enqueue("../Resources/Textures/pbr/gold/gold-scuffed_basecolor.png", &goldAlbedoMap);
+	textureLoader.enqueue("../Resources/Textures/pbr/gold/gold-scuffed_normal.png", &goldNormalMap, phoenix::USAGE_NORMAL);
+	textureLoader.enqueue("../Resources/Textures/pbr/gold/gold-scuffed_metallic.png", &goldMetallicMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/gold/gold-scuffed_roughness.png", &goldRoughnessMap, phoenix::USAGE_MASK);
+
+	textureLoader.enqueue("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-albedo.png", &woodAlbedoMap);
+	textureLoader.enqueue("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-normal.png", &woodNormalMap, phoenix::USAGE_NORMAL);
+	textureLoader.enqueue("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-metal.png", &woodMetallicMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-roughness.png", &woodRoughnessMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-ao.png", &woodAOMap, phoenix::USAGE_MASK);
+
+	textureLoader.enqueue("../Resources/Textures/pbr/plastic/scuffed-plastic4-alb.png", &plasticAlbedoMap);
+	textureLoader.enqueue("../Resources/Textures/pbr/plastic/scuffed-plastic-normal.png", &plasticNormalMap, phoenix::USAGE_NORMAL);
+	textureLoader.enqueue("../Resources/Textures/pbr/plastic/scuffed-plastic-metal.png", &plasticMetallicMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/plastic/scuffed-plastic-rough.png", &plasticRoughnessMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/plastic/scuffed-plastic-ao.png", &plasticAOMap, phoenix::USAGE_MASK);
+
+	textureLoader.enqueue("../Resources/Textures/pbr/marble/granitesmooth1-albedo2.png", &marbleAlbedoMap);
+	textureLoader.enqueue("../Resources/Textures/pbr/marble/granitesmooth1-normal2.png", &marbleNormalMap, phoenix::USAGE_NORMAL);
+	textureLoader.enqueue("../Resources/Textures/pbr/marble/granitesmooth1-metalness.png", &marbleMetallicMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Textures/pbr/marble/granitesmooth1-roughness3.png", &marbleRoughnessMap, phoenix::USAGE_MASK);
+
+	textureLoader.enqueue("../Resources/Objects/gun/Textures/Cerberus_A.tga", &gunAlbedoMap);
+	textureLoader.enqueue("../Resources/Objects/gun/Textures/Cerberus_N.tga", &gunNormalMap, phoenix::USAGE_NORMAL);
+	textureLoader.enqueue("../Resources/Objects/gun/Textures/Cerberus_M.tga", &gunMetallicMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Objects/gun/Textures/Cerberus_R.tga", &gunRoughnessMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Objects/gun/Textures/Cerberus_AO.tga", &gunAOMap, phoenix::USAGE_MASK);
+
+	phoenix::Model gun("../Resources/Objects/gun/Cerberus_LP.FBX");
+
+	textureLoader.enqueue("../Resources/Objects/skull/RealTime_M_low1_BaseColor.png", &skullAlbedoMap);
+	textureLoader.enqueue("../Resources/Objects/skull/Normal.png", &skullNormalMap, phoenix::USAGE_NORMAL);
+	textureLoader.enqueue("../Resources/Objects/skull/Metallic.png", &skullMetallicMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Objects/skull/Roughness.png", &skullRoughnessMap, phoenix::USAGE_MASK);
+	textureLoader.enqueue("../Resources/Objects/skull/AO.png", &skullAOMap, phoenix::USAGE_MASK);
+
+	phoenix::Model skull("../Resources/Objects/skull/Skull_Low_res.obj");
+
+	textureLoader.finish();
+
+	// The original HDR texture mapped onto its cubemap equivalent for our calculations. The conversion, mipmaps
+	// included, happens on the CPU on the first run and is loaded from the converted file from then on.
+	unsigned int envMap = phoenix::EnvironmentMap::load("../Resources/Textures/pbr/Newport_Loft_Ref.hdr", RESOLUTION);
+
+	// Keep presenting while the driver finishes the programs
+	while (!phoenix::Shader::pollPending())
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
 	renderShader.use();
 	renderShader.setInt(phoenix::G_IRRADIANCE_MAP, 0);
 	renderShader.setInt("gPrefilteredEnvMap", 1);
@@ -119,90 +202,33 @@ int main()
 		renderShader.setVec3("gLightPositions[" + std::to_string(i) + "]", LIGHT_POSITIONS[i]);
 		renderShader.setVec3("gLightColors[" + std::to_string(i) + "]", LIGHT_COLORS[i]);
 	}
-	phoenix::Shader equirectangularToCubemapShader("../Resources/Shaders/pbr/precompute.vs", "../Resources/Shaders/pbr/equirectangular_to_cubemap.fs");
-	equirectangularToCubemapShader.use();
-	equirectangularToCubemapShader.setInt(G_ENV_MAP, 0);
-	phoenix::Shader irradianceMapShader("../Resources/Shaders/pbr/precompute.vs", "../Resources/Shaders/pbr/irradiance_map.fs");
 	irradianceMapShader.use();
 	irradianceMapShader.setInt(G_ENV_MAP, 0);
-	phoenix::Shader prefilterEnvMapShader("../Resources/Shaders/pbr/precompute.vs", "../Resources/Shaders/pbr/prefilter_env_map.fs");
 	prefilterEnvMapShader.use();
 	prefilterEnvMapShader.setInt(G_ENV_MAP, 0);
 	prefilterEnvMapShader.setFloat("gSpecConvTexWidth", PREFILTERED_ENV_MAP_RES);
-	phoenix::Shader integrateBRDFShader("../Resources/Shaders/pbr/integrateBRDF.vs", "../Resources/Shaders/pbr/integrateBRDF.fs");
-	phoenix::Shader skyboxShader("../Resources/Shaders/pbr/skybox.vs", "../Resources/Shaders/pbr/skybox.fs");
-	skyboxShader.use();
-	skyboxShader.setInt(G_ENV_MAP, 0);
-
-	// PBR Textures
-	unsigned int ironAlbedoMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/rusted_iron/rustediron2_basecolor.png");
-	unsigned int ironNormalMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/rusted_iron/rustediron2_normal.png");
-	unsigned int ironMetallicMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/rusted_iron/rustediron2_metallic.png");
-	unsigned int ironRoughnessMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/rusted_iron/rustediron2_roughness.png");
-	unsigned int defaultAOMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/ao.png");
-
-	unsigned int goldAlbedoMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/gold/gold-scuffed_basecolor.png");
-	unsigned int goldNormalMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/gold/gold-scuffed_normal.png");
-	unsigned int goldMetallicMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/gold/gold-scuffed_metallic.png");
-	unsigned int goldRoughnessMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/gold/gold-scuffed_roughness.png");
-
-	unsigned int woodAlbedoMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-albedo.png");
-	unsigned int woodNormalMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-normal.png");
-	unsigned int woodMetallicMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-metal.png");
-	unsigned int woodRoughnessMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-roughness.png");
-	unsigned int woodAOMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/wood/bamboo-wood-semigloss-ao.png");
-
-	unsigned int plasticAlbedoMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/plastic/scuffed-plastic4-alb.png");
-	unsigned int plasticNormalMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/plastic/scuffed-plastic-normal.png");
-	unsigned int plasticMetallicMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/plastic/scuffed-plastic-metal.png");
-	unsigned int plasticRoughnessMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/plastic/scuffed-plastic-rough.png");
-	unsigned int plasticAOMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/plastic/scuffed-plastic-ao.png");
-
-	unsigned int marbleAlbedoMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/marble/granitesmooth1-albedo2.png");
-	unsigned int marbleNormalMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/marble/granitesmooth1-normal2.png");
-	unsigned int marbleMetallicMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/marble/granitesmooth1-metalness.png");
-	unsigned int marbleRoughnessMap = phoenix::Utils::loadTexture("../Resources/Textures/pbr/marble/granitesmooth1-roughness3.png");
-
-	unsigned int gunAlbedoMap = phoenix::Utils::loadTexture("../Resources/Objects/gun/Textures/Cerberus_A.tga");
-	unsigned int gunNormalMap = phoenix::Utils::loadTexture("../Resources/Objects/gun/Textures/Cerberus_N.tga");
-	unsigned int gunMetallicMap = phoenix::Utils::loadTexture("../Resources/Objects/gun/Textures/Cerberus_M.tga");
-	unsigned int gunRoughnessMap = phoenix::Utils::loadTexture("../Resources/Objects/gun/Textures/Cerberus_R.tga");
-	unsigned int gunAOMap = phoenix::Utils::loadTexture("../Resources/Objects/gun/Textures/Cerberus_AO.tga");
-
-	phoenix::Model gun("../Resources/Objects/gun/Cerberus_LP.FBX");
-
-	unsigned int skullAlbedoMap = phoenix::Utils::loadTexture("../Resources/Objects/skull/RealTime_M_low1_BaseColor.png");
-	unsigned int skullNormalMap = phoenix::Utils::loadTexture("../Resources/Objects/skull/Normal.png");
-	unsigned int skullMetallicMap = phoenix::Utils::loadTexture("../Resources/Objects/skull/Metallic.png");
-	unsigned int skullRoughnessMap = phoenix::Utils::loadTexture("../Resources/Objects/skull/Roughness.png");
-	unsigned int skullAOMap = phoenix::Utils::loadTexture("../Resources/Objects/skull/AO.png");
-
-	phoenix::Model skull("../Resources/Objects/skull/Skull_Low_res.obj");
-
-	unsigned int equirectangularEnvMap = loadHDRTexture("../Resources/Textures/pbr/Newport_Loft_Ref.hdr");
+	for (unsigned int renderMode : SKYBOX_MODES)
+	{
+		const phoenix::Shader& skyboxShader = skyboxShaders.get(getSkyboxDefines(renderMode));
+		skyboxShader.use();
+		skyboxShader.setInt(G_ENV_MAP, 0);
+	}
 
 	setupFramebuffer();
 
-	// We're going to map the original HDR texture onto its cubemap equivalent for our calculations
-	unsigned int envMap = generateCubemapTexture(RESOLUTION, true);
-	setInputTexture(equirectangularToCubemapShader, equirectangularEnvMap, false);
-	renderToCubemap(equirectangularToCubemapShader, envMap, RESOLUTION, 0);
-	// This is to address a particular artifact
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envMap);
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
 	// Precompute an irradiance map that contains diffuse radiance data resulting from the Lambertian diffuse BRDF
 	unsigned int irradianceMap = generateCubemapTexture(IRRADIANCE_MAP_RES, false);
 	setInputTexture(irradianceMapShader, envMap, true);
 	renderToCubemap(irradianceMapShader, irradianceMap, IRRADIANCE_MAP_RES, 0);
 
 	phoenix::SH9Color lightingCoefficients = phoenix::genLightingCoefficients(envMap, RESOLUTION);
+	const phoenix::Shader& irradianceSkyboxShader = skyboxShaders.get(getSkyboxDefines(3));
 	for (size_t i = 0; i < lightingCoefficients._coefficients.size(); ++i)
 	{
 		renderShader.use();
 		renderShader.setVec3(G_SH9_COLOR + "[" + std::to_string(i) + "]", lightingCoefficients[i]);
-		skyboxShader.use();
-		skyboxShader.setVec3(G_SH9_COLOR + "[" + std::to_string(i) + "]", lightingCoefficients[i]);
+		irradianceSkyboxShader.use();
+		irradianceSkyboxShader.setVec3(G_SH9_COLOR + "[" + std::to_string(i) + "]", lightingCoefficients[i]);
 	}
 
 	// Now precompute the first of two prefiltered textures that collectively describe the specular radiance thanks
@@ -241,24 +267,24 @@ int main()
 		renderShader.setInt("gIrradianceMapLightingMode", irradianceMapLightingMode);
 
 		// Bind precomputed IBL data
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, prefilteredEnvMap);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, BRDFIntegrationMap);
+		glState.activeTexture(GL_TEXTURE0);
+		glState.bindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+		glState.activeTexture(GL_TEXTURE1);
+		glState.bindTexture(GL_TEXTURE_CUBE_MAP, prefilteredEnvMap);
+		glState.activeTexture(GL_TEXTURE2);
+		glState.bindTexture(GL_TEXTURE_2D, BRDFIntegrationMap);
 
 		// Render scene
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, ironAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, ironNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, ironMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, ironRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, defaultAOMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, ironAlbedoMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, ironNormalMap);
+		glState.activeTexture(GL_TEXTURE5);
+		glState.bindTexture(GL_TEXTURE_2D, ironMetallicMap);
+		glState.activeTexture(GL_TEXTURE6);
+		glState.bindTexture(GL_TEXTURE_2D, ironRoughnessMap);
+		glState.activeTexture(GL_TEXTURE7);
+		glState.bindTexture(GL_TEXTURE_2D, defaultAOMap);
 
 		glm::mat4 world = glm::mat4(1.0f);
 		world = glm::translate(world, glm::vec3(-5.0, 0.0, 2.0));
@@ -267,16 +293,16 @@ int main()
 		renderShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::mat3(world));
 		utils->renderSphere();
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, goldAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, goldNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, goldMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, goldRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, defaultAOMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, goldAlbedoMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, goldNormalMap);
+		glState.activeTexture(GL_TEXTURE5);
+		glState.bindTexture(GL_TEXTURE_2D, goldMetallicMap);
+		glState.activeTexture(GL_TEXTURE6);
+		glState.bindTexture(GL_TEXTURE_2D, goldRoughnessMap);
+		glState.activeTexture(GL_TEXTURE7);
+		glState.bindTexture(GL_TEXTURE_2D, defaultAOMap);
 
 		world = glm::mat4(1.0f);
 		world = glm::translate(world, glm::vec3(-3.0, 0.0, 2.0));
@@ -285,16 +311,16 @@ int main()
 		renderShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::mat3(world));
 		utils->renderSphere();
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, woodAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, woodNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, woodMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, woodRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, woodAOMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, woodAlbedoMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, woodNormalMap);
+		glState.activeTexture(GL_TEXTURE5);
+		glState.bindTexture(GL_TEXTURE_2D, woodMetallicMap);
+		glState.activeTexture(GL_TEXTURE6);
+		glState.bindTexture(GL_TEXTURE_2D, woodRoughnessMap);
+		glState.activeTexture(GL_TEXTURE7);
+		glState.bindTexture(GL_TEXTURE_2D, woodAOMap);
 
 		world = glm::mat4(1.0f);
 		world = glm::translate(world, glm::vec3(-1.0, 0.0, 2.0));
@@ -303,16 +329,16 @@ int main()
 		renderShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::mat3(world));
 		utils->renderSphere();
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, plasticAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, plasticNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, plasticMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, plasticRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, plasticAOMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, plasticAlbedoMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, plasticNormalMap);
+		glState.activeTexture(GL_TEXTURE5);
+		glState.bindTexture(GL_TEXTURE_2D, plasticMetallicMap);
+		glState.activeTexture(GL_TEXTURE6);
+		glState.bindTexture(GL_TEXTURE_2D, plasticRoughnessMap);
+		glState.activeTexture(GL_TEXTURE7);
+		glState.bindTexture(GL_TEXTURE_2D, plasticAOMap);
 
 		world = glm::mat4(1.0f);
 		world = glm::translate(world, glm::vec3(1.0, 0.0, 2.0));
@@ -321,16 +347,16 @@ int main()
 		renderShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::mat3(world));
 		utils->renderSphere();
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, marbleAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, marbleNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, marbleMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, marbleRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, defaultAOMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, marbleAlbedoMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, marbleNormalMap);
+		glState.activeTexture(GL_TEXTURE5);
+		glState.bindTexture(GL_TEXTURE_2D, marbleMetallicMap);
+		glState.activeTexture(GL_TEXTURE6);
+		glState.bindTexture(GL_TEXTURE_2D, marbleRoughnessMap);
+		glState.activeTexture(GL_TEXTURE7);
+		glState.bindTexture(GL_TEXTURE_2D, defaultAOMap);
 
 		world = glm::mat4(1.0f);
 		world = glm::translate(world, glm::vec3(3.0, 0.0, 2.0));
@@ -339,16 +365,16 @@ int main()
 		renderShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::mat3(world));
 		utils->renderSphere();
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, gunAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, gunNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, gunMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, gunRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, gunAOMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, gunAlbedoMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, gunNormalMap);
+		glState.activeTexture(GL_TEXTURE5);
+		glState.bindTexture(GL_TEXTURE_2D, gunMetallicMap);
+		glState.activeTexture(GL_TEXTURE6);
+		glState.bindTexture(GL_TEXTURE_2D, gunRoughnessMap);
+		glState.activeTexture(GL_TEXTURE7);
+		glState.bindTexture(GL_TEXTURE_2D, gunAOMap);
 
 		world = glm::mat4(1.0f);
 		world = glm::translate(world, glm::vec3(0.0, 0.0, -7.0));
@@ -359,16 +385,16 @@ int main()
 		renderShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::mat3(world));
 		gun.render();
 
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, skullAlbedoMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, skullNormalMap);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, skullMetallicMap);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, skullRoughnessMap);
-		glActiveTexture(GL_TEXTURE7);
-		glBindTexture(GL_TEXTURE_2D, skullAOMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, skullAlbedoMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, skullNormalMap);
+		glState.activeTexture(GL_TEXTURE5);
+		glState.bindTexture(GL_TEXTURE_2D, skullMetallicMap);
+		glState.activeTexture(GL_TEXTURE6);
+		glState.bindTexture(GL_TEXTURE_2D, skullRoughnessMap);
+		glState.activeTexture(GL_TEXTURE7);
+		glState.bindTexture(GL_TEXTURE_2D, skullAOMap);
 
 		world = glm::mat4(1.0f);
 		world = glm::translate(world, glm::vec3(0.0, 0.0, 6.0));
@@ -379,21 +405,21 @@ int main()
 		renderShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::mat3(world));
 		skull.render();
 
+		const phoenix::Shader& skyboxShader = skyboxShaders.get(getSkyboxDefines(renderMode));
 		skyboxShader.use();
 		skyboxShader.setMat4(phoenix::G_VP, utils->_projection * glm::mat4(glm::mat3(utils->_view)));
-		skyboxShader.setInt(phoenix::G_RENDER_MODE, renderMode);
-		glActiveTexture(GL_TEXTURE0);
+		glState.activeTexture(GL_TEXTURE0);
 		if (renderMode == 0)
 		{
-			glBindTexture(GL_TEXTURE_CUBE_MAP, envMap);
+			glState.bindTexture(GL_TEXTURE_CUBE_MAP, envMap);
 		}
 		else if (renderMode == 1)
 		{
-			glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+			glState.bindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
 		}
 		else if (renderMode == 2)
 		{
-			glBindTexture(GL_TEXTURE_CUBE_MAP, prefilteredEnvMap);
+			glState.bindTexture(GL_TEXTURE_CUBE_MAP, prefilteredEnvMap);
 		}
 		utils->renderCube();
 
@@ -470,7 +496,7 @@ void processInput()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -511,7 +537,7 @@ void deletePointers()
 void set2DTexture(unsigned int* textureID)
 {
 	glGenTextures(1, textureID);
-	glBindTexture(GL_TEXTURE_2D, *textureID);
+	glState.bindTexture(GL_TEXTURE_2D, *textureID);
 }
 
 void set2DTextureParams()
@@ -524,14 +550,14 @@ void set2DTextureParams()
 
 void setZBufferMemoryAttachment(int resolution)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, FBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, RBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32, resolution, resolution);
 }
 
 void unbindFBOAndZBufferAttachment()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
 }
 
@@ -547,34 +573,12 @@ void setupFramebuffer()
 	unbindFBOAndZBufferAttachment();
 }
 
-unsigned int loadHDRTexture(char const* filename)
-{
-	unsigned int textureID = -1;
-
-	stbi_set_flip_vertically_on_load(true);
-	int width, height, n;
-	float* data = stbi_loadf(filename, &width, &height, &n, 0);
-	if (data)
-	{
-		set2DTexture(&textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
-		set2DTextureParams();
-	}
-	else
-	{
-		std::cerr << "Failed to load file: " << filename << "\n";
-	}
-	stbi_image_free(data);
-
-	return textureID;
-}
-
 unsigned int generateCubemapTexture(int resolution, bool useMipmap)
 {
 	unsigned int textureID;
 
 	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	glState.bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 	for (size_t i = 0; i < phoenix::NUM_CUBEMAP_FACES; ++i)
 	{
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB32F, resolution, resolution, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -592,14 +596,14 @@ unsigned int generateCubemapTexture(int resolution, bool useMipmap)
 void setInputTexture(const phoenix::Shader& shader, unsigned int texture, bool isCubemap)
 {
 	shader.use();
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(isCubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, texture);
+	glState.activeTexture(GL_TEXTURE0);
+	glState.bindTexture(isCubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, texture);
 }
 
 void renderToCubemap(const phoenix::Shader& shader, unsigned int texture, int resolution, int level)
 {
 	setZBufferMemoryAttachment(resolution);
-	glViewport(0, 0, resolution, resolution);
+	glState.viewport(0, 0, resolution, resolution);
 	for (size_t i = 0; i < phoenix::NUM_CUBEMAP_FACES; ++i)
 	{
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, texture, level);
@@ -608,7 +612,7 @@ void renderToCubemap(const phoenix::Shader& shader, unsigned int texture, int re
 		shader.setMat4(phoenix::G_VP, CUBEMAP_PROJ * CUBEMAP_VIEWS[i]);
 		utils->renderCube();
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 unsigned int integrateBRDF(const phoenix::Shader& shader)
@@ -622,7 +626,7 @@ unsigned int integrateBRDF(const phoenix::Shader& shader)
 	setZBufferMemoryAttachment(RESOLUTION);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureID, 0);
 
-	glViewport(0, 0, RESOLUTION, RESOLUTION);
+	glState.viewport(0, 0, RESOLUTION, RESOLUTION);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	utils->renderQuad(shader);
 
@@ -635,5 +639,11 @@ void resetViewportToFramebufferSize()
 {
 	int width, height;
 	glfwGetFramebufferSize(window, &width, &height);
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
+}
+
+phoenix::Shader::Defines getSkyboxDefines(unsigned int renderMode)
+{
+	// The cubemap views differ only in the texture bound, so they share the default variant
+	return { { "RENDER_MODE", std::to_string(renderMode == 3 ? 3 : 0) } };
 }
\ No newline at end of file
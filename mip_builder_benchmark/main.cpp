@@ -0,0 +1,162 @@
+#include <engine/mip_builder.h>
+#include <engine/gl_state.h>
+#include <engine/stb_image.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Measures building a mip chain with buildMipChain on the CPU against glGenerateMipmap on the same image. The GL
+// side is timed with a GL_TIME_ELAPSED query for the GPU and, on the CPU, from the call until a fence placed behind
+// it has signaled, so driver work deferred past the call is counted too. Color images are given an sRGB format, so
+// that the driver filters them in linear space like buildMipChain does.
+// Usage: mip_builder_benchmark [iterations]
+
+struct Image
+{
+	const char* _filename;
+	phoenix::TextureUsage _usage;
+};
+
+struct Timings
+{
+	double _cpu = 0.0, _glWall = 0.0, _glGPU = 0.0;
+};
+
+const Image IMAGES[] = {
+	{ "../Resources/Textures/shadow_mapping/wood.png", phoenix::USAGE_COLOR },
+	{ "../Resources/Textures/pbr/plastic/scuffed-plastic-alb.png", phoenix::USAGE_COLOR },
+	{ "../Resources/Textures/pbr/gold/gold-scuffed_normal.png", phoenix::USAGE_NORMAL },
+	{ "../Resources/Textures/pbr/rusted_iron/rustediron2_roughness.png", phoenix::USAGE_MASK }
+};
+
+double getMilliseconds(std::chrono::high_resolution_clock::time_point);
+void getFormats(int, phoenix::TextureUsage, GLenum&, GLenum&);
+void generateMipmaps(const unsigned char*, int, int, int, phoenix::TextureUsage, Timings&);
+
+int main(int argc, char** argv)
+{
+	const int iterations = argc > 1 ? std::max(std::stoi(argv[1]), 1) : 10;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Mip Builder Benchmark", nullptr, nullptr);
+	if (window == nullptr)
+	{
+		std::cerr << "Failed to create GLFW window!\n";
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cerr << "Failed to initialize GLAD!\n";
+		return -1;
+	}
+
+	std::cout << iterations << " iterations\n";
+	for (const Image& image : IMAGES)
+	{
+		int width, height, numChannels;
+		unsigned char* data = stbi_load(image._filename, &width, &height, &numChannels, 0);
+		if (!data)
+		{
+			std::cerr << "Failed to load file: " << image._filename << "\n";
+			continue;
+		}
+
+		Timings timings;
+		for (int i = 0; i < iterations; ++i)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			const std::vector<std::vector<unsigned char>> mipmaps = phoenix::buildMipChain(data, width, height, numChannels, image._usage);
+			timings._cpu += getMilliseconds(start);
+
+			generateMipmaps(data, width, height, numChannels, image._usage, timings);
+		}
+		stbi_image_free(data);
+
+		std::cout << image._filename << " (" << width << "x" << height << ", " << numChannels << " channels): buildMipChain " << timings._cpu / iterations
+			<< " ms, glGenerateMipmap " << timings._glWall / iterations << " ms until its fence signaled (" << timings._glGPU / iterations << " ms GPU)\n";
+	}
+
+	glfwTerminate();
+	return 0;
+}
+
+double getMilliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void getFormats(int numChannels, phoenix::TextureUsage usage, GLenum& internalFormat, GLenum& format)
+{
+	const bool srgb = usage == phoenix::USAGE_COLOR;
+	switch (numChannels)
+	{
+	case 1:
+		internalFormat = GL_R8;
+		format = GL_RED;
+		break;
+	case 2:
+		internalFormat = GL_RG8;
+		format = GL_RG;
+		break;
+	case 3:
+		internalFormat = srgb ? GL_SRGB8 : GL_RGB8;
+		format = GL_RGB;
+		break;
+	default:
+		internalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+		format = GL_RGBA;
+		break;
+	}
+}
+
+void generateMipmaps(const unsigned char* data, int width, int height, int numChannels, phoenix::TextureUsage usage, Timings& timings)
+{
+	phoenix::GLState& glState = phoenix::GLState::getInstance();
+	GLenum internalFormat, format;
+	getFormats(numChannels, usage, internalFormat, format);
+	int numLevels = 1;
+	while ((std::max(width, height) >> numLevels) > 0)
+	{
+		++numLevels;
+	}
+
+	unsigned int texture, query;
+	glGenTextures(1, &texture);
+	glGenQueries(1, &query);
+	glState.bindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, numLevels, internalFormat, width, height);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// The upload has to be out of the way, so only the mip generation is timed
+	glFinish();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glEndQuery(GL_TIME_ELAPSED);
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+	timings._glWall += getMilliseconds(start);
+	glDeleteSync(fence);
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+	timings._glGPU += nanoseconds / 1.0e6;
+
+	glDeleteQueries(1, &query);
+	glState.deleteTextures(1, &texture);
+}
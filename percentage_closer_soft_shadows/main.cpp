@@ -4,6 +4,7 @@
 #include <engine/strings.h>
 #include <engine/common.h>
 #include <engine/framebuffer.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <time.h>
@@ -16,6 +17,7 @@ void scrollCallback(GLFWwindow*, double, double);
 void generateRandom3DTexture();
 void execShadowMapPass(const phoenix::Shader&, phoenix::Model&);
 void execRenderPass(const phoenix::Shader&, phoenix::Model&);
+phoenix::Shader::Defines getRenderPassDefines(unsigned int);
 void initPointers();
 void deletePointers();
 
@@ -32,6 +34,8 @@ bool calibratedCursor = false;
 // References to various textures
 unsigned int anglesTexture, normalMap, fluxMap, shadowMap;
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -57,7 +61,7 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
@@ -67,18 +71,28 @@ int main()
 	// Generate volume textures and fill them with the cosines and sines of random rotation angles for PCSS
 	generateRandom3DTexture();
 
-	phoenix::Shader renderPassShader("../Resources/Shaders/shadow_mapping/render_pass.vs", "../Resources/Shaders/shadow_mapping/render_pass.fs");
-	renderPassShader.use();
-	renderPassShader.setInt(phoenix::G_DIFFUSE_TEXTURE, 0);
-	renderPassShader.setInt(phoenix::G_POSITION_MAP, 1);
-	renderPassShader.setInt(phoenix::G_NORMAL_MAP, 2);
-	renderPassShader.setInt(phoenix::G_FLUX_MAP, 3);
-	renderPassShader.setInt(phoenix::G_SHADOW_MAP, 4);
-	renderPassShader.setInt(phoenix::G_ANGLES_TEXTURE, 5);
-	renderPassShader.setFloat(phoenix::G_AMBIENT_FACTOR, phoenix::AMBIENT_FACTOR);
-	renderPassShader.setFloat(phoenix::G_SPECULAR_FACTOR, phoenix::SPECULAR_FACTOR);
-	renderPassShader.setFloat(phoenix::G_CALIBRATED_LIGHT_SIZE, phoenix::CALIBRATED_LIGHT_SIZE);
-	renderPassShader.setVec3(phoenix::G_LIGHT_COLOR, phoenix::LIGHT_COLOR);
+	// The indirect and direct lighting only views are variants of their own, all submitted before any gets set up
+	phoenix::ShaderVariants renderPassShaders("../Resources/Shaders/shadow_mapping/render_pass.vs", "../Resources/Shaders/shadow_mapping/render_pass.fs");
+	const unsigned int RENDER_PASS_MODES[] = { 0, 5, 6 };
+	for (unsigned int renderMode : RENDER_PASS_MODES)
+	{
+		renderPassShaders.get(getRenderPassDefines(renderMode));
+	}
+	for (unsigned int renderMode : RENDER_PASS_MODES)
+	{
+		const phoenix::Shader& renderPassShader = renderPassShaders.get(getRenderPassDefines(renderMode));
+		renderPassShader.use();
+		renderPassShader.setInt(phoenix::G_DIFFUSE_TEXTURE, 0);
+		renderPassShader.setInt(phoenix::G_POSITION_MAP, 1);
+		renderPassShader.setInt(phoenix::G_NORMAL_MAP, 2);
+		renderPassShader.setInt(phoenix::G_FLUX_MAP, 3);
+		renderPassShader.setInt(phoenix::G_SHADOW_MAP, 4);
+		renderPassShader.setInt(phoenix::G_ANGLES_TEXTURE, 5);
+		renderPassShader.setFloat(phoenix::G_AMBIENT_FACTOR, phoenix::AMBIENT_FACTOR);
+		renderPassShader.setFloat(phoenix::G_SPECULAR_FACTOR, phoenix::SPECULAR_FACTOR);
+		renderPassShader.setFloat(phoenix::G_CALIBRATED_LIGHT_SIZE, phoenix::CALIBRATED_LIGHT_SIZE);
+		renderPassShader.setVec3(phoenix::G_LIGHT_COLOR, phoenix::LIGHT_COLOR);
+	}
 	phoenix::Shader shadowMapPassShader("../Resources/Shaders/shadow_mapping/shadow_map_pass.vs", "../Resources/Shaders/shadow_mapping/shadow_map_pass.fs");
 	shadowMapPassShader.setInt(phoenix::G_DIFFUSE_TEXTURE, 0);
 	phoenix::Shader renderQuadShader("../Resources/Shaders/shadow_mapping/render_quad.vs", "../Resources/Shaders/shadow_mapping/render_quad.fs");
@@ -88,12 +102,9 @@ int main()
 
 	phoenix::Model dragon("../Resources/Objects/dragon/dragon.obj");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, renderTargets->_FBO);
-	normalMap = renderTargets->genAttachment(GL_RGB16F, GL_RGB, GL_FLOAT, true);
-	fluxMap = renderTargets->genAttachment(GL_RGB16F, GL_RGB, GL_FLOAT, true);
-	shadowMap = renderTargets->genAttachment(GL_R16F, GL_RED, GL_FLOAT, true);
-	GLenum bufs[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
-	glDrawBuffers(4, bufs);
+	normalMap = renderTargets->getColorTexture(1);
+	fluxMap = renderTargets->getColorTexture(2);
+	shadowMap = renderTargets->getDepthTexture();
 
 	while (!glfwWindowShouldClose(window))
 	{
@@ -112,7 +123,7 @@ int main()
 		// Shadow map pass
 		execShadowMapPass(shadowMapPassShader, dragon);
 
-		glViewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+		glState.viewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// Render pass
@@ -134,7 +145,7 @@ int main()
 		}
 		else
 		{
-			execRenderPass(renderPassShader, dragon);
+			execRenderPass(renderPassShaders.get(getRenderPassDefines(shadowCommon->_renderMode)), dragon);
 			shadowCommon->renderDebugLines(debugLinesShader, utils);
 		}
 
@@ -149,7 +160,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -193,7 +204,7 @@ void generateRandom3DTexture()
 	}
 
 	glGenTextures(1, &anglesTexture);
-	glBindTexture(GL_TEXTURE_3D, anglesTexture);
+	glState.bindTexture(GL_TEXTURE_3D, anglesTexture);
 	glTexImage3D(GL_TEXTURE_3D, 0, GL_RG16F, RESOLUTION, RESOLUTION, RESOLUTION, 0, GL_RG, GL_FLOAT, &randomAngles);
 
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -206,13 +217,13 @@ void generateRandom3DTexture()
 void execShadowMapPass(const phoenix::Shader& shader, phoenix::Model& object)
 {
 	shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
-	glViewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, renderTargets->_FBO);
+	glState.viewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, renderTargets->_FBO);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	shadowCommon->renderScene(utils, shader, object);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	shadowCommon->renderScene(utils, shader, object, phoenix::LOD_SHADOW);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void execRenderPass(const phoenix::Shader& shader, phoenix::Model& object)
@@ -221,16 +232,16 @@ void execRenderPass(const phoenix::Shader& shader, phoenix::Model& object)
 	shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
 
 	shadowCommon->changeColorTexture(shadowCommon->_floorTexture);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, renderTargets->_textureID);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, normalMap);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, fluxMap);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, shadowMap);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_3D, anglesTexture);
+	glState.activeTexture(GL_TEXTURE1);
+	glState.bindTexture(GL_TEXTURE_2D, renderTargets->_textureID);
+	glState.activeTexture(GL_TEXTURE2);
+	glState.bindTexture(GL_TEXTURE_2D, normalMap);
+	glState.activeTexture(GL_TEXTURE3);
+	glState.bindTexture(GL_TEXTURE_2D, fluxMap);
+	glState.activeTexture(GL_TEXTURE4);
+	glState.bindTexture(GL_TEXTURE_2D, shadowMap);
+	glState.activeTexture(GL_TEXTURE5);
+	glState.bindTexture(GL_TEXTURE_3D, anglesTexture);
 
 	shadowCommon->renderScene(utils, shader, object);
 }
@@ -238,7 +249,11 @@ void execRenderPass(const phoenix::Shader& shader, phoenix::Model& object)
 void initPointers()
 {
 	shadowCommon = new phoenix::ShadowCommon();
-	renderTargets = new phoenix::Framebuffer(phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT, true);
+	// Positions, normals and flux of the reflective shadow map, the depth texture is the shadow map itself
+	const phoenix::Framebuffer::Attachment RSM_ATTACHMENT{ GL_RGB16F, true };
+	renderTargets = &phoenix::Framebuffer::acquire({ phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT, { RSM_ATTACHMENT, RSM_ATTACHMENT, RSM_ATTACHMENT },
+		{ GL_DEPTH_COMPONENT24, true } });
+	std::cout << "Shadow map: " << renderTargets->getMemorySize() / (1024.0 * 1024.0) << " MB\n";
 	utils = new phoenix::Utils();
 	camera = new phoenix::Camera();
 }
@@ -247,6 +262,12 @@ void deletePointers()
 {
 	delete camera;
 	delete utils;
-	delete renderTargets;
+	phoenix::Framebuffer::releaseAcquired();
 	delete shadowCommon;
+}
+
+phoenix::Shader::Defines getRenderPassDefines(unsigned int renderMode)
+{
+	// Only the lighting only views change the shader, the other modes are set up on the CPU side
+	return { { "RENDER_MODE", std::to_string(renderMode == 5 || renderMode == 6 ? renderMode : 0) } };
 }
\ No newline at end of file
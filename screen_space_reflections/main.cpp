@@ -4,12 +4,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <engine/camera.h>
-#include <engine/model.h>
+#include <engine/model_loader.h>
+#include <engine/staging_ring.h>
+#include <engine/asset_archive.h>
 #include <engine/common.h>
 #include <engine/strings.h>
 #include <engine/utils.h>
 #include <engine/framebuffer.h>
 #include <engine/light.h>
+#include <engine/uniform_buffer.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <time.h>
@@ -38,6 +42,8 @@ bool calibratedCursor = false;
 
 std::array<phoenix::PointLight, 32> pointLights;
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -63,7 +69,10 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	// Packed by the asset packer, loose files are read as usual without it
+	phoenix::AssetArchive::mount("../Resources/assets.pxpk", "../Resources/");
+
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
@@ -81,9 +90,18 @@ int main()
 		pointLights[i]._attenuation._linear = LINEAR;
 		pointLights[i]._attenuation._quadratic = QUADRATIC;
 	}
+	// The lights never move, so their block is written once
+	std::array<phoenix::PointLight::Block, 32> pointLightBlocks;
+	for (size_t i = 0; i < pointLights.size(); ++i)
+	{
+		pointLightBlocks[i] = pointLights[i].getBlock();
+	}
+	phoenix::UniformBuffer pointLightsBuffer(sizeof(pointLightBlocks));
+	const size_t pointLightsOffset = pointLightsBuffer.push(pointLightBlocks);
+	pointLightsBuffer.upload();
 
 	unsigned int floorDiffuseTexture = phoenix::Utils::loadTexture("../Resources/Textures/ssr/1_col.png");
-	unsigned int floorSpecularTexture = phoenix::Utils::loadTexture("../Resources/Textures/ssr/1_spec.png");
+	unsigned int floorSpecularTexture = phoenix::Utils::loadTexture("../Resources/Textures/ssr/1_spec.png", phoenix::USAGE_MASK);
 
 	phoenix::Shader gBufferPassShader("../Resources/Shaders/screen_space_reflections/g_buffer_pass.vs", "../Resources/Shaders/screen_space_reflections/g_buffer_pass.fs");
 	phoenix::Shader lightingPassShader("../Resources/Shaders/screen_space_reflections/render_quad.vs", "../Resources/Shaders/screen_space_reflections/lighting_pass.fs");
@@ -99,15 +117,14 @@ int main()
 	renderPassShader.setInt(phoenix::G_PREVIOUS_FRAME_MAP, 3);
 	renderPassShader.setInt(phoenix::G_METALLIC_MAP, 4);
 
-	phoenix::Model sponza("../Resources/Objects/sponza/sponza.obj");
+	// Streamed in, the first frames show up before the import is done
+	phoenix::ModelLoader modelLoader;
+	phoenix::Model& sponza = *modelLoader.load("../Resources/Objects/sponza/sponza.obj");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
-	unsigned int normalMap = gBuffer->genAttachment(GL_RGB16F, GL_RGB, GL_FLOAT);
-	unsigned int albedoSpecularMap = gBuffer->genAttachment(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
-	unsigned int previousFrameMap = gBuffer->genAttachment(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
-	unsigned int metallicMap = gBuffer->genAttachment(GL_RED, GL_RED, GL_UNSIGNED_BYTE);
-	GLenum bufs[5] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4 };
-	glDrawBuffers(5, bufs);
+	unsigned int normalMap = gBuffer->getColorTexture(1);
+	unsigned int albedoSpecularMap = gBuffer->getColorTexture(2);
+	unsigned int previousFrameMap = gBuffer->getColorTexture(3);
+	unsigned int metallicMap = gBuffer->getColorTexture(4);
 
 	while (!glfwWindowShouldClose(window))
 	{
@@ -119,10 +136,11 @@ int main()
 		utils->_lastTimestamp = currentFrame;
 
 		utils->processInput(window, camera);
+		modelLoader.update();
 
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
+		glState.bindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		gBufferPassShader.use();
 		gBufferPassShader.setFloat(phoenix::G_METALNESS, 0.0f);
@@ -132,51 +150,51 @@ int main()
 		world = glm::scale(world, glm::vec3(phoenix::OBJECT_SCALE));
 		gBufferPassShader.setMat4(phoenix::G_WORLD_MATRIX, world);
 		gBufferPassShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::transpose(glm::inverse(glm::mat3(world))));
+		// Face culling is off for the two-sided banners and foliage, so only reject meshlets outside the frustum
+		sponza.cull(world, utils->_projection * utils->_view, camera->_position, false);
 		sponza.render(gBufferPassShader);
 		gBufferPassShader.setFloat(phoenix::G_METALNESS, 1.0f);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, floorDiffuseTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, floorSpecularTexture);
+		glState.activeTexture(GL_TEXTURE0);
+		glState.bindTexture(GL_TEXTURE_2D, floorDiffuseTexture);
+		glState.activeTexture(GL_TEXTURE1);
+		glState.bindTexture(GL_TEXTURE_2D, floorSpecularTexture);
 		utils->renderPlane(gBufferPassShader, glm::vec3(0.0f, 0.5f, 0.0f));
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
+		glState.bindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
 		lightingPassShader.use();
 		lightingPassShader.setVec3(phoenix::G_VIEW_POS, camera->_position);
 		lightingPassShader.setMat4(phoenix::G_INVERSE_VIEW_MATRIX, glm::inverse(utils->_view));
-		for (size_t i = 0; i < pointLights.size(); ++i)
-		{
-			pointLights[i].setUniforms(lightingPassShader, i);
-		}
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gBuffer->_textureID);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, normalMap);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, albedoSpecularMap);
+		pointLightsBuffer.bind<decltype(pointLightBlocks)>(phoenix::LIGHT_BLOCK_BINDING, pointLightsOffset);
+		glState.activeTexture(GL_TEXTURE0);
+		glState.bindTexture(GL_TEXTURE_2D, gBuffer->_textureID);
+		glState.activeTexture(GL_TEXTURE1);
+		glState.bindTexture(GL_TEXTURE_2D, normalMap);
+		glState.activeTexture(GL_TEXTURE2);
+		glState.bindTexture(GL_TEXTURE_2D, albedoSpecularMap);
 		utils->renderQuad(lightingPassShader);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		renderPassShader.use();
 		renderPassShader.setMat4(phoenix::G_INVERSE_VIEW_MATRIX, glm::inverse(utils->_view));
 		renderPassShader.setMat4(phoenix::G_PROJECTION_MATRIX, utils->_projection);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gBuffer->_textureID);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, normalMap);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, albedoSpecularMap);
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, previousFrameMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, metallicMap);
+		glState.activeTexture(GL_TEXTURE0);
+		glState.bindTexture(GL_TEXTURE_2D, gBuffer->_textureID);
+		glState.activeTexture(GL_TEXTURE1);
+		glState.bindTexture(GL_TEXTURE_2D, normalMap);
+		glState.activeTexture(GL_TEXTURE2);
+		glState.bindTexture(GL_TEXTURE_2D, albedoSpecularMap);
+		glState.activeTexture(GL_TEXTURE3);
+		glState.bindTexture(GL_TEXTURE_2D, previousFrameMap);
+		glState.activeTexture(GL_TEXTURE4);
+		glState.bindTexture(GL_TEXTURE_2D, metallicMap);
 		utils->renderQuad(renderPassShader);
 
+		phoenix::StagingRing::getInstance().fence();
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
@@ -188,7 +206,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -216,7 +234,8 @@ void scrollCallback(GLFWwindow* window, double xOffset, double yOffset)
 
 void initPointers()
 {
-	gBuffer = new phoenix::Framebuffer(phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+	gBuffer = new phoenix::Framebuffer({ phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT, { { GL_RGB16F }, { GL_RGB16F }, { GL_RGBA8 }, { GL_RGBA8 }, { GL_R8 } },
+		{ GL_DEPTH_COMPONENT24 }, true });
 	utils = new phoenix::Utils();
 	camera = new phoenix::Camera();
 }
@@ -3,7 +3,8 @@
 #include <engine/shadow_common.h>
 #include <engine/strings.h>
 #include <engine/common.h>
-#include <engine/framebuffer.h>
+#include <engine/render_graph.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <time.h>
@@ -13,26 +14,31 @@ void framebufferSizeCallback(GLFWwindow*, int, int);
 void cursorPosCallback(GLFWwindow*, double, double);
 void scrollCallback(GLFWwindow*, double, double);
 
-void generateRandom3DTexture();
-void setInputs(const phoenix::Shader&, bool);
-void execShadowMapPass(const phoenix::Shader&, phoenix::Model&);
-void execTextureSpaceInputsPass(const phoenix::Shader&, phoenix::Model&);
-void execBlurPasses(const phoenix::Shader&, const phoenix::Shader&, const phoenix::Shader&, const phoenix::Shader&);
-void execRenderPass(const phoenix::Shader&, const phoenix::Shader&, phoenix::Model&);
-void initPointers();
-void deletePointers();
-
 const unsigned int NUM_BLUR_PASSES = 5;
 // Parameters for our head model
 const glm::vec3 TRANSLATION = glm::vec3(0.0f, 2.0f, 0.0f), SCALE = glm::vec3(6.5f);
 const float ROTATION = -90.0f;
 
+// Render graph textures of a frame that the render pass reads
+struct Targets
+{
+	phoenix::RenderGraph::Resource _shadowMap, _stretchMap, _irradianceMap;
+	std::array<phoenix::RenderGraph::Resource, NUM_BLUR_PASSES> _blurredIrradianceMaps;
+};
+
+void generateRandom3DTexture();
+void setInputs(const phoenix::Shader&, bool, const phoenix::RenderGraph&, const Targets&);
+void addShadowMapPass(const phoenix::Shader&, phoenix::Model&, Targets&);
+void addTextureSpaceInputsPass(const phoenix::Shader&, phoenix::Model&, Targets&);
+void addBlurPasses(const phoenix::Shader&, const phoenix::Shader&, const phoenix::Shader&, const phoenix::Shader&, Targets&);
+void addRenderPass(const phoenix::Shader&, const phoenix::Shader&, const phoenix::Shader&, const phoenix::Shader&, phoenix::Model&, const Targets&);
+void initPointers();
+void deletePointers();
+phoenix::Shader::Defines getHeadDefines(unsigned int);
+
 phoenix::Camera* camera;
 phoenix::Utils* utils;
-phoenix::Framebuffer* shadowMapRenderTarget;
-phoenix::Framebuffer* textureSpaceInputs;
-std::array<phoenix::Framebuffer*, 5> blurStretchPassesRenderTargets;
-std::array<phoenix::Framebuffer*, 5> blurPassesRenderTargets;
+phoenix::RenderGraph* renderGraph;
 phoenix::ShadowCommon* shadowCommon;
 GLFWwindow* window;
 
@@ -41,9 +47,9 @@ float lastY = static_cast<float>(phoenix::SCREEN_HEIGHT) / 2.0f;
 
 bool calibratedCursor = false;
 
-unsigned int anglesTexture, normalMap, irradianceMap, beckmannTexture, specularTexture;
-std::array<unsigned int, 5> blurredIrradianceMaps;
-std::array<unsigned int, 5> blurredStretchMaps;
+unsigned int anglesTexture, normalMap, beckmannTexture, specularTexture;
+
+phoenix::GLState& glState = phoenix::GLState::getInstance();
 
 int main()
 {
@@ -70,19 +76,45 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
+	// Programs compile on driver threads while the assets below load
+	phoenix::Shader floorShader("../Resources/Shaders/skin/render_pass.vs", "../Resources/Shaders/skin/floor.fs");
+	phoenix::ShaderVariants headShaders("../Resources/Shaders/skin/render_pass.vs", "../Resources/Shaders/skin/head.fs");
+	const unsigned int HEAD_MODES[] = { 0, 7 };
+	for (unsigned int renderMode : HEAD_MODES)
+	{
+		headShaders.get(getHeadDefines(renderMode));
+	}
+	phoenix::Shader shadowMapPassShader("../Resources/Shaders/skin/shadow_map_pass.vs", "../Resources/Shaders/skin/shadow_map_pass.fs");
+	phoenix::Shader textureSpaceInputsPassShader("../Resources/Shaders/skin/texture_space_inputs_pass.vs", "../Resources/Shaders/skin/texture_space_inputs_pass.fs");
+	phoenix::Shader convolveStretchUShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_stretch_u.fs");
+	phoenix::Shader convolveStretchVShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_stretch_v.fs");
+	phoenix::Shader convolveUShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_u.fs");
+	phoenix::Shader convolveVShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_v.fs");
+	phoenix::Shader renderQuadShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/render_quad.fs");
+	phoenix::Shader debugLinesShader("../Resources/Shaders/skin/debug_lines.vs", "../Resources/Shaders/skin/debug_lines.fs");
+
 	shadowCommon->_floorTexture = phoenix::Utils::loadTexture("../Resources/Textures/shadow_mapping/wood.png");
 	shadowCommon->_objectTexture = phoenix::Utils::loadTexture("../Resources/Objects/head/lambertian.jpg");
-	normalMap = phoenix::Utils::loadTexture("../Resources/Objects/head/normal.png");
-	beckmannTexture = phoenix::Utils::loadTexture("../Resources/Textures/skin/beckmannTex.jpg");
-	specularTexture = phoenix::Utils::loadTexture("../Resources/Textures/skin/skin_spec.jpg");
+	normalMap = phoenix::Utils::loadTexture("../Resources/Objects/head/normal.png", phoenix::USAGE_NORMAL);
+	beckmannTexture = phoenix::Utils::loadTexture("../Resources/Textures/skin/beckmannTex.jpg", phoenix::USAGE_DATA);
+	specularTexture = phoenix::Utils::loadTexture("../Resources/Textures/skin/skin_spec.jpg", phoenix::USAGE_MASK);
 	// Generate volume textures and fill them with the cosines and sines of random rotation angles for PCSS
 	generateRandom3DTexture();
 
-	phoenix::Shader floorShader("../Resources/Shaders/skin/render_pass.vs", "../Resources/Shaders/skin/floor.fs");
+	phoenix::Model head("../Resources/Objects/head/head.OBJ");
+
+	// Keep presenting while the driver finishes the programs
+	while (!phoenix::Shader::pollPending())
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
 	floorShader.use();
 	floorShader.setInt(phoenix::G_DIFFUSE_TEXTURE, 0);
 	floorShader.setInt(phoenix::G_SHADOW_MAP, 1);
@@ -91,68 +123,40 @@ int main()
 	floorShader.setFloat(phoenix::G_SPECULAR_FACTOR, phoenix::SPECULAR_FACTOR);
 	floorShader.setFloat(phoenix::G_CALIBRATED_LIGHT_SIZE, phoenix::CALIBRATED_LIGHT_SIZE);
 	floorShader.setVec3(phoenix::G_LIGHT_COLOR, phoenix::LIGHT_COLOR);
-	phoenix::Shader headShader("../Resources/Shaders/skin/render_pass.vs", "../Resources/Shaders/skin/head.fs");
-	headShader.use();
-	headShader.setInt(phoenix::G_DIFFUSE_TEXTURE, 0);
-	headShader.setInt(phoenix::G_SHADOW_MAP, 1); // Translucent shadow map
-	headShader.setInt(phoenix::G_NORMAL_MAP, 3);
-	headShader.setInt("gBeckmannTexture", 4);
-	headShader.setInt(phoenix::G_STRETCH_MAP, 5);
-	headShader.setInt("gSpecularTexture", 6);
-	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
+	for (unsigned int renderMode : HEAD_MODES)
 	{
-		headShader.setInt("gIrradianceMaps[" + std::to_string(i) + "]", i + 7);
+		const phoenix::Shader& headShader = headShaders.get(getHeadDefines(renderMode));
+		headShader.use();
+		headShader.setInt(phoenix::G_DIFFUSE_TEXTURE, 0);
+		headShader.setInt(phoenix::G_SHADOW_MAP, 1); // Translucent shadow map
+		headShader.setInt(phoenix::G_NORMAL_MAP, 3);
+		headShader.setInt("gBeckmannTexture", 4);
+		headShader.setInt(phoenix::G_STRETCH_MAP, 5);
+		headShader.setInt("gSpecularTexture", 6);
+		for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
+		{
+			headShader.setInt("gIrradianceMaps[" + std::to_string(i) + "]", i + 7);
+		}
+		headShader.setFloat(phoenix::G_AMBIENT_FACTOR, 0.4f);
+		headShader.setFloat(phoenix::G_SPECULAR_FACTOR, 5.0f);
+		headShader.setVec3(phoenix::G_LIGHT_COLOR, glm::vec3(1.0f));
 	}
-	headShader.setFloat(phoenix::G_AMBIENT_FACTOR, 0.4f);
-	headShader.setFloat(phoenix::G_SPECULAR_FACTOR, 5.0f);
-	headShader.setVec3(phoenix::G_LIGHT_COLOR, glm::vec3(1.0f));
-	phoenix::Shader shadowMapPassShader("../Resources/Shaders/skin/shadow_map_pass.vs", "../Resources/Shaders/skin/shadow_map_pass.fs");
-	phoenix::Shader textureSpaceInputsPassShader("../Resources/Shaders/skin/texture_space_inputs_pass.vs", "../Resources/Shaders/skin/texture_space_inputs_pass.fs");
 	textureSpaceInputsPassShader.use();
 	textureSpaceInputsPassShader.setInt(phoenix::G_DIFFUSE_TEXTURE, 0);
-	phoenix::Shader convolveStretchUShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_stretch_u.fs");
 	convolveStretchUShader.use();
 	convolveStretchUShader.setInt(phoenix::G_STRETCH_MAP, 0);
-	phoenix::Shader convolveStretchVShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_stretch_v.fs");
 	convolveStretchVShader.use();
 	convolveStretchVShader.setInt(phoenix::G_STRETCH_MAP, 0);
-	phoenix::Shader convolveUShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_u.fs");
 	convolveUShader.use();
 	convolveUShader.setInt(phoenix::G_IRRADIANCE_MAP, 0);
 	convolveUShader.setInt(phoenix::G_STRETCH_MAP, 1);
-	phoenix::Shader convolveVShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/convolve_v.fs");
 	convolveVShader.use();
 	convolveVShader.setInt(phoenix::G_IRRADIANCE_MAP, 0);
 	convolveVShader.setInt(phoenix::G_STRETCH_MAP, 1);
-	phoenix::Shader renderQuadShader("../Resources/Shaders/skin/render_quad.vs", "../Resources/Shaders/skin/render_quad.fs");
 	renderQuadShader.use();
 	renderQuadShader.setInt(phoenix::G_RENDER_TARGET, 0);
-	phoenix::Shader debugLinesShader("../Resources/Shaders/skin/debug_lines.vs", "../Resources/Shaders/skin/debug_lines.fs");
-
-	phoenix::Model head("../Resources/Objects/head/head.OBJ");
-
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapRenderTarget->_FBO);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, textureSpaceInputs->_FBO);
-	irradianceMap = textureSpaceInputs->genAttachment(GL_RGBA32F, GL_RGBA, GL_FLOAT);
-	GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-	glDrawBuffers(2, bufs);
-
-	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, blurStretchPassesRenderTargets[i]->_FBO);
-		blurredStretchMaps[i] = blurStretchPassesRenderTargets[i]->genAttachment(GL_RGBA32F, GL_RGBA, GL_FLOAT);
-		glDrawBuffers(2, bufs);
-	}
-
-	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, blurPassesRenderTargets[i]->_FBO);
-		blurredIrradianceMaps[i] = blurPassesRenderTargets[i]->genAttachment(GL_RGBA32F, GL_RGBA, GL_FLOAT);
-		glDrawBuffers(2, bufs);
-	}
 
+	int lastRenderMode = -1;
 	while (!glfwWindowShouldClose(window))
 	{
 		utils->_projection = glm::perspective(glm::radians(camera->_FOV), static_cast<float>(phoenix::SCREEN_WIDTH) / phoenix::SCREEN_HEIGHT, phoenix::PERSPECTIVE_NEAR_PLANE, phoenix::PERSPECTIVE_FAR_PLANE);
@@ -165,45 +169,21 @@ int main()
 		shadowCommon->processInput(window, camera, true);
 
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		execShadowMapPass(shadowMapPassShader, head);
-		execTextureSpaceInputsPass(textureSpaceInputsPassShader, head);
-		execBlurPasses(convolveStretchUShader, convolveStretchVShader, convolveUShader, convolveVShader);
-
-		glViewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Render pass
-		if (shadowCommon->_renderMode == 1)
-		{
-			utils->renderQuad(renderQuadShader, irradianceMap);
-		}
-		else if (shadowCommon->_renderMode == 2)
-		{
-			utils->renderQuad(renderQuadShader, blurredIrradianceMaps[0]);
-		}
-		else if (shadowCommon->_renderMode == 3)
-		{
-			utils->renderQuad(renderQuadShader, blurredIrradianceMaps[1]);
-		}
-		else if (shadowCommon->_renderMode == 4)
-		{
-			utils->renderQuad(renderQuadShader, blurredIrradianceMaps[2]);
-		}
-		else if (shadowCommon->_renderMode == 5)
-		{
-			utils->renderQuad(renderQuadShader, blurredIrradianceMaps[3]);
-		}
-		else if (shadowCommon->_renderMode == 6)
+		// The passes are declared anew every frame, only those the render mode depends on run
+		Targets targets;
+		addShadowMapPass(shadowMapPassShader, head, targets);
+		addTextureSpaceInputsPass(textureSpaceInputsPassShader, head, targets);
+		addBlurPasses(convolveStretchUShader, convolveStretchVShader, convolveUShader, convolveVShader, targets);
+		addRenderPass(floorShader, headShaders.get(getHeadDefines(shadowCommon->_renderMode)), renderQuadShader, debugLinesShader, head, targets);
+		renderGraph->compile();
+		if (static_cast<int>(shadowCommon->_renderMode) != lastRenderMode)
 		{
-			utils->renderQuad(renderQuadShader, blurredIrradianceMaps[4]);
-		}
-		else
-		{
-			execRenderPass(floorShader, headShader, head);
-			shadowCommon->renderDebugLines(debugLinesShader, utils);
+			renderGraph->printStats();
+			lastRenderMode = static_cast<int>(shadowCommon->_renderMode);
 		}
+		renderGraph->execute();
+		renderGraph->reset();
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
@@ -216,7 +196,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -260,7 +240,7 @@ void generateRandom3DTexture()
 	}
 
 	glGenTextures(1, &anglesTexture);
-	glBindTexture(GL_TEXTURE_3D, anglesTexture);
+	glState.bindTexture(GL_TEXTURE_3D, anglesTexture);
 	glTexImage3D(GL_TEXTURE_3D, 0, GL_RG16F, RESOLUTION, RESOLUTION, RESOLUTION, 0, GL_RG, GL_FLOAT, &randomAngles);
 
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -270,122 +250,147 @@ void generateRandom3DTexture()
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 }
 
-void setInputs(const phoenix::Shader& shader, bool useObjTexture)
+void setInputs(const phoenix::Shader& shader, bool useObjTexture, const phoenix::RenderGraph& graph, const Targets& targets)
 {
 	shadowCommon->setUniforms(shader, camera);
 	shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
 
 	shadowCommon->changeColorTexture(useObjTexture ? shadowCommon->_objectTexture : shadowCommon->_floorTexture);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, shadowMapRenderTarget->_textureID);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_3D, anglesTexture);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, normalMap);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, beckmannTexture);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, textureSpaceInputs->_textureID);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, specularTexture);
+	glState.activeTexture(GL_TEXTURE1);
+	glState.bindTexture(GL_TEXTURE_2D, graph.getTexture(targets._shadowMap));
+	glState.activeTexture(GL_TEXTURE2);
+	glState.bindTexture(GL_TEXTURE_3D, anglesTexture);
+	glState.activeTexture(GL_TEXTURE3);
+	glState.bindTexture(GL_TEXTURE_2D, normalMap);
+	glState.activeTexture(GL_TEXTURE4);
+	glState.bindTexture(GL_TEXTURE_2D, beckmannTexture);
+	glState.activeTexture(GL_TEXTURE5);
+	glState.bindTexture(GL_TEXTURE_2D, graph.getTexture(targets._stretchMap));
+	glState.activeTexture(GL_TEXTURE6);
+	glState.bindTexture(GL_TEXTURE_2D, specularTexture);
 	for (size_t i = 0; i <= NUM_BLUR_PASSES; ++i)
 	{
-		glActiveTexture(GL_TEXTURE7 + i);
+		glState.activeTexture(GL_TEXTURE7 + i);
 		if (i > 0)
 		{
-			glBindTexture(GL_TEXTURE_2D, blurredIrradianceMaps[i - 1]);
+			glState.bindTexture(GL_TEXTURE_2D, graph.getTexture(targets._blurredIrradianceMaps[i - 1]));
 		}
 		else
 		{
-			glBindTexture(GL_TEXTURE_2D, irradianceMap);
+			glState.bindTexture(GL_TEXTURE_2D, graph.getTexture(targets._irradianceMap));
 		}
 	}
 }
 
-void execShadowMapPass(const phoenix::Shader& shader, phoenix::Model& object)
+void addShadowMapPass(const phoenix::Shader& shader, phoenix::Model& object, Targets& targets)
 {
-	shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
-	glViewport(0, 0, phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapRenderTarget->_FBO);
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	targets._shadowMap = renderGraph->createTexture("shadow map", { phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, GL_RGB16F, true });
+	const phoenix::RenderGraph::Resource depth = renderGraph->createTexture("shadow map depth", { phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, GL_DEPTH_COMPONENT24, false });
+	renderGraph->addPass("shadow map", {}, { targets._shadowMap, depth }, [&shader, &object](const phoenix::RenderGraph&)
+	{
+		shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	utils->renderPlane(shader);
-	shadowCommon->renderObject(utils, shader, object, TRANSLATION, ROTATION, SCALE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		utils->renderPlane(shader);
+		shadowCommon->renderObject(utils, shader, object, TRANSLATION, ROTATION, SCALE, phoenix::LOD_SHADOW);
+	});
 }
 
-void execTextureSpaceInputsPass(const phoenix::Shader& shader, phoenix::Model& object)
+void addTextureSpaceInputsPass(const phoenix::Shader& shader, phoenix::Model& object, Targets& targets)
 {
-	glViewport(0, 0, phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, textureSpaceInputs->_FBO);
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	const phoenix::RenderGraph::TextureDesc target{ phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, GL_RGBA32F, false };
+	targets._stretchMap = renderGraph->createTexture("stretch map", target);
+	targets._irradianceMap = renderGraph->createTexture("irradiance map", target);
+	const phoenix::RenderGraph::Resource depth = renderGraph->createTexture("texture space depth", { phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, GL_DEPTH_COMPONENT24, false });
+	renderGraph->addPass("texture space inputs", {}, { targets._stretchMap, targets._irradianceMap, depth }, [&shader, &object](const phoenix::RenderGraph&)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	shadowCommon->changeColorTexture(shadowCommon->_objectTexture);
-	shadowCommon->renderObject(utils, shader, object, TRANSLATION, ROTATION, SCALE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		shadowCommon->changeColorTexture(shadowCommon->_objectTexture);
+		shadowCommon->renderObject(utils, shader, object, TRANSLATION, ROTATION, SCALE);
+	});
 }
 
-void execBlurPasses(const phoenix::Shader& convolveStretchUShader, const phoenix::Shader& convolveStretchVShader, const phoenix::Shader& convolveUShader, const phoenix::Shader& convolveVShader)
+void addBlurPasses(const phoenix::Shader& convolveStretchUShader, const phoenix::Shader& convolveStretchVShader, const phoenix::Shader& convolveUShader, const phoenix::Shader& convolveVShader,
+	Targets& targets)
 {
-	glViewport(0, 0, phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT);
+	// Every step blurs the stretch map and the irradiance of the step before, each direction into a target of its
+	// own. Only the blurred irradiance outlives the chain, the rest shares memory with the steps that follow.
+	// The quads cover every texel, so nothing is cleared.
+	const phoenix::RenderGraph::TextureDesc target{ phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, GL_RGBA32F, false };
+	phoenix::RenderGraph::Resource stretchMap = targets._stretchMap, irradianceMap = targets._irradianceMap;
 	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, blurStretchPassesRenderTargets[i]->_FBO);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		convolveStretchUShader.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, i > 0 ? blurredStretchMaps[i - 1] : textureSpaceInputs->_textureID);
-		utils->renderQuad(convolveStretchUShader);
-
-		convolveStretchVShader.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, blurStretchPassesRenderTargets[i]->_textureID);
-		utils->renderQuad(convolveStretchVShader);
+		const std::string index = std::to_string(i);
+		const phoenix::RenderGraph::Resource stretchU = renderGraph->createTexture("stretch map u " + index, target);
+		const phoenix::RenderGraph::Resource blurredStretchMap = renderGraph->createTexture("blurred stretch map " + index, target);
+		const phoenix::RenderGraph::Resource irradianceU = renderGraph->createTexture("irradiance map u " + index, target);
+		const phoenix::RenderGraph::Resource blurredIrradianceMap = renderGraph->createTexture("blurred irradiance map " + index, target);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, blurPassesRenderTargets[i]->_FBO);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		renderGraph->addPass("convolve stretch u " + index, { stretchMap }, { stretchU }, [&convolveStretchUShader, stretchMap](const phoenix::RenderGraph& graph)
+		{
+			utils->renderQuad(convolveStretchUShader, graph.getTexture(stretchMap));
+		});
+		renderGraph->addPass("convolve stretch v " + index, { stretchU }, { blurredStretchMap }, [&convolveStretchVShader, stretchU](const phoenix::RenderGraph& graph)
+		{
+			utils->renderQuad(convolveStretchVShader, graph.getTexture(stretchU));
+		});
+		renderGraph->addPass("convolve u " + index, { irradianceMap, blurredStretchMap }, { irradianceU },
+			[&convolveUShader, irradianceMap, blurredStretchMap](const phoenix::RenderGraph& graph)
+		{
+			glState.activeTexture(GL_TEXTURE1);
+			glState.bindTexture(GL_TEXTURE_2D, graph.getTexture(blurredStretchMap));
+			utils->renderQuad(convolveUShader, graph.getTexture(irradianceMap));
+		});
+		renderGraph->addPass("convolve v " + index, { irradianceU, blurredStretchMap }, { blurredIrradianceMap },
+			[&convolveVShader, irradianceU, blurredStretchMap](const phoenix::RenderGraph& graph)
+		{
+			glState.activeTexture(GL_TEXTURE1);
+			glState.bindTexture(GL_TEXTURE_2D, graph.getTexture(blurredStretchMap));
+			utils->renderQuad(convolveVShader, graph.getTexture(irradianceU));
+		});
 
-		convolveUShader.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, i > 0 ? blurredIrradianceMaps[i - 1] : irradianceMap);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, blurredStretchMaps[i]);
-		utils->renderQuad(convolveUShader);
-
-		convolveVShader.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, blurPassesRenderTargets[i]->_textureID);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, blurredStretchMaps[i]);
-		utils->renderQuad(convolveVShader);
+		stretchMap = blurredStretchMap;
+		irradianceMap = targets._blurredIrradianceMaps[i] = blurredIrradianceMap;
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void execRenderPass(const phoenix::Shader& floorShader, const phoenix::Shader& headShader, phoenix::Model& object)
+void addRenderPass(const phoenix::Shader& floorShader, const phoenix::Shader& headShader, const phoenix::Shader& renderQuadShader, const phoenix::Shader& debugLinesShader,
+	phoenix::Model& object, const Targets& targets)
 {
-	setInputs(floorShader, false);
-	utils->renderPlane(floorShader);
-	setInputs(headShader, true);
-	shadowCommon->renderObject(utils, headShader, object, TRANSLATION, ROTATION, SCALE);
+	// Modes 1 to 6 show the irradiance at a single step, which culls every pass it doesn't depend on
+	const unsigned int renderMode = shadowCommon->_renderMode;
+	if (renderMode >= 1 && renderMode <= NUM_BLUR_PASSES + 1)
+	{
+		const phoenix::RenderGraph::Resource irradianceMap = renderMode == 1 ? targets._irradianceMap : targets._blurredIrradianceMaps[renderMode - 2];
+		renderGraph->addPass("irradiance view", { irradianceMap }, {}, [&renderQuadShader, irradianceMap](const phoenix::RenderGraph& graph)
+		{
+			glState.viewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			utils->renderQuad(renderQuadShader, graph.getTexture(irradianceMap));
+		});
+		return;
+	}
+
+	std::vector<phoenix::RenderGraph::Resource> reads{ targets._shadowMap, targets._stretchMap, targets._irradianceMap };
+	reads.insert(reads.end(), targets._blurredIrradianceMaps.begin(), targets._blurredIrradianceMaps.end());
+	renderGraph->addPass("render", reads, {}, [&floorShader, &headShader, &debugLinesShader, &object, targets](const phoenix::RenderGraph& graph)
+	{
+		glState.viewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		setInputs(floorShader, false, graph, targets);
+		utils->renderPlane(floorShader);
+		setInputs(headShader, true, graph, targets);
+		shadowCommon->renderObject(utils, headShader, object, TRANSLATION, ROTATION, SCALE);
+		shadowCommon->renderDebugLines(debugLinesShader, utils);
+	});
 }
 
 void initPointers()
 {
 	shadowCommon = new phoenix::ShadowCommon();
-	shadowMapRenderTarget = new phoenix::Framebuffer(phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, true);
-	textureSpaceInputs = new phoenix::Framebuffer(phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, false, true);
-	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
-	{
-		blurStretchPassesRenderTargets[i] = new phoenix::Framebuffer(phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, false, true);
-	}
-	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
-	{
-		blurPassesRenderTargets[i] = new phoenix::Framebuffer(phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, false, true);
-	}
+	renderGraph = new phoenix::RenderGraph();
 	utils = new phoenix::Utils();
 	camera = new phoenix::Camera();
 }
@@ -394,15 +399,12 @@ void deletePointers()
 {
 	delete camera;
 	delete utils;
-	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
-	{
-		delete blurPassesRenderTargets[i];
-	}
-	for (size_t i = 0; i < NUM_BLUR_PASSES; ++i)
-	{
-		delete blurStretchPassesRenderTargets[i];
-	}
-	delete textureSpaceInputs;
-	delete shadowMapRenderTarget;
+	delete renderGraph;
 	delete shadowCommon;
+}
+
+phoenix::Shader::Defines getHeadDefines(unsigned int renderMode)
+{
+	// The irradiance views don't draw the head, so only the Blinn-Phong view needs a variant of its own
+	return { { "RENDER_MODE", std::to_string(renderMode == 7 ? 7 : 0) } };
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <engine/model.h>
+#include <engine/model_loader.h>
 #include <engine/common.h>
 #include <engine/strings.h>
 #include <engine/utils.h>
 #include <engine/framebuffer.h>
+#include <engine/render_stats.h>
+#include <engine/staging_ring.h>
+#include <engine/texture_streamer.h>
+#include <engine/asset_archive.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <time.h>
@@ -40,6 +45,8 @@ bool calibratedCursor = false;
 std::array<PointLight*, 4096> pointLights;
 unsigned int lightsBuffer, output;
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -65,14 +72,18 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	// Packed by the asset packer, loose files are read as usual without it
+	phoenix::AssetArchive::mount("../Resources/assets.pxpk", "../Resources/");
+
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
 	copyLightDataToGPU();
 
 	phoenix::Shader gBufferPassShader("../Resources/Shaders/tiled_deferred_shading/g_buffer_pass.vs", "../Resources/Shaders/tiled_deferred_shading/g_buffer_pass.fs");
-	phoenix::Shader cullLightsShader("../Resources/Shaders/tiled_deferred_shading/cull_lights.comp");
+	phoenix::Shader cullLightsShader("../Resources/Shaders/tiled_deferred_shading/cull_lights.comp", { { "NUM_LIGHTS", std::to_string(pointLights.size()) },
+		{ "SCREEN_WIDTH", std::to_string(static_cast<float>(phoenix::SCREEN_WIDTH)) }, { "SCREEN_HEIGHT", std::to_string(static_cast<float>(phoenix::SCREEN_HEIGHT)) } });
 	cullLightsShader.use();
 	cullLightsShader.setInt(phoenix::G_NORMAL_MAP, 0);
 	cullLightsShader.setInt(phoenix::G_ALBEDO_SPECULAR_MAP, 1);
@@ -81,12 +92,18 @@ int main()
 	renderPassShader.use();
 	renderPassShader.setInt(phoenix::G_OUTPUT, 0);
 
-	phoenix::Model sponza("../Resources/Objects/sponza/sponza.obj");
+	// Streamed in, the first frames show up before the import is done. Its textures only keep the mip levels the
+	// feedback pass asks for resident, within a fixed budget.
+	phoenix::TextureStreamer& textureStreamer = phoenix::TextureStreamer::getInstance();
+	textureStreamer.setBudget(phoenix::TEXTURE_STREAMING_BUDGET);
+	phoenix::ModelLoader modelLoader;
+	phoenix::Model& sponza = *modelLoader.load("../Resources/Objects/sponza/sponza.obj");
+	// M switches between per-mesh and multi-draw submission, printing the counters of the frame before, the arena usage
+	// and texture residency
+	phoenix::SubmissionMode submissionMode = phoenix::MULTI_DRAW_INDIRECT;
+	bool toggleHeld = false;
 
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
-	unsigned int albedoSpecularMap = gBuffer->genAttachment(GL_RGBA32F, GL_RGBA, GL_FLOAT);
-	GLenum bufs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-	glDrawBuffers(2, bufs);
+	unsigned int albedoSpecularMap = gBuffer->getColorTexture(1);
 
 	genOutputTexture();
 
@@ -100,19 +117,38 @@ int main()
 		utils->_lastTimestamp = currentFrame;
 
 		utils->processInput(window, camera);
+		modelLoader.update();
+		textureStreamer.update();
+		const bool togglePressed = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+		if (togglePressed && !toggleHeld)
+		{
+			phoenix::RenderStats::getInstance().print();
+			phoenix::GeometryArena::getInstance(phoenix::UNPACKED).printStats();
+			textureStreamer.printStats();
+			submissionMode = submissionMode == phoenix::DIRECT ? phoenix::MULTI_DRAW_INDIRECT : phoenix::DIRECT;
+		}
+		toggleHeld = togglePressed;
+		phoenix::RenderStats::getInstance().reset();
 
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
+		glState.bindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		gBufferPassShader.use();
 		glm::mat4 world = glm::mat4(1.0f);
 		world = glm::scale(world, glm::vec3(phoenix::OBJECT_SCALE));
 		gBufferPassShader.setMat4(phoenix::G_WVP, utils->_projection * utils->_view * world);
 		gBufferPassShader.setMat3(phoenix::G_NORMAL_MATRIX, glm::transpose(glm::inverse(glm::mat3(world))));
-		sponza.render(gBufferPassShader);
+		// Face culling is off for the two-sided banners and foliage, so only reject meshlets outside the frustum
+		sponza.cull(world, utils->_projection * utils->_view, camera->_position, false);
+		sponza.render(gBufferPassShader, submissionMode);
+
+		const phoenix::Shader& feedbackShader = textureStreamer.beginFeedback(phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+		feedbackShader.setMat4(phoenix::G_WVP, utils->_projection * utils->_view * world);
+		textureStreamer.renderFeedback(sponza);
+		textureStreamer.endFeedback();
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		cullLightsShader.use();
@@ -127,10 +163,11 @@ int main()
 		glDispatchCompute(160, 90, 1);
 
 		renderPassShader.use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, output);
+		glState.activeTexture(GL_TEXTURE0);
+		glState.bindTexture(GL_TEXTURE_2D, output);
 		utils->renderQuad(renderPassShader);
 
+		phoenix::StagingRing::getInstance().fence();
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
@@ -142,7 +179,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -184,7 +221,7 @@ void initPointers()
 		float z = (rand() % 100) / 100.0f * 52.0f - 26.0f;
 		pointLights[i]->_position = glm::vec3(x, y, z);
 	}
-	gBuffer = new phoenix::Framebuffer(phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT, false, true);
+	gBuffer = new phoenix::Framebuffer({ phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT, { { GL_RGBA32F }, { GL_RGBA32F } }, { GL_DEPTH_COMPONENT24 }, true });
 	utils = new phoenix::Utils();
 	camera = new phoenix::Camera();
 }
@@ -217,22 +254,22 @@ void copyLightDataToGPU()
 	glGenBuffers(1, &lightsBuffer);
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightsBuffer);
 	glBufferData(GL_SHADER_STORAGE_BUFFER, pointLights.size() * sizeof(PointLight), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-	glBindBuffer(GL_ARRAY_BUFFER, lightsBuffer);
-	PointLight* ptr = reinterpret_cast<PointLight*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, pointLights.size() * sizeof(PointLight), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	std::vector<PointLight> lights(pointLights.size());
 	for (int i = 0; i < pointLights.size(); ++i)
 	{
-		ptr[i]._color = pointLights[i]->_color;
-		ptr[i]._radius = pointLights[i]->_radius;
-		ptr[i]._position = pointLights[i]->_position;
+		lights[i]._color = pointLights[i]->_color;
+		lights[i]._radius = pointLights[i]->_radius;
+		lights[i]._position = pointLights[i]->_position;
 	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
+	phoenix::StagingRing::getInstance().upload(lightsBuffer, 0, lights.data(), lights.size() * sizeof(PointLight));
 }
 
 void genOutputTexture()
 {
 	glGenTextures(1, &output);
-	glBindTexture(GL_TEXTURE_2D, output);
+	glState.bindTexture(GL_TEXTURE_2D, output);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, nullptr);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -3,6 +3,7 @@
 #include <engine/shadow_common.h>
 #include <engine/strings.h>
 #include <engine/common.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <iostream>
@@ -33,6 +34,8 @@ bool calibratedCursor = false;
 unsigned int FBO;
 std::array<unsigned int, 2> shadowMaps;
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -58,7 +61,7 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
@@ -105,7 +108,7 @@ int main()
 		// Shadow map pass
 		execShadowMapPass(shadowMapPassShader, blurShader, dragon);
 
-		glViewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+		glState.viewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// Render pass
@@ -130,7 +133,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -161,7 +164,7 @@ void setupRenderToTexture()
 	glGenTextures(shadowMaps.size(), &shadowMaps[0]);
 	for (size_t i = 0; i < shadowMaps.size(); ++i)
 	{
-		glBindTexture(GL_TEXTURE_2D, shadowMaps[i]);
+		glState.bindTexture(GL_TEXTURE_2D, shadowMaps[i]);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT, 0, GL_RGBA, GL_FLOAT, nullptr);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -173,20 +176,20 @@ void setupRenderToTexture()
 
 	// Attach the render target to the FBO so we can write to it
 	glGenFramebuffers(1, &FBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, FBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, shadowMaps[0], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, shadowMaps[1], 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void execShadowMapPass(const phoenix::Shader& shadowMapPassShader, const phoenix::Shader& blurShader, phoenix::Model& object)
 {
 	shadowCommon->setLightSpaceVP(shadowMapPassShader, shadowCommon->_lightPos, phoenix::TARGET);
-	glViewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glState.viewport(0, 0, phoenix::SHADOW_MAP_WIDTH, phoenix::SHADOW_MAP_HEIGHT);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, FBO);
 
 	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-	shadowCommon->renderScene(utils, shadowMapPassShader, object);
+	shadowCommon->renderScene(utils, shadowMapPassShader, object, phoenix::LOD_SHADOW);
 
 	blurShader.use();
 
@@ -198,7 +201,7 @@ void execShadowMapPass(const phoenix::Shader& shadowMapPassShader, const phoenix
 	blurShader.setVec2(phoenix::G_DIR, glm::vec2(0.0f, 1.0f));
 	utils->renderQuad(blurShader, shadowMaps[1]);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void execRenderPass(const phoenix::Shader& shader, phoenix::Model& object)
@@ -207,8 +210,8 @@ void execRenderPass(const phoenix::Shader& shader, phoenix::Model& object)
 	shadowCommon->setLightSpaceVP(shader, shadowCommon->_lightPos, phoenix::TARGET);
 
 	shadowCommon->changeColorTexture(shadowCommon->_floorTexture);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, shadowMaps[0]);
+	glState.activeTexture(GL_TEXTURE1);
+	glState.bindTexture(GL_TEXTURE_2D, shadowMaps[0]);
 
 	shadowCommon->renderScene(utils, shader, object);
 }
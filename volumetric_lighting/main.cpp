@@ -5,6 +5,7 @@
 #include <engine/framebuffer.h>
 #include <engine/light.h>
 #include <engine/shadow_common.h>
+#include <engine/gl_state.h>
 
 #include <array>
 #include <iostream>
@@ -38,6 +39,8 @@ bool calibratedCursor = false;
 unsigned int normalMap, albedoSpecularMap, previousFrameMap;
 phoenix::DirectLight directLight;
 
+phoenix::GLState& glState = phoenix::GLState::getInstance();
+
 int main()
 {
 	glfwInit();
@@ -63,7 +66,7 @@ int main()
 		return -1;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	glState.enable(GL_DEPTH_TEST);
 
 	initPointers();
 
@@ -87,18 +90,9 @@ int main()
 
 	phoenix::Model sponza("../Resources/Objects/sponza/sponza.obj");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapRenderTarget->_FBO);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
-	normalMap = gBuffer->genAttachment(GL_RGB16F, GL_RGB, GL_FLOAT);
-	albedoSpecularMap = gBuffer->genAttachment(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
-	previousFrameMap = gBuffer->genAttachment(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
-	GLenum bufs[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
-	glDrawBuffers(4, bufs);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, blurRenderTarget->_FBO);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	normalMap = gBuffer->getColorTexture(1);
+	albedoSpecularMap = gBuffer->getColorTexture(2);
+	previousFrameMap = gBuffer->getColorTexture(3);
 
 	while (!glfwWindowShouldClose(window))
 	{
@@ -115,7 +109,7 @@ int main()
 
 		execShadowMapPass(shadowMapPassShader, sponza);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		if (shadowCommon->_renderMode == 1)
@@ -140,7 +134,7 @@ int main()
 
 void framebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
-	glViewport(0, 0, width, height);
+	glState.viewport(0, 0, width, height);
 }
 
 void cursorPosCallback(GLFWwindow* window, double x, double y)
@@ -250,21 +244,21 @@ void renderObject(const phoenix::Shader& shader, phoenix::Model& object)
 
 void execShadowMapPass(const phoenix::Shader& shader, phoenix::Model& object)
 {
-	glViewport(0, 0, phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapRenderTarget->_FBO);
+	glState.viewport(0, 0, phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, shadowMapRenderTarget->_FBO);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	setLightSpaceVP(shader);
 	renderObject(shader, object);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.viewport(0, 0, phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
 }
 
 void execGeometryPass(const phoenix::Shader& shader, phoenix::Model& object)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -272,39 +266,39 @@ void execGeometryPass(const phoenix::Shader& shader, phoenix::Model& object)
 	shader.setMat4(phoenix::G_VP, utils->_projection * utils->_view);
 	renderObject(shader, object);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void execLightingPass(const phoenix::Shader& shader)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, gBuffer->_FBO);
 
 	setLightSpaceVP(shader);
 	shader.setVec3(phoenix::G_VIEW_POS, camera->_position);
 	directLight.setUniforms(shader);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, gBuffer->_textureID);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, normalMap);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, albedoSpecularMap);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, shadowMapRenderTarget->_textureID);
+	glState.activeTexture(GL_TEXTURE0);
+	glState.bindTexture(GL_TEXTURE_2D, gBuffer->_textureID);
+	glState.activeTexture(GL_TEXTURE1);
+	glState.bindTexture(GL_TEXTURE_2D, normalMap);
+	glState.activeTexture(GL_TEXTURE2);
+	glState.bindTexture(GL_TEXTURE_2D, albedoSpecularMap);
+	glState.activeTexture(GL_TEXTURE3);
+	glState.bindTexture(GL_TEXTURE_2D, shadowMapRenderTarget->_textureID);
 	utils->renderQuad(shader);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void execBlurPasses(const phoenix::Shader& blurShader)
 {
 	blurShader.use();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, blurRenderTarget->_FBO);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, blurRenderTarget->_FBO);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	blurShader.setVec2(phoenix::G_DIR, glm::vec2(1.0f, 0.0f));
 	utils->renderQuad(blurShader, previousFrameMap);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 	blurShader.setVec2(phoenix::G_DIR, glm::vec2(0.0f, 1.0f));
 	utils->renderQuad(blurShader, blurRenderTarget->_textureID);
 }
@@ -312,9 +306,12 @@ void execBlurPasses(const phoenix::Shader& blurShader)
 void initPointers()
 {
 	shadowCommon = new phoenix::ShadowCommon();
-	blurRenderTarget = new phoenix::Framebuffer(phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
-	gBuffer = new phoenix::Framebuffer(phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT);
-	shadowMapRenderTarget = new phoenix::Framebuffer(phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, true);
+	blurRenderTarget = new phoenix::Framebuffer({ phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT, { { GL_RGB16F } } });
+	gBuffer = new phoenix::Framebuffer({ phoenix::SCREEN_WIDTH, phoenix::SCREEN_HEIGHT, { { GL_RGB16F }, { GL_RGB16F }, { GL_RGBA8 }, { GL_RGBA8 } },
+		{ GL_DEPTH_COMPONENT24 }, true });
+	// Depth alone, the shadow map pass writes no color
+	shadowMapRenderTarget = &phoenix::Framebuffer::acquire({ phoenix::HIGH_RES_WIDTH, phoenix::HIGH_RES_HEIGHT, {}, { GL_DEPTH_COMPONENT24, true } });
+	std::cout << "Shadow map: " << shadowMapRenderTarget->getMemorySize() / (1024.0 * 1024.0) << " MB\n";
 	utils = new phoenix::Utils();
 	camera = new phoenix::Camera();
 }
@@ -323,7 +320,7 @@ void deletePointers()
 {
 	delete camera;
 	delete utils;
-	delete shadowMapRenderTarget;
+	phoenix::Framebuffer::releaseAcquired();
 	delete gBuffer;
 	delete blurRenderTarget;
 	delete shadowCommon;